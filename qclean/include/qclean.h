@@ -32,9 +32,101 @@
 
 #define VERSION "8.1.0"
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+enum TodoFlags {
+    TRAIL_WS_FLG  = (1 << 0), // clean Trailing Whitespace (always cleaned)
+    TAB_FLG       = (1 << 1), // clean TABs
+    CR_FLG        = (1 << 2), // clean CR (LF EOL convention)
+    LONG_LINE_FLG = (1 << 3), // find/found long lines
+    LF_FLG        = (1 << 4), // cleaned single LF (CRLF EOL convention)
+    ASCII_FLG     = (1 << 5), // clean non-ascii characters)
+};
+
+// FileType: the cleanup rule for the files with names ending with pattern
+typedef struct {
+    char     pattern[32]; // file extension or the end of the file name
+    uint8_t  len;         // length of the pattern
+    uint8_t  flags;       // TodoFlags to clean/check
+    uint16_t lineLimit;   // line limit (0 for the -l limit)
+    uint8_t  tabSize;     // TAB size (0 for the default TAB size)
+} FileType;
+
+// FileInfo: information about a file provided by the directory search
+typedef struct {
+    uint64_t size;  // file size [bytes]
+    int64_t  mtime; // time of the last modification [ns]
+    uint64_t inode; // file serial number (0 when not available)
+    int      ro;    // read-only: 1, writable: 0, not available: -1
+} FileInfo;
+
+// CacheEntry: the state of a clean file in the file-state cache
+typedef struct {
+    char    *path;      // full path of the file (the key)
+    FileInfo info;      // file information when the file was found clean
+    uint64_t hash;      // content hash (0 when the timestamp suffices)
+    unsigned flags;     // flags used to check the file
+    int      lineLimit; // line limit used to check the file
+    int      tabSize;   // TAB size used to check the file
+} CacheEntry;
+
+// Worker: the context of a thread cleaning files. Each thread owns
+// one Worker, so that onMatchFound() can be called concurrently.
+typedef struct {
+    uint8_t *src_buf;  // input chunk (for files that cannot be mapped)
+    uint8_t *dst_buf;  // output chunk of the cleaned file
+
+    CacheEntry *cache;   // new cache entries found by this worker
+    size_t      nCache;  // number of entries in cache[]
+    size_t      capCache;// capacity of cache[]
+
+    // counters of this worker, see Worker_dtor()
+    int nFiles;
+    int nReadOnly;
+    int nCleaned;
+    int nDirty;
+} Worker;
+
+void     Worker_ctor (Worker * const me);
+void     Worker_dtor (Worker * const me); // adds counters to the totals
+
+// returns the TodoFlags of the matching file type in the lower 8 bits and
+// the index of its rule above (see Rules_get()), or 0 for no match
 unsigned isMatching  (char const *fullPath);
-void     onMatchFound(char const *fullPath, unsigned flags, int ro_info);
-void     filesearch  (char const *dirname);
+void     onMatchFound(Worker * const me, char const *fullPath,
+                      unsigned flags, FileInfo const *info);
+
+// file-type rules compiled into the matcher (see rules.c)
+bool              Rules_compile(FileType const *types, size_t nTypes);
+bool              Rules_load   (char const *rulesFile);
+int               Rules_match  (char const *fname); // rule index or -1
+FileType const   *Rules_get    (int rule);
+
+// file-state cache for incremental runs (see cache.c)
+bool              Cache_load   (char const *cacheFile, int64_t now);
+CacheEntry const *Cache_find   (char const *fullPath);
+bool              Cache_isRacy (int64_t mtime);
+void              Cache_store  (Worker * const me, CacheEntry const *e);
+void              Cache_collect(Worker * const me);
+bool              Cache_save   (char const *cacheFile);
+uint64_t          Cache_hash   (uint8_t const *data, size_t size);
+
+// map the whole file for reading (platform-dependent)
+// returns NULL if the file cannot be mapped
+uint8_t const *mapFile(char const *fullPath, size_t *size);
+void           unmapFile(uint8_t const *data, size_t size);
+
+// atomically replace the file fullPath with the file tmpPath, which
+// takes over the permissions of the original (platform-dependent)
+bool           replaceFile(char const *tmpPath, char const *fullPath);
+
+// recursive search of the dirname directory, which calls onMatchFound()
+// for all matching files from the nThreads threads (0 means one thread
+// per CPU). NOTE: not all platforms support multi-threaded search. The
+// current directory of the caller is preserved.
+void     filesearch  (char const *dirname, unsigned nThreads);
 
 extern char const dir_separator; // platform-dependent directory separator
 
@@ -0,0 +1,287 @@
+//============================================================================
+// QClean white space cleanup host utility
+//
+//                   Q u a n t u m  L e a P s
+//                   ------------------------
+//                   Modern Embedded Software
+//
+// Copyright (C) 2005 Quantum Leaps, LLC. <state-machine.com>
+//
+// SPDX-License-Identifier: GPL-3.0-or-later OR LicenseRef-QL-commercial
+//
+// This software is dual-licensed under the terms of the open source GNU
+// General Public License version 3 (or any later version), or alternatively,
+// under the terms of one of the closed source Quantum Leaps commercial
+// licenses.
+//
+// The terms of the open source GNU General Public License version 3
+// can be found at: <www.gnu.org/licenses/gpl-3.0>
+//
+// The terms of the closed source Quantum Leaps commercial licenses
+// can be found at: <www.state-machine.com/licensing>
+//
+// Redistributions in source code must retain this top-level comment block.
+// Plagiarizing this software to sidestep the license obligations is illegal.
+//
+// Contact information:
+// <www.state-machine.com>
+// <info@state-machine.com>
+//============================================================================
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "safe_std.h" // "safe" <stdio.h> and <string.h> facilities
+#include "qclean.h"
+
+// The file-state cache remembers the files found clean in the previous run,
+// so that an incremental run (-i option) can skip the unchanged files
+// without reading them. The cache is a text file with one line per file:
+//
+// <size> <mtime> <inode> <hash> <flags> <line-limit> <tab-size> <full-path>
+//
+// A file is considered unchanged when its size, modification time and
+// inode match the cache entry. However, a file modified shortly before the
+// cache was written might have been modified again within the resolution
+// of the file timestamps ("racy" file). For such files the cache also
+// stores the content hash, which is verified instead of the timestamp.
+
+#define CACHE_MAGIC "QClean-cache 2"
+
+enum {
+    RACY_TIME = 2 // [s] timestamps closer to the run start are "racy"
+};
+
+static char       *l_text;      // text of the loaded cache file
+static CacheEntry *l_old;       // entries loaded from the cache file
+static size_t      l_nOld;
+static size_t     *l_index;     // open-addressing index into l_old[] (+1)
+static size_t      l_indexMask; // size of l_index[] - 1 (power of 2)
+static int64_t     l_now;       // start time of this run [ns]
+
+static CacheEntry *l_new;       // entries for the new cache file
+static size_t      l_nNew;
+static size_t      l_capNew;
+
+//............................................................................
+static uint64_t hashPath(char const *path) {
+    uint64_t h = 0xCBF29CE484222325ULL; // FNV-1a
+    for (; *path != '\0'; ++path) {
+        h = (h ^ (uint8_t)*path) * 0x100000001B3ULL;
+    }
+    return h;
+}
+//............................................................................
+uint64_t Cache_hash(uint8_t const *data, size_t size) {
+    // FNV-1a variant processing 8 bytes at a time
+    uint64_t h = 0xCBF29CE484222325ULL ^ (uint64_t)size;
+    for (; size >= 8U; size -= 8U, data += 8) {
+        uint64_t w;
+        memcpy(&w, data, sizeof(w)); // unaligned load
+        h = (h ^ w) * 0x100000001B3ULL;
+        h ^= (h >> 29);
+    }
+    for (; size > 0U; --size, ++data) {
+        h = (h ^ *data) * 0x100000001B3ULL;
+    }
+    return (h != 0U) ? h : 1U; // 0 is reserved for "no hash"
+}
+//............................................................................
+bool Cache_isRacy(int64_t mtime) {
+    return mtime + (int64_t)RACY_TIME * 1000000000LL >= l_now;
+}
+//............................................................................
+// parse one cache line (zero-terminated), returns false if corrupted
+static bool parseEntry(char *line, CacheEntry * const e) {
+    char *end;
+    e->info.size  = strtoull(line, &end, 10);
+    if (*end != ' ') { return false; }
+    e->info.mtime = strtoll(end + 1, &end, 10);
+    if (*end != ' ') { return false; }
+    e->info.inode = strtoull(end + 1, &end, 10);
+    if (*end != ' ') { return false; }
+    e->hash       = strtoull(end + 1, &end, 16);
+    if (*end != ' ') { return false; }
+    e->flags      = (unsigned)strtoul(end + 1, &end, 10);
+    if (*end != ' ') { return false; }
+    e->lineLimit  = (int)strtol(end + 1, &end, 10);
+    if (*end != ' ') { return false; }
+    e->tabSize    = (int)strtol(end + 1, &end, 10);
+    if ((*end != ' ') || (end[1] == '\0')) { return false; }
+    e->info.ro    = -1;
+    e->path       = end + 1;
+    return true;
+}
+//............................................................................
+bool Cache_load(char const *cacheFile, int64_t now) {
+    l_now = now;
+
+    FILE *f;
+    FOPEN_S(f, cacheFile, "rb");
+    if (f == (FILE *)0) { // no cache yet?
+        return false;
+    }
+    long fsize = -1;
+    if (fseek(f, 0L, SEEK_END) == 0) {
+        fsize = ftell(f);
+        rewind(f);
+    }
+    if (fsize <= 0) {
+        fclose(f);
+        return false;
+    }
+    l_text = (char *)malloc((size_t)fsize + 1U);
+    if (l_text == (char *)0) {
+        fclose(f);
+        return false;
+    }
+    size_t const len = FREAD_S(l_text, (size_t)fsize + 1U,
+                               1U, (size_t)fsize, f);
+    fclose(f);
+    l_text[len] = '\0';
+
+    // count the lines to size the arrays...
+    size_t nLines = 0U;
+    for (char const *p = l_text; (p = strchr(p, '\n')) != 0; ++p) {
+        ++nLines;
+    }
+    size_t nIndex = 16U;
+    while (nIndex < 2U * nLines) {
+        nIndex *= 2U;
+    }
+    l_old   = (CacheEntry *)malloc((nLines + 1U) * sizeof(CacheEntry));
+    l_index = (size_t *)calloc(nIndex, sizeof(size_t));
+    if ((l_old == (CacheEntry *)0) || (l_index == (size_t *)0)) {
+        return false;
+    }
+    l_indexMask = nIndex - 1U;
+
+    char *line = l_text;
+    char *eol  = strchr(line, '\n');
+    if ((eol == (char *)0)
+        || (strncmp(line, CACHE_MAGIC "\n", eol - line + 1) != 0))
+    {
+        PRINTF_S("%s: unknown format (ignored)\n", cacheFile);
+        return false;
+    }
+    for (line = eol + 1; (eol = strchr(line, '\n')) != 0; line = eol + 1) {
+        *eol = '\0';
+        CacheEntry * const e = &l_old[l_nOld];
+        if (!parseEntry(line, e)) {
+            PRINTF_S("%s: corrupted entry (ignored)\n", cacheFile);
+            continue;
+        }
+        size_t i = (size_t)hashPath(e->path) & l_indexMask;
+        while (l_index[i] != 0U) { // linear probing
+            i = (i + 1U) & l_indexMask;
+        }
+        l_index[i] = ++l_nOld;
+    }
+    return true;
+}
+//............................................................................
+CacheEntry const *Cache_find(char const *fullPath) {
+    if (l_nOld == 0U) {
+        return (CacheEntry const *)0;
+    }
+    size_t i = (size_t)hashPath(fullPath) & l_indexMask;
+    for (; l_index[i] != 0U; i = (i + 1U) & l_indexMask) {
+        CacheEntry const * const e = &l_old[l_index[i] - 1U];
+        if (strcmp(e->path, fullPath) == 0) {
+            return e;
+        }
+    }
+    return (CacheEntry const *)0;
+}
+//............................................................................
+// NOTE: called concurrently by the workers, each with its own entries
+void Cache_store(Worker * const me, CacheEntry const *e) {
+    if (strchr(e->path, '\n') != (char *)0) { // can't be stored in a line?
+        return;
+    }
+    if (me->nCache == me->capCache) {
+        size_t const cap = (me->capCache != 0U) ? 2U * me->capCache : 256U;
+        CacheEntry *cache = (CacheEntry *)realloc(me->cache,
+                                                  cap * sizeof(CacheEntry));
+        if (cache == (CacheEntry *)0) {
+            return; // the file will be checked again in the next run
+        }
+        me->cache    = cache;
+        me->capCache = cap;
+    }
+    CacheEntry * const n = &me->cache[me->nCache];
+    *n = *e;
+    n->path = strdup(e->path);
+    if (n->path != (char *)0) {
+        ++me->nCache;
+    }
+}
+//............................................................................
+// NOTE: called for each worker from a single thread (see Worker_dtor())
+void Cache_collect(Worker * const me) {
+    if (me->nCache != 0U) {
+        if (l_nNew + me->nCache > l_capNew) {
+            size_t cap = (l_capNew != 0U) ? l_capNew : 256U;
+            while (cap < l_nNew + me->nCache) {
+                cap *= 2U;
+            }
+            CacheEntry *cache = (CacheEntry *)realloc(l_new,
+                                                  cap * sizeof(CacheEntry));
+            if (cache == (CacheEntry *)0) {
+                for (size_t i = 0U; i < me->nCache; ++i) {
+                    free(me->cache[i].path);
+                }
+                me->nCache = 0U;
+            }
+            else {
+                l_new    = cache;
+                l_capNew = cap;
+            }
+        }
+        memcpy(&l_new[l_nNew], me->cache, me->nCache * sizeof(CacheEntry));
+        l_nNew += me->nCache;
+    }
+    free(me->cache);
+    me->cache    = (CacheEntry *)0;
+    me->nCache   = 0U;
+    me->capCache = 0U;
+}
+//............................................................................
+bool Cache_save(char const *cacheFile) {
+    char tmpName[FILENAME_MAX + 16];
+    SNPRINTF_S(tmpName, sizeof(tmpName), "%s.qclean~", cacheFile);
+    FILE *f;
+    FOPEN_S(f, tmpName, "wb");
+    bool ok = (f != (FILE *)0);
+    if (ok) {
+        FPRINTF_S(f, "%s\n", CACHE_MAGIC);
+        for (size_t i = 0U; i < l_nNew; ++i) {
+            CacheEntry const * const e = &l_new[i];
+            FPRINTF_S(f, "%llu %lld %llu %llx %u %d %d %s\n",
+                      (unsigned long long)e->info.size,
+                      (long long)e->info.mtime,
+                      (unsigned long long)e->info.inode,
+                      (unsigned long long)e->hash,
+                      e->flags, e->lineLimit, e->tabSize, e->path);
+        }
+        ok = (fclose(f) == 0) && replaceFile(tmpName, cacheFile);
+        if (!ok) {
+            (void)remove(tmpName);
+        }
+    }
+
+    for (size_t i = 0U; i < l_nNew; ++i) {
+        free(l_new[i].path);
+    }
+    free(l_new);
+    l_new  = (CacheEntry *)0;
+    l_nNew = 0U;
+    free(l_old);
+    free(l_index);
+    free(l_text);
+    l_old  = (CacheEntry *)0;
+    l_index = (size_t *)0;
+    l_text = (char *)0;
+    l_nOld = 0U;
+    return ok;
+}
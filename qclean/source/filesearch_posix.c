@@ -29,52 +29,451 @@
 //============================================================================
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 
+#include "safe_std.h" // "safe" <stdio.h> and <string.h> facilities
 #include "qclean.h"
 
-void filesearch(char const *dname) {
-    struct dirent *dent;
-    DIR *dir;
+// modification time of a file [ns]
+#ifdef __APPLE__
+#define ST_MTIME_NS(st_) (((int64_t)(st_).st_mtimespec.tv_sec * 1000000000LL) \
+                          + (int64_t)(st_).st_mtimespec.tv_nsec)
+#else
+#define ST_MTIME_NS(st_) (((int64_t)(st_).st_mtim.tv_sec * 1000000000LL) \
+                          + (int64_t)(st_).st_mtim.tv_nsec)
+#endif
+
+enum {
+    // files up to this size are read rather than mapped, because for small
+    // files mmap()/munmap() cost more than read()
+    MAP_SIZE_MIN = 64*1024
+};
+
+typedef enum { ENTRY_OTHER, ENTRY_DIR, ENTRY_FILE } EntryKind;
+
+static uid_t l_euid; // effective user ID of this process
+
+//............................................................................
+// the kind of a directory entry, preferably from d_type (no system call)
+static EntryKind entryKind(int dfd, struct dirent const *dent) {
+#ifdef DT_UNKNOWN
+    switch (dent->d_type) {
+        case DT_DIR: return ENTRY_DIR;
+        case DT_REG: return ENTRY_FILE;
+        case DT_UNKNOWN: break; // d_type not supported by the file system
+        default: return ENTRY_OTHER; // symlinks (not followed), etc.
+    }
+#endif
     struct stat st;
-    char fn[FILENAME_MAX];
-    int len = strlen(dname);
-    if (len >= FILENAME_MAX - 1) {
-        return;
+    if (fstatat(dfd, dent->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        return ENTRY_OTHER;
+    }
+    if (S_ISDIR(st.st_mode)) { // false for symlinked dirs
+        return ENTRY_DIR;
+    }
+    return S_ISREG(st.st_mode) ? ENTRY_FILE : ENTRY_OTHER;
+}
+//............................................................................
+// file information of the file name in the directory dfd, including the
+// read-only info, which is derived from the file status whenever possible
+static bool getFileInfo(FileInfo * const info, int dfd, char const *name) {
+    struct stat st;
+    if (fstatat(dfd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        return false;
+    }
+    info->size  = (uint64_t)st.st_size;
+    info->mtime = ST_MTIME_NS(st);
+    info->inode = (uint64_t)st.st_ino;
+    if (l_euid == 0) { // superuser can write any file
+        info->ro = 0;
+    }
+    else if (st.st_uid == l_euid) { // owner? only owner permissions apply
+        info->ro = ((st.st_mode & S_IWUSR) != 0) ? 0 : 1;
+    }
+    else { // group/other permissions or ACLs, let the system decide
+        info->ro = (faccessat(dfd, name, W_OK, AT_EACCESS) == 0) ? 0 : 1;
+    }
+    return true;
+}
+
+//............................................................................
+uint8_t const *mapFile(char const *fname, size_t *size) {
+    static uint8_t const empty[1] = { 0U };
+    int const fd = open(fname, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return (uint8_t const *)0;
+    }
+    struct stat st;
+    void *data = MAP_FAILED;
+    if (fstat(fd, &st) == 0) {
+        *size = (size_t)st.st_size;
+        if (*size == 0U) { // empty file cannot be mapped
+            data = (void *)empty;
+        }
+        else if (*size <= MAP_SIZE_MIN) { // small file? read it
+            data = malloc(*size);
+            size_t n = 0U;
+            while ((data != (void *)0) && (n < *size)) {
+                ssize_t const r = read(fd, (uint8_t *)data + n, *size - n);
+                if (r <= 0) { // error or file truncated in the meantime?
+                    free(data);
+                    data = (void *)0;
+                }
+                else {
+                    n += (size_t)r;
+                }
+            }
+            if (data == (void *)0) {
+                data = MAP_FAILED;
+            }
+        }
+        else {
+            data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+    }
+    close(fd); // the mapping stays valid after closing the file
+    return (data != MAP_FAILED) ? (uint8_t const *)data : (uint8_t const *)0;
+}
+//............................................................................
+void unmapFile(uint8_t const *data, size_t size) {
+    if (size == 0U) {
+        // nothing to release
     }
+    else if (size <= MAP_SIZE_MIN) {
+        free((void *)data);
+    }
+    else {
+        munmap((void *)data, size);
+    }
+}
+
+//............................................................................
+bool replaceFile(char const *tmpPath, char const *fname) {
+    struct stat st;
+    if (stat(fname, &st) == 0) {
+        (void)chmod(tmpPath, st.st_mode & 07777);
+    }
+    return rename(tmpPath, fname) == 0;
+}
 
-    strcpy(fn, dname);
-    fn[len++] = '/';
-    if ((dir = opendir(dname)) == NULL) {
+//............................................................................
+// single-threaded recursive search of the directory dfd, which has the
+// path[0..len). All entries are accessed relative to dfd and the path
+// of each entry is appended to the path[] buffer in place.
+static void filesearch_seq(Worker * const worker, int dfd,
+                           char *path, size_t len)
+{
+    DIR * const dir = fdopendir(dfd);
+    if (dir == NULL) {
+        close(dfd);
         return;
     }
 
+    struct dirent *dent;
+    path[len] = '/';
     while ((dent = readdir(dir)) != NULL) {
-        if ((dent->d_name[0] != '.')
-             && (strcmp(dent->d_name, ".") != 0)
-             && (strcmp(dent->d_name, "..") != 0))
+        if (dent->d_name[0] == '.') { // hidden file/dir or "." or ".."?
+            continue;
+        }
+        size_t const nlen = strlen(dent->d_name);
+        if (len + 1U + nlen >= FILENAME_MAX) {
+            continue;
+        }
+        memcpy(&path[len + 1U], dent->d_name, nlen + 1U);
+
+        EntryKind const kind = entryKind(dfd, dent);
+        if (kind == ENTRY_DIR) {
+            int const sub = openat(dfd, dent->d_name,
+                                   O_RDONLY | O_DIRECTORY | O_NOFOLLOW
+                                   | O_CLOEXEC);
+            if (sub != -1) {
+                // recursively follow dirs
+                filesearch_seq(worker, sub, path, len + 1U + nlen);
+            }
+        }
+        else if (kind == ENTRY_FILE) {
+            unsigned const flags = isMatching(dent->d_name);
+            FileInfo info;
+            if (((flags & 0xFFU) != 0U)
+                && getFileInfo(&info, dfd, dent->d_name))
+            {
+                onMatchFound(worker, path, flags, &info);
+            }
+        }
+    }
+
+    closedir(dir); // closes also dfd
+}
+
+//............................................................................
+// Multi-threaded search with work stealing.
+//
+// Each thread owns a WorkQueue (double-ended queue) of tasks, where a task
+// is either a directory to search or a matching file to clean. The owner
+// pushes and pops tasks at the tail of its queue (depth-first, which keeps
+// the working set small), while an idle thread steals tasks from the head
+// of the other queues (the oldest tasks, typically the largest subtrees).
+// The search is finished when no task is queued or being processed.
+//
+typedef struct {
+    char    *path;  // full path (malloc'ed)
+    unsigned flags; // 0 for a directory, isMatching() flags for a file
+    FileInfo info;  // file information (files only)
+} Task;
+
+typedef struct {
+    pthread_mutex_t lock; // protects the queue of tasks
+    Task    *tasks;       // circular buffer of tasks (grows on demand)
+    size_t   cap;         // capacity of tasks[] (power of 2)
+    size_t   head;        // index of the oldest task (stolen first)
+    size_t   len;         // number of queued tasks
+    Worker   worker;      // the file-cleaning context of the thread
+    pthread_t thread;
+} WorkQueue;
+
+static WorkQueue *l_queues;
+static unsigned   l_nQueues;
+static atomic_size_t   l_pending; // tasks queued or being processed
+static atomic_uint     l_nIdle;   // threads waiting for tasks
+static pthread_mutex_t l_idleLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  l_idleCond = PTHREAD_COND_INITIALIZER;
+
+//............................................................................
+static void WorkQueue_push(WorkQueue * const me, char *path, unsigned flags,
+                           FileInfo const *info)
+{
+    atomic_fetch_add(&l_pending, 1U);
+
+    pthread_mutex_lock(&me->lock);
+    if (me->len == me->cap) { // queue full?
+        size_t const cap = (me->cap != 0U) ? 2U * me->cap : 256U;
+        Task *tasks = (Task *)malloc(cap * sizeof(Task));
+        if (tasks == (Task *)0) {
+            pthread_mutex_unlock(&me->lock);
+            PRINTF_S("\n%s(out of memory -- skipped)\n", path);
+            free(path);
+            atomic_fetch_sub(&l_pending, 1U);
+            return;
+        }
+        for (size_t i = 0U; i < me->len; ++i) { // unwrap the old tasks
+            tasks[i] = me->tasks[(me->head + i) & (me->cap - 1U)];
+        }
+        free(me->tasks);
+        me->tasks = tasks;
+        me->cap   = cap;
+        me->head  = 0U;
+    }
+    Task * const t = &me->tasks[(me->head + me->len) & (me->cap - 1U)];
+    t->path  = path;
+    t->flags = flags;
+    if (info != (FileInfo const *)0) {
+        t->info = *info;
+    }
+    ++me->len;
+    pthread_mutex_unlock(&me->lock);
+
+    if (atomic_load(&l_nIdle) != 0U) { // any threads waiting for tasks?
+        pthread_mutex_lock(&l_idleLock);
+        pthread_cond_signal(&l_idleCond);
+        pthread_mutex_unlock(&l_idleLock);
+    }
+}
+//............................................................................
+// take the newest task (owner) or the oldest task (thief)
+static bool WorkQueue_take(WorkQueue * const me, Task * const t,
+                           bool isOwner)
+{
+    bool taken = false;
+    pthread_mutex_lock(&me->lock);
+    if (me->len != 0U) {
+        if (isOwner) {
+            *t = me->tasks[(me->head + me->len - 1U) & (me->cap - 1U)];
+        }
+        else {
+            *t = me->tasks[me->head];
+            me->head = (me->head + 1U) & (me->cap - 1U);
+        }
+        --me->len;
+        taken = true;
+    }
+    pthread_mutex_unlock(&me->lock);
+    return taken;
+}
+//............................................................................
+static bool findTask(WorkQueue * const me, Task * const t) {
+    if (WorkQueue_take(me, t, true)) {
+        return true;
+    }
+    unsigned const self = (unsigned)(me - l_queues);
+    for (unsigned i = 1U; i < l_nQueues; ++i) { // try to steal a task
+        if (WorkQueue_take(&l_queues[(self + i) % l_nQueues], t, false)) {
+            return true;
+        }
+    }
+    return false;
+}
+//............................................................................
+static void searchDir(WorkQueue * const me, char const *dname) {
+    int const dfd = open(dname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dfd == -1) {
+        return;
+    }
+    DIR * const dir = fdopendir(dfd);
+    if (dir == NULL) {
+        close(dfd);
+        return;
+    }
+    size_t const len = strlen(dname);
+    struct dirent *dent;
+    while ((dent = readdir(dir)) != NULL) {
+        if (dent->d_name[0] == '.') { // hidden file/dir or "." or ".."?
+            continue;
+        }
+        size_t const nlen = strlen(dent->d_name);
+        if (len + 1U + nlen >= FILENAME_MAX) {
+            continue;
+        }
+
+        EntryKind const kind = entryKind(dfd, dent);
+        unsigned flags = 0U;
+        FileInfo info;
+        if (kind == ENTRY_DIR) {
+        }
+        else if ((kind == ENTRY_FILE)
+                 && (((flags = isMatching(dent->d_name)) & 0xFFU) != 0U)
+                 && getFileInfo(&info, dfd, dent->d_name))
         {
-            strncpy(fn + len, dent->d_name, FILENAME_MAX - len);
-            if (lstat(fn, &st) != -1) {
-                /* don't follow symlink unless told so */
-                if (S_ISLNK(st.st_mode)) {
-                }
-                else if (S_ISDIR(st.st_mode)) { /* false for symlinked dirs */
-                    filesearch(fn); /* recursively follow dirs */
-                }
-                else {
-                    int flags = isMatching(dent->d_name);
-                    if ((flags & 0xFF) != 0) {
-                        onMatchFound(fn, flags, -1); /* no read-only info */
-                    }
-                }
+        }
+        else {
+            continue; // not interesting
+        }
+
+        char * const fn = (char *)malloc(len + 1U + nlen + 1U);
+        if (fn == (char *)0) {
+            continue;
+        }
+        memcpy(fn, dname, len);
+        fn[len] = '/';
+        memcpy(&fn[len + 1U], dent->d_name, nlen + 1U);
+        // NOTE: the task takes over the ownership of the path
+        WorkQueue_push(me, fn, flags,
+                       (kind == ENTRY_DIR) ? (FileInfo const *)0 : &info);
+    }
+    closedir(dir); // closes also dfd
+}
+//............................................................................
+static void *searchThread(void *arg) {
+    WorkQueue * const me = (WorkQueue *)arg;
+    for (;;) {
+        Task t;
+        if (findTask(me, &t)) {
+            if (t.flags == 0U) {
+                searchDir(me, t.path);
+            }
+            else {
+                onMatchFound(&me->worker, t.path, t.flags, &t.info);
+            }
+            free(t.path);
+            if (atomic_fetch_sub(&l_pending, 1U) == 1U) { // last task?
+                pthread_mutex_lock(&l_idleLock);
+                pthread_cond_broadcast(&l_idleCond); // wake up everybody
+                pthread_mutex_unlock(&l_idleLock);
             }
+            continue;
+        }
+
+        // no task found, wait for more tasks or for the end of search...
+        pthread_mutex_lock(&l_idleLock);
+        atomic_fetch_add(&l_nIdle, 1U);
+        bool hasTasks = false;
+        for (unsigned i = 0U; (i < l_nQueues) && !hasTasks; ++i) {
+            pthread_mutex_lock(&l_queues[i].lock);
+            hasTasks = (l_queues[i].len != 0U);
+            pthread_mutex_unlock(&l_queues[i].lock);
+        }
+        bool const done = (atomic_load(&l_pending) == 0U);
+        if (!hasTasks && !done) {
+            pthread_cond_wait(&l_idleCond, &l_idleLock);
+        }
+        atomic_fetch_sub(&l_nIdle, 1U);
+        pthread_mutex_unlock(&l_idleLock);
+        if (done) {
+            break;
+        }
+    }
+    return (void *)0;
+}
+
+//............................................................................
+void filesearch(char const *dname, unsigned nThreads) {
+    l_euid = geteuid();
+    if (nThreads == 0U) { // one thread per CPU?
+        long const nCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+        nThreads = (nCPUs > 0) ? (unsigned)nCPUs : 1U;
+    }
+
+    if (nThreads == 1U) {
+        char path[FILENAME_MAX];
+        size_t const len = strlen(dname);
+        int const dfd = open(dname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if ((len < FILENAME_MAX - 1U) && (dfd != -1)) {
+            Worker worker;
+            Worker_ctor(&worker);
+            memcpy(path, dname, len + 1U);
+            filesearch_seq(&worker, dfd, path, len);
+            Worker_dtor(&worker);
         }
+        else if (dfd != -1) {
+            close(dfd);
+        }
+        return;
+    }
+
+    l_queues = (WorkQueue *)calloc(nThreads, sizeof(WorkQueue));
+    if (l_queues == (WorkQueue *)0) {
+        PRINTF_S("\n%s\n", "Error: out of memory!");
+        return;
+    }
+    l_nQueues = nThreads;
+    for (unsigned i = 0U; i < nThreads; ++i) {
+        pthread_mutex_init(&l_queues[i].lock, NULL);
+        Worker_ctor(&l_queues[i].worker);
+    }
+
+    char *root = strdup(dname);
+    if (root != (char *)0) {
+        WorkQueue_push(&l_queues[0], root, 0U, (FileInfo const *)0);
     }
 
-    closedir(dir);
+    unsigned nStarted = 1U; // the calling thread serves l_queues[0]
+    for (; nStarted < nThreads; ++nStarted) {
+        if (pthread_create(&l_queues[nStarted].thread, NULL,
+                           &searchThread, &l_queues[nStarted]) != 0)
+        {
+            break; // continue with the threads started so far
+        }
+    }
+    searchThread(&l_queues[0]);
+    for (unsigned i = 1U; i < nStarted; ++i) {
+        pthread_join(l_queues[i].thread, NULL);
+    }
+
+    // add the worker counters to the totals in a fixed order
+    for (unsigned i = 0U; i < nThreads; ++i) {
+        Worker_dtor(&l_queues[i].worker);
+        free(l_queues[i].tasks);
+        pthread_mutex_destroy(&l_queues[i].lock);
+    }
+    free(l_queues);
+    l_queues  = (WorkQueue *)0;
+    l_nQueues = 0U;
 }
@@ -42,11 +42,64 @@
 char const dir_separator = '\\'; /* platform-dependent directory separator */
 
 /*..........................................................................*/
-void filesearch(char const *dirname) {
+uint8_t const *mapFile(char const *fname, size_t *size) {
+    static uint8_t const empty[1] = { 0U };
+    HANDLE const hFile = CreateFileA(fname, GENERIC_READ, FILE_SHARE_READ,
+                                     NULL, OPEN_EXISTING,
+                                     FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return (uint8_t const *)0;
+    }
+    uint8_t const *data = (uint8_t const *)0;
+    LARGE_INTEGER fsize;
+    if (GetFileSizeEx(hFile, &fsize)) {
+        *size = (size_t)fsize.QuadPart;
+        if (*size == 0U) { /* empty file cannot be mapped */
+            data = empty;
+        }
+        else {
+            HANDLE const hMap = CreateFileMappingA(hFile, NULL,
+                                    PAGE_READONLY, 0, 0, NULL);
+            if (hMap != NULL) {
+                data = (uint8_t const *)MapViewOfFile(hMap, FILE_MAP_READ,
+                                                      0, 0, 0);
+                CloseHandle(hMap); /* the view keeps the mapping alive */
+            }
+        }
+    }
+    CloseHandle(hFile);
+    return data;
+}
+/*..........................................................................*/
+void unmapFile(uint8_t const *data, size_t size) {
+    if (size != 0U) {
+        UnmapViewOfFile(data);
+    }
+}
+
+/*..........................................................................*/
+bool replaceFile(char const *tmpPath, char const *fname) {
+    return MoveFileExA(tmpPath, fname,
+               MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+/*..........................................................................*/
+static void getFileInfo(FileInfo * const info,
+                        struct _finddata_t const *fdata)
+{
+    info->size  = (uint64_t)fdata->size;
+    info->mtime = (int64_t)fdata->time_write * 1000000000LL;
+    info->inode = 0U; /* not available */
+    info->ro    = ((fdata->attrib & _A_RDONLY) != 0) ? 1 : 0;
+}
+
+/*..........................................................................*/
+static void filesearch_seq(Worker * const worker, char const *dirname) {
     static char buffer[1024];
     struct _finddata_t fdata;
     intptr_t hnd;
     unsigned flags;
+    FileInfo info;
 
     _chdir(dirname);
     hnd = _findfirst("*", &fdata);  /* set _findfirst to find everything */
@@ -59,7 +112,7 @@ void filesearch(char const *dirname) {
     {
         /* change to that directory and recursively call filesearch */
         if (*fdata.name != '.') {
-            filesearch(fdata.name); /* call itself recursively */
+            filesearch_seq(worker, fdata.name); /* call itself recursively */
             _chdir(".."); /* go back up one directory level */
         }
     }
@@ -70,8 +123,8 @@ void filesearch(char const *dirname) {
             _getcwd(buffer,  sizeof(buffer));
             strcat_s(buffer, sizeof(buffer), "\\");
             strcat_s(buffer, sizeof(buffer), fdata.name);
-            onMatchFound(buffer, flags,
-                         (fdata.attrib & _A_RDONLY) != 0 ? 1 : 0);
+            getFileInfo(&info, &fdata);
+            onMatchFound(worker, buffer, flags, &info);
         }
     }
 
@@ -80,7 +133,7 @@ void filesearch(char const *dirname) {
             && (GetFileAttributes(fdata.name) & FILE_ATTRIBUTE_HIDDEN) == 0)
         {
             if (*fdata.name != '.') {
-                filesearch(fdata.name);
+                filesearch_seq(worker, fdata.name);
                 _chdir("..");
             }
         }
@@ -90,10 +143,27 @@ void filesearch(char const *dirname) {
                 _getcwd(buffer,  sizeof(buffer));
                 strcat_s(buffer, sizeof(buffer), "\\");
                 strcat_s(buffer, sizeof(buffer), fdata.name);
-                onMatchFound(buffer, flags,
-                             (fdata.attrib & _A_RDONLY) != 0 ? 1 : 0);
+                getFileInfo(&info, &fdata);
+                onMatchFound(worker, buffer, flags, &info);
             }
         }
     }
     _findclose(hnd);
 }
+
+/*..........................................................................*/
+void filesearch(char const *dirname, unsigned nThreads) {
+    /* NOTE: the search relies on the current directory (_chdir()),
+    * which is global to the process, so it is always single-threaded
+    */
+    (void)nThreads;
+    static char cwd[1024];
+    bool const haveCwd = (_getcwd(cwd, sizeof(cwd)) != (char *)0);
+    Worker worker;
+    Worker_ctor(&worker);
+    filesearch_seq(&worker, dirname);
+    Worker_dtor(&worker);
+    if (haveCwd) { /* restore the current directory for the caller */
+        _chdir(cwd);
+    }
+}
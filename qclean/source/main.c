@@ -30,6 +30,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <time.h>
 
 #include "safe_std.h" // "safe" <stdio.h> and <string.h> facilities
 #include "qclean.h"
@@ -43,88 +44,75 @@ static int  l_lineLimit  = 0;
 static bool l_noCleanup  = false; // perform cleanup by default
 static bool l_checkMode  = false; // return non-zero if dirty files are found
 static bool l_doReadOnly = false; // don't check read-only files by default
+static unsigned l_nThreads = 1U;  // single-threaded search by default
+static char const *l_cacheFile = (char const *)0; // no file-state cache
 
 enum Constants {
     TAB        = 0x09,
     LF         = 0x0A,
     CR         = 0x0D,
     TAB_SIZE   = 4,           // default TAB size
-    LINE_LIMIT = 80           // default line limit
+    LINE_LIMIT = 80,          // default line limit
+    CHUNK_SIZE = 64*1024      // size of chunks for the streaming cleanup
 };
 
-enum TodoFlags {
-    TRAIL_WS_FLG  = (1 << 0), // clean Trailing Whitespace (always cleaned)
-    TAB_FLG       = (1 << 1), // clean TABs
-    CR_FLG        = (1 << 2), // clean CR (LF EOL convention)
-    LONG_LINE_FLG = (1 << 3), // find/found long lines
-    LF_FLG        = (1 << 4), // cleaned single LF (CRLF EOL convention)
-    ASCII_FLG     = (1 << 5), // clean non-ascii characters)
-};
-
-typedef struct {
-    char pattern[32];
-    uint8_t len;
-    uint8_t flags;
-} FileType;
-
-// array of file types recognized by QClean...
-// NOTE: For greater flexibility, this array could be read from an external
-// config file in the future.
+// array of file types recognized by QClean by default...
+// NOTE: the array can be replaced with the rules from a file (-t option)
 static FileType const l_fileTypes[] = {
-    { ".c",       2, CR_FLG | TAB_FLG | LONG_LINE_FLG },
-    { ".h",       2, CR_FLG | TAB_FLG | LONG_LINE_FLG },
-    { ".cpp",     4, CR_FLG | TAB_FLG | LONG_LINE_FLG },
-    { ".hpp",     4, CR_FLG | TAB_FLG | LONG_LINE_FLG },
-    { ".s",       2, CR_FLG | TAB_FLG | LONG_LINE_FLG },
-    { ".S",       2, CR_FLG | TAB_FLG | LONG_LINE_FLG },
-    { ".asm",     4, CR_FLG | TAB_FLG | LONG_LINE_FLG },
-    { ".txt",     4, CR_FLG | TAB_FLG | ASCII_FLG     },
-    { ".xml",     4, CR_FLG | TAB_FLG                 },
-    { ".dox",     4, CR_FLG | TAB_FLG | ASCII_FLG     }, // Doxygen
-    { ".md",      3, CR_FLG | TAB_FLG                 }, // markdown
-    { ".bat",     4, CR_FLG | TAB_FLG | ASCII_FLG     },
-    { ".ld",      3, CR_FLG | TAB_FLG | LONG_LINE_FLG }, // GNU linker
-    { ".py",      3, CR_FLG | TAB_FLG | LONG_LINE_FLG },
-    { ".pyi",     4, CR_FLG | TAB_FLG | LONG_LINE_FLG },
-    { ".pyw",     4, CR_FLG | TAB_FLG | LONG_LINE_FLG },
-    { ".java",    5, CR_FLG | TAB_FLG | LONG_LINE_FLG },
-
-    { "Makefile", 8, CR_FLG           | LONG_LINE_FLG },
-    { "mak_",     4, CR_FLG           | LONG_LINE_FLG },
-    { ".mak",     4, CR_FLG           | LONG_LINE_FLG },
-    { ".make",    5, CR_FLG           | LONG_LINE_FLG },
-    { ".cmake",   6, CR_FLG           | TAB_FLG       },
-    { ".json",    5, CR_FLG           | TAB_FLG       },
-
-    { ".html",    5, CR_FLG | TAB_FLG                 },
-    { ".htm",     4, CR_FLG | TAB_FLG                 },
-    { ".css",     4, CR_FLG | TAB_FLG                 },
-
-    { ".eww",     4, CR_FLG                           }, // IAR workspace
-    { ".ewp",     4, CR_FLG                           }, // IAR project
-    { ".ewd",     4, CR_FLG                           }, // IAR debug config
-    { ".icf",     4, CR_FLG | TAB_FLG                 }, // IAR linker
-
-    { ".uvprojx", 8, CR_FLG                           }, // uVision project
-    { ".uvoptx",  7, CR_FLG                           }, // uVision option
-
-    { ".sln",     4, CR_FLG                           }, // VS solution
-    { ".vcxproj", 8, CR_FLG                           }, // VS project
-    { ".filters", 8, CR_FLG                           }, // VS sub-folders
-    { ".vcxproj.filters",16, CR_FLG                   }, // VS sub-folders
-
-    { ".project", 8, CR_FLG                           }, // Eclipse project
-    { ".cproject",9, CR_FLG                           }, // Eclipse CDT project
-
-    { ".sha1",    5, CR_FLG | TAB_FLG                 }, // Sha1 file
-    { ".pro",     4, CR_FLG | TAB_FLG                 }, // Qt project
-
-    { ".m",       2, CR_FLG | TAB_FLG | LONG_LINE_FLG }, // MATLAB
-
-    { ".lnt",     4, CR_FLG | TAB_FLG | LONG_LINE_FLG }, // lint
-    { ".cfg",     4, CR_FLG | TAB_FLG                 }, // RSM config
+    { ".c",       2, CR_FLG | TAB_FLG | LONG_LINE_FLG, 0, 0 },
+    { ".h",       2, CR_FLG | TAB_FLG | LONG_LINE_FLG, 0, 0 },
+    { ".cpp",     4, CR_FLG | TAB_FLG | LONG_LINE_FLG, 0, 0 },
+    { ".hpp",     4, CR_FLG | TAB_FLG | LONG_LINE_FLG, 0, 0 },
+    { ".s",       2, CR_FLG | TAB_FLG | LONG_LINE_FLG, 0, 0 },
+    { ".S",       2, CR_FLG | TAB_FLG | LONG_LINE_FLG, 0, 0 },
+    { ".asm",     4, CR_FLG | TAB_FLG | LONG_LINE_FLG, 0, 0 },
+    { ".txt",     4, CR_FLG | TAB_FLG | ASCII_FLG    , 0, 0 },
+    { ".xml",     4, CR_FLG | TAB_FLG                , 0, 0 },
+    { ".dox",     4, CR_FLG | TAB_FLG | ASCII_FLG    , 0, 0 }, // Doxygen
+    { ".md",      3, CR_FLG | TAB_FLG                , 0, 0 }, // markdown
+    { ".bat",     4, CR_FLG | TAB_FLG | ASCII_FLG    , 0, 0 },
+    { ".ld",      3, CR_FLG | TAB_FLG | LONG_LINE_FLG, 0, 0 }, // GNU linker
+    { ".py",      3, CR_FLG | TAB_FLG | LONG_LINE_FLG, 0, 0 },
+    { ".pyi",     4, CR_FLG | TAB_FLG | LONG_LINE_FLG, 0, 0 },
+    { ".pyw",     4, CR_FLG | TAB_FLG | LONG_LINE_FLG, 0, 0 },
+    { ".java",    5, CR_FLG | TAB_FLG | LONG_LINE_FLG, 0, 0 },
+
+    { "Makefile", 8, CR_FLG           | LONG_LINE_FLG, 0, 0 },
+    { "mak_",     4, CR_FLG           | LONG_LINE_FLG, 0, 0 },
+    { ".mak",     4, CR_FLG           | LONG_LINE_FLG, 0, 0 },
+    { ".make",    5, CR_FLG           | LONG_LINE_FLG, 0, 0 },
+    { ".cmake",   6, CR_FLG           | TAB_FLG      , 0, 0 },
+    { ".json",    5, CR_FLG           | TAB_FLG      , 0, 0 },
+
+    { ".html",    5, CR_FLG | TAB_FLG                , 0, 0 },
+    { ".htm",     4, CR_FLG | TAB_FLG                , 0, 0 },
+    { ".css",     4, CR_FLG | TAB_FLG                , 0, 0 },
+
+    { ".eww",     4, CR_FLG                          , 0, 0 }, // IAR workspace
+    { ".ewp",     4, CR_FLG                          , 0, 0 }, // IAR project
+    { ".ewd",     4, CR_FLG                          , 0, 0 }, // IAR debug cfg
+    { ".icf",     4, CR_FLG | TAB_FLG                , 0, 0 }, // IAR linker
+
+    { ".uvprojx", 8, CR_FLG                          , 0, 0 }, // uVision
+    { ".uvoptx",  7, CR_FLG                          , 0, 0 }, // uVision option
+
+    { ".sln",     4, CR_FLG                          , 0, 0 }, // VS solution
+    { ".vcxproj", 8, CR_FLG                          , 0, 0 }, // VS project
+    { ".filters", 8, CR_FLG                          , 0, 0 }, // VS sub-folders
+    { ".vcxproj.filters",16, CR_FLG                   , 0, 0 }, // VS filters
+
+    { ".project", 8, CR_FLG                          , 0, 0 }, // Eclipse
+    { ".cproject",9, CR_FLG                          , 0, 0 }, // Eclipse CDT
+
+    { ".sha1",    5, CR_FLG | TAB_FLG                , 0, 0 }, // Sha1 file
+    { ".pro",     4, CR_FLG | TAB_FLG                , 0, 0 }, // Qt project
+
+    { ".m",       2, CR_FLG | TAB_FLG | LONG_LINE_FLG, 0, 0 }, // MATLAB
+
+    { ".lnt",     4, CR_FLG | TAB_FLG | LONG_LINE_FLG, 0, 0 }, // lint
+    { ".cfg",     4, CR_FLG | TAB_FLG                , 0, 0 }, // RSM config
 };
-static int const l_fileNum = sizeof(l_fileTypes)/sizeof(l_fileTypes[0]);
+static size_t const l_fileNum = sizeof(l_fileTypes)/sizeof(l_fileTypes[0]);
 static const uint32_t ascii[256/32] = {
     0x00002600u, // TAB, LF, CR
     0xFFFFFFFFu, // ' '..'?'
@@ -135,205 +123,510 @@ static const uint32_t ascii[256/32] = {
     0x00000000u, // non ASCII
     0x00000000u, // non ASCII
 };
+#define CACHE_FILE ".qclean.cache" // default file-state cache (hidden file)
+#define RULES_FILE ".qclean.rules" // default file-type rules (hidden file)
+
 #define IS_ASCII(ch_) ((ascii[ch_ >> 5u] & (1u << (ch_ & 0x1Fu))) != 0u)
 
 //............................................................................
 // This function looks for a match between the fname and any of the file
-// types defined in the l_fileTypes array. If a match is found, the function
-// returns the flags associated with the matching file type. Otherwise
-// the function returns 0.
+// type rules (see rules.c). If a match is found, the function returns the
+// flags associated with the matching file type and the index of the rule.
+// Otherwise the function returns 0.
 unsigned isMatching(char const *fname) {
-    int const flen = (int)strlen(fname);
+    int const rule = Rules_match(fname);
+    if (rule < 0) {
+        return 0U;
+    }
+    unsigned flags = (unsigned)Rules_get(rule)->flags;
+    if (l_lineLimit == 0) {
+        flags &= ~LONG_LINE_FLG; // don't report long lines
+    }
+    return (flags != 0U) ? (flags | ((unsigned)rule << 8)) : 0U;
+}
+//............................................................................
+void Worker_ctor(Worker * const me) {
+    memset(me, 0, sizeof(*me));
+}
+//............................................................................
+void Worker_dtor(Worker * const me) {
+    // NOTE: called for each worker from a single thread after all workers
+    // have finished, so the totals don't depend on the thread scheduling
+    l_nFiles    += me->nFiles;
+    l_nReadOnly += me->nReadOnly;
+    l_nCleaned  += me->nCleaned;
+    l_nDirty    += me->nDirty;
+    Cache_collect(me);
+    free(me->src_buf);
+    free(me->dst_buf);
+    memset(me, 0, sizeof(*me));
+}
+//............................................................................
+// make sure that the worker has the buffers for the streaming cleanup
+static bool Worker_reserve(Worker * const me) {
+    if (me->dst_buf == (uint8_t *)0) {
+        me->dst_buf = (uint8_t *)malloc(CHUNK_SIZE);
+    }
+    if (me->src_buf == (uint8_t *)0) {
+        me->src_buf = (uint8_t *)malloc(CHUNK_SIZE);
+    }
+    return (me->dst_buf != (uint8_t *)0) && (me->src_buf != (uint8_t *)0);
+}
 
-    FileType const *ft = &l_fileTypes[0];
-    for (int n = l_fileNum; n > 0; --n, ++ft) { // go over all file types..
-        char const *s = &ft->pattern[0];
-        if (((*s == '.') && (flen > ft->len)) // extension
-            || (flen >= ft->len))             // beginning of file name
-        {
-            char const *t = &fname[flen - ft->len];
-            int i;
-            for (i = ft->len; i > 0; --i, ++s, ++t) { // compare to pattern
-                if (*s != *t) { // mismatch?
-                    break;
+//............................................................................
+// SWAR (SIMD within a register) helpers for scanning 8 bytes at a time
+#define SWAR_ONES   0x0101010101010101ULL
+#define SWAR_HIGHS  0x8080808080808080ULL
+// non-zero if any byte of x_ is zero
+#define SWAR_HAS_ZERO(x_)     (((x_) - SWAR_ONES) & ~(x_) & SWAR_HIGHS)
+// non-zero if any byte of x_ is equal to b_
+#define SWAR_HAS_BYTE(x_, b_) SWAR_HAS_ZERO((x_) ^ (SWAR_ONES * (b_)))
+// non-zero if any byte of x_ is less than n_ (n_ <= 128)
+#define SWAR_HAS_LESS(x_, n_) \
+    (((x_) - (SWAR_ONES * (n_))) & ~(x_) & SWAR_HIGHS)
+// NOTE: the macros might report false positives (but never false
+// negatives), so every hit must be confirmed byte-by-byte.
+
+// is the byte ch_ to be cleaned inside a line, according to flags_?
+#define IS_DIRTY(ch_, flags_) \
+    ((((ch_) == TAB) && (((flags_) & TAB_FLG) != 0u)) \
+     || (((ch_) == CR) && (((flags_) & CR_FLG) != 0u)) \
+     || ((((flags_) & ASCII_FLG) != 0u) && !IS_ASCII(ch_)))
+
+//............................................................................
+// Fast path for the (most common) files that don't need any cleanup.
+// Scans the buffer without copying it and returns true if the cleanup
+// would not change anything. In that case, *foundLLs tells whether the
+// file has long lines. When the function returns false, the buffer
+// must be processed by the cleanup (which also finds the long lines).
+static bool isClean(uint8_t const *buf, size_t nBytes, unsigned flags,
+                    size_t lineLimit, size_t tabSize, bool *foundLLs)
+{
+    uint64_t const tabMask   = ((flags & TAB_FLG)   != 0u) ? ~0ULL : 0ULL;
+    uint64_t const crMask    = ((flags & CR_FLG)    != 0u) ? ~0ULL : 0ULL;
+    uint64_t const asciiMask = ((flags & ASCII_FLG) != 0u) ? ~0ULL : 0ULL;
+    uint8_t const *line = buf;
+    uint8_t const *end  = &buf[nBytes];
+
+    *foundLLs = false;
+    while (line < end) {
+        uint8_t const *lf = (uint8_t const *)memchr(line, LF,
+                                                    (size_t)(end - line));
+        if (lf == (uint8_t const *)0) { // the last line without LF?
+            lf = end;
+        }
+        else {
+            uint8_t const last = (lf > buf) ? *(lf - 1) : 0x00;
+            if ((flags & CR_FLG) == 0u) { // CRLF convention?
+                if (last != CR) { // single LF?
+                    return false;
                 }
             }
-            if (i == 0) { // match found?
-                unsigned flags = (unsigned)ft->flags;
-                if (l_lineLimit == 0) {
-                    flags &= ~LONG_LINE_FLG; // don't report long lines
+            else if (last == ' ') { // trailing blank?
+                return false;
+            }
+        }
+
+        // scan the line 8 bytes at a time...
+        uint8_t const *p = line;
+        for (; p + 8 <= lf; p += 8) {
+            uint64_t w;
+            memcpy(&w, p, sizeof(w)); // unaligned load
+            uint64_t const hit = (tabMask & SWAR_HAS_BYTE(w, TAB))
+                | (crMask & SWAR_HAS_BYTE(w, CR))
+                | (asciiMask & ((w & SWAR_HIGHS)
+                                | SWAR_HAS_LESS(w, 0x20)
+                                | SWAR_HAS_BYTE(w, 0x7F)));
+            if (hit != 0U) { // possibly dirty? confirm byte-by-byte
+                for (int i = 0; i < 8; ++i) {
+                    if (IS_DIRTY(p[i], flags)) {
+                        return false;
+                    }
+                }
+            }
+        }
+        for (; p < lf; ++p) { // the remaining bytes of the line
+            if (IS_DIRTY(*p, flags)) {
+                return false;
+            }
+        }
+
+        if (((flags & LONG_LINE_FLG) != 0u) && (lf < end) && !*foundLLs) {
+            // NOTE: the length of a line counts each TAB as tabSize chars
+            size_t lineLen = (size_t)(lf - line);
+            if ((lineLen <= lineLimit)
+                && ((flags & TAB_FLG) == 0u) // TABs not cleaned?
+                && (lineLen * tabSize > lineLimit))
+            {
+                for (p = line;
+                     (p = (uint8_t const *)memchr(p, TAB,
+                                                  (size_t)(lf - p))) != 0;
+                     ++p)
+                {
+                    lineLen += tabSize - 1U;
                 }
-                return flags;
+            }
+            if (lineLen > lineLimit) {
+                *foundLLs = true;
             }
         }
+        line = lf + 1;
     }
-    return 0U;
+    return true;
 }
-//............................................................................
-void onMatchFound(char const *fname, unsigned flags, int ro_info) {
-    char prev = 0x00;
-    bool isReadOnly = false;
 
-    ++l_nFiles;
-    PRINTF_S("%c", '.');
+//............................................................................
+// Streaming cleanup, which processes the file in chunks of any size in
+// constant memory. All state needed to process a chunk (the previous byte,
+// the current line length and the blanks held back as potentially
+// trailing) is carried over the chunk boundaries in the Cleaner.
+typedef struct {
+    unsigned flags;    // flags of the file type
+    int      lineLimit;// line limit of the file type
+    int      tabSize;  // TAB size of the file type
+    unsigned found;    // found TodoFlags
+    bool     foundLLs; // found long lines
+    int      lineLen;  // length of the current line so far
+    uint8_t  prev;     // the previous source byte
+    size_t   nBlanks;  // blanks held back (trailing, unless followed by
+                       // a non-blank character in the current line)
+    FILE    *out;      // output file or NULL when not writing
+    uint8_t *buf;      // output buffer
+    size_t   len;      // number of bytes in buf[]
+    bool     error;    // output error
+} Cleaner;
 
-    FILE *f;
-    if (ro_info >= 0) { // read-only information available right away?
-        if (ro_info > 0) {
-            isReadOnly = true;
-            ++l_nReadOnly;
-        }
-    }
-    else { // read-only information not available
-        // open for reading/writing (non destructive)
-        FOPEN_S(f, fname, "r+");
-        if (f == (FILE*)0) { // can't write
-            isReadOnly = true;
-            ++l_nReadOnly;
-        }
-        else {
-            fclose(f);
+//............................................................................
+static void Cleaner_flush(Cleaner * const me) {
+    if ((me->out != (FILE *)0) && (me->len != 0U)) {
+        if (fwrite(me->buf, 1U, me->len, me->out) != me->len) {
+            me->error = true;
         }
     }
-    if (isReadOnly && !l_doReadOnly) {
-        return;
-    }
-
-    FOPEN_S(f, fname, "rb"); // open for reading
-    if (f == (FILE*)0) {
-        return;
+    me->len = 0U;
+}
+//............................................................................
+static inline void Cleaner_put(Cleaner * const me, uint8_t ch) {
+    if (me->len == CHUNK_SIZE) {
+        Cleaner_flush(me);
     }
-
-    static uint8_t src_buf[10*1024*1024]; // 10MB buffer
-    uint8_t *src = src_buf;
-    static uint8_t dst_buf[10*1024*1024]; // 10MB buffer
-    uint8_t *dst = dst_buf;
-    int nBytes = (int)FREAD_S(src_buf, sizeof(src_buf),
-                              1U, sizeof(src_buf), f);
-    fclose(f);
-    if (nBytes == sizeof(src_buf)) { // full buffer?
-        PRINTF_S("\n%s(too big -- skipped)\n", fname);
-        return;
+    me->buf[me->len++] = ch;
+}
+//............................................................................
+// output the blanks held back, because they turned out not to be trailing
+static void Cleaner_putBlanks(Cleaner * const me) {
+    for (; me->nBlanks > 0U; --me->nBlanks) {
+        Cleaner_put(me, ' ');
     }
-    unsigned found = 0;
-    bool foundLLs = false;
-    int lineCtr = 1;
-    int lineLen = 0;
-
+}
+//............................................................................
+static void Cleaner_chunk(Cleaner * const me,
+                          uint8_t const *src, size_t nBytes)
+{
+    unsigned const flags = me->flags;
     for (; nBytes > 0; --nBytes, ++src) {
         uint8_t ch = *src;
         switch (ch) {
             case TAB: {
                 if ((flags & TAB_FLG) != 0u) { // cleanup tabs?
-                    int tab;
-                    for (tab = TAB_SIZE; tab > 0; --tab) {
-                        *dst++ = ' ';
-                    }
-                    found |= TAB_FLG; // removed TAB
+                    me->nBlanks += (size_t)me->tabSize; // hold back blanks
+                    me->found |= TAB_FLG; // removed TAB
                 }
                 else {
-                    *dst++ = *src; // copy TAB over
+                    Cleaner_putBlanks(me);
+                    Cleaner_put(me, TAB); // copy TAB over
                 }
-                lineLen += 4;
+                me->lineLen += me->tabSize;
                 break;
             }
             case LF: {
                 if (((flags & LONG_LINE_FLG) != 0u)
-                    && (lineLen > l_lineLimit))
+                    && (me->lineLen > me->lineLimit))
                 {
-                    foundLLs = true;
+                    me->foundLLs = true;
                 }
-                lineLen = 0;
-                ++lineCtr;
+                me->lineLen = 0;
 
                 // always cleanup trailing blanks...
-                for (; (*(dst - 1) == ' ') && (dst > dst_buf); --dst) {
-                    found |= TRAIL_WS_FLG; // removed trailing blank
+                if (me->nBlanks != 0U) {
+                    me->nBlanks = 0U; // drop the blanks held back
+                    me->found |= TRAIL_WS_FLG; // removed trailing blank
                 }
 
                 if (((flags & CR_FLG) == 0u) // don't clean CRLF?
-                    && (prev != CR))  // CR NOT present?
+                    && (me->prev != CR))  // CR NOT present?
                 {
-                    *dst++ = CR;      // add CR to the stream
-                    found |= LF_FLG;  // cleaned up single LF
+                    Cleaner_put(me, CR);  // add CR to the stream
+                    me->found |= LF_FLG;  // cleaned up single LF
                 }
-                *dst++ = LF;          // copy LF over
+                Cleaner_put(me, LF);      // copy LF over
                 break;
             }
             case CR: {
                 if ((flags & CR_FLG) != 0u) { // clean CR?
                     // don't copy CR over
-                    found |= CR_FLG;
+                    me->found |= CR_FLG;
                 }
                 else {
-                    *dst++ = CR; // copy CR over
-                    lineLen += 1;
+                    Cleaner_putBlanks(me);
+                    Cleaner_put(me, CR); // copy CR over
+                    me->lineLen += 1;
                 }
                 break;
             }
+            case ' ': {
+                ++me->nBlanks; // hold back the blank
+                me->lineLen += 1;
+                break;
+            }
             default: {
                 if ((flags & ASCII_FLG) != 0u) { // clean non ASCII?
                     if (IS_ASCII(ch)) {
-                        *dst++ = ch;
-                        lineLen += 1;
+                        Cleaner_putBlanks(me);
+                        Cleaner_put(me, ch);
+                        me->lineLen += 1;
                     }
                     else {
                         // don't copy non-ASCII over
-                        found |= ASCII_FLG;
+                        me->found |= ASCII_FLG;
                     }
                 }
                 else {
-                    *dst++ = ch;
-                    lineLen += 1;
+                    Cleaner_putBlanks(me);
+                    Cleaner_put(me, ch);
+                    me->lineLen += 1;
                 }
                 break;
             }
         }
-        prev = ch;
-        if (dst >= &dst_buf[sizeof(dst_buf)]) {
-            PRINTF_S("\n%s\n", "Error: too big!");
+        me->prev = ch;
+    }
+}
+//............................................................................
+static void Cleaner_end(Cleaner * const me) {
+    Cleaner_putBlanks(me); // blanks in the last line without LF stay
+    Cleaner_flush(me);
+}
+
+//............................................................................
+// append the formatted text to the report string
+#define REPORT(fmt_, ...) do { \
+    int n_ = SNPRINTF_S(&report[rlen], sizeof(report) - rlen, \
+                        fmt_, __VA_ARGS__); \
+    if (n_ > 0) { \
+        rlen += (size_t)n_; \
+        if (rlen >= sizeof(report)) { rlen = sizeof(report) - 1U; } \
+    } \
+} while (false)
+
+//............................................................................
+void onMatchFound(Worker * const me, char const *fname,
+                  unsigned flags, FileInfo const *info)
+{
+    bool isReadOnly = false;
+
+    // the report for this file is composed in report[] and printed at once,
+    // so that the reports from concurrent workers don't get intermixed
+    char report[FILENAME_MAX + 128];
+    size_t rlen = 0U;
+
+    // the line limit and TAB size of the file type (see isMatching())
+    FileType const * const ft = Rules_get((int)(flags >> 8));
+    int const lineLimit = (ft->lineLimit != 0U) ? (int)ft->lineLimit
+                                                : l_lineLimit;
+    int const tabSize   = (ft->tabSize != 0U) ? (int)ft->tabSize
+                                              : TAB_SIZE;
+    flags &= 0xFFU;
+
+    ++me->nFiles;
+    PRINTF_S("%c", '.');
+
+    FILE *f;
+    if (info->ro >= 0) { // read-only information available right away?
+        if (info->ro > 0) {
+            isReadOnly = true;
+            ++me->nReadOnly;
+        }
+    }
+    else { // read-only information not available
+        // open for reading/writing (non destructive)
+        FOPEN_S(f, fname, "r+");
+        if (f == (FILE*)0) { // can't write
+            isReadOnly = true;
+            ++me->nReadOnly;
+        }
+        else {
+            fclose(f);
+        }
+    }
+    if (isReadOnly && !l_doReadOnly) {
+        return;
+    }
+
+    // incremental run? skip the files found clean in the previous run
+    CacheEntry const *cached = (CacheEntry const *)0;
+    if (l_cacheFile != (char const *)0) {
+        cached = Cache_find(fname);
+        if ((cached != (CacheEntry const *)0)
+            && (cached->info.size  == info->size)
+            && (cached->info.mtime == info->mtime)
+            && (cached->info.inode == info->inode)
+            && (cached->flags      == flags)
+            && (cached->lineLimit  == lineLimit)
+            && (cached->tabSize    == tabSize))
+        {
+            if (cached->hash == 0U) { // timestamp not "racy"?
+                Cache_store(me, cached);
+                return; // unchanged since found clean
+            }
+            // "racy" timestamp, the content hash must be verified
+        }
+        else {
+            cached = (CacheEntry const *)0; // new or changed file
+        }
+    }
+
+    bool const doWrite = (!l_noCleanup && !isReadOnly);
+    unsigned found = 0;
+    bool foundLLs = false;
+    bool error = false;
+    size_t fsize = 0U;
+    uint8_t const *src = mapFile(fname, &fsize); // map for reading
+    uint64_t hash = 0U;
+    if ((src != (uint8_t const *)0)
+        && (cached != (CacheEntry const *)0))
+    {
+        hash = Cache_hash(src, fsize);
+    }
+    if ((src != (uint8_t const *)0)
+        && (((cached != (CacheEntry const *)0) && (cached->hash == hash))
+            || isClean(src, fsize, flags, (size_t)lineLimit,
+                       (size_t)tabSize, &foundLLs))) // fast path?
+    {
+        if ((l_cacheFile != (char const *)0) && !foundLLs
+            && (fsize == info->size)) // not changed since the search?
+        {
+            CacheEntry e;
+            e.path      = (char *)fname;
+            e.info      = *info;
+            e.flags     = flags;
+            e.lineLimit = lineLimit;
+            e.tabSize   = tabSize;
+            e.hash      = 0U;
+            if (Cache_isRacy(info->mtime)) { // "racy" timestamp?
+                e.hash = (hash != 0U) ? hash : Cache_hash(src, fsize);
+            }
+            Cache_store(me, &e);
+        }
+        unmapFile(src, fsize);
+    }
+    else { // streaming cleanup (from the mapping or from the file)
+        FILE *in = (FILE *)0;
+        if (src == (uint8_t const *)0) { // file cannot be mapped?
+            FOPEN_S(in, fname, "rb"); // open for reading
+            if (in == (FILE*)0) {
+                return;
+            }
+        }
+        if (!Worker_reserve(me)) {
+            if (in != (FILE *)0) {
+                fclose(in);
+            }
+            else {
+                unmapFile(src, fsize);
+            }
+            REPORT("\n%s(out of memory -- skipped)\n", fname);
+            fputs(report, stdout);
             return;
         }
+
+        Cleaner cl;
+        memset(&cl, 0, sizeof(cl));
+        cl.flags     = flags;
+        cl.lineLimit = lineLimit;
+        cl.tabSize   = tabSize;
+        cl.buf   = me->dst_buf;
+
+        // the cleaned file is written to a temporary file, which
+        // atomically replaces the original only when complete
+        char tmpName[FILENAME_MAX + 16];
+        if (doWrite) {
+            SNPRINTF_S(tmpName, sizeof(tmpName), "%s.qclean~", fname);
+            // binary to use LF EOL convention
+            FOPEN_S(cl.out, tmpName, "wb");
+            if (cl.out == (FILE *)0) {
+                cl.error = true;
+            }
+        }
+
+        if (in != (FILE *)0) {
+            size_t n;
+            while ((n = FREAD_S(me->src_buf, CHUNK_SIZE,
+                                1U, CHUNK_SIZE, in)) > 0U)
+            {
+                Cleaner_chunk(&cl, me->src_buf, n);
+            }
+            fclose(in);
+        }
+        else {
+            Cleaner_chunk(&cl, src, fsize);
+            unmapFile(src, fsize); // unmap before the file is replaced
+        }
+        Cleaner_end(&cl);
+        found    = cl.found;
+        foundLLs = cl.foundLLs;
+        error    = cl.error;
+
+        if (cl.out != (FILE *)0) {
+            if (fclose(cl.out) != 0) {
+                error = true;
+            }
+            if ((found != 0) && !error) {
+                error = !replaceFile(tmpName, fname);
+            }
+            if ((found == 0) || error) {
+                (void)remove(tmpName);
+            }
+        }
     }
+
     if (found) { // anything found?
-        PRINTF_S("\n%s", fname);
-        if (!l_noCleanup && !isReadOnly) { // not read-only?
-            ++l_nCleaned;
-            // binary to use LF EOL convention
-            FOPEN_S(f, fname, "wb");
-            if (f == 0) {
-                PRINTF_S(" %s\n", "ERROR: cannot modify!");
+        REPORT("\n%s", fname);
+        if (doWrite) { // not read-only?
+            ++me->nCleaned;
+            if (error) {
+                REPORT(" %s\n", "ERROR: cannot modify!");
+                fputs(report, stdout);
                 return;
             }
-            fwrite(dst_buf, 1, dst - dst_buf, f);
-            fclose(f);
-            PRINTF_S(" %s", "CLEANED(");
+            REPORT(" %s", "CLEANED(");
         }
         else {
-            ++l_nDirty;
-            PRINTF_S(" %s", "FOUND(");
+            ++me->nDirty;
+            REPORT(" %s", "FOUND(");
         }
-        if (isReadOnly)                   PRINTF_S("%s", "Read-only,");
-        if ((found  & TRAIL_WS_FLG) != 0) PRINTF_S("%s", "Trail-WS,");
-        if ((found  & TAB_FLG     ) != 0) PRINTF_S("%s", "TABs,");
-        if ((found  & CR_FLG      ) != 0) PRINTF_S("%s", "CRs,");
-        if ((found  & LF_FLG      ) != 0) PRINTF_S("%s", "LFs,");
-        if ((found  & ASCII_FLG   ) != 0) PRINTF_S("%s", "Non-ASCII,");
+        if (isReadOnly)                   REPORT("%s", "Read-only,");
+        if ((found  & TRAIL_WS_FLG) != 0) REPORT("%s", "Trail-WS,");
+        if ((found  & TAB_FLG     ) != 0) REPORT("%s", "TABs,");
+        if ((found  & CR_FLG      ) != 0) REPORT("%s", "CRs,");
+        if ((found  & LF_FLG      ) != 0) REPORT("%s", "LFs,");
+        if ((found  & ASCII_FLG   ) != 0) REPORT("%s", "Non-ASCII,");
     }
     if (foundLLs) {
-        ++l_nDirty;
+        ++me->nDirty;
         if (found == 0) {
-            PRINTF_S("\n%s FOUND(Long-lines", fname);
+            REPORT("\n%s FOUND(Long-lines", fname);
         }
         else if (!isReadOnly) {
-            PRINTF_S(") %s", "FOUND(Long-lines");
+            REPORT(") %s", "FOUND(Long-lines");
         }
         else {
-            PRINTF_S("%s", "Long-lines");
+            REPORT("%s", "Long-lines");
         }
     }
     if (found || foundLLs) {
-        PRINTF_S("%s\n", ")");
+        REPORT("%s\n", ")");
+        fputs(report, stdout);
     }
 
     fflush(stdout);
@@ -352,11 +645,19 @@ static char const l_helpStr[] =
     "-q                      query only (no cleanup when -q present)\n"
     "-c                      check only (no cleanup, non-zero if dirty)\n"
     "-r                      check also read-only files\n"
-    "-l[limit]     %d        line length limit (not checked when -l absent)\n";
+    "-l[limit]     %d        line length limit (not checked when -l absent)\n"
+    "-j[threads]   CPUs      parallel search and cleanup in [threads]\n"
+    "                        (single-threaded when -j absent)\n"
+    "-i[cache]               incremental run with the file-state [cache]\n"
+    "                        (default %s in root-dir)\n"
+    "-t[rules]               file-type rules from the [rules] file\n"
+    "                        (default %s in root-dir)\n";
 
 //............................................................................
 int main(int argc, char *argv[]) {
     char const *rootDir = ".";
+    char const *rulesFile = (char const *)0; // no rules file
+    char rulesPath[FILENAME_MAX];
     int optChar;
 
     PRINTF_S("%s", "QClean " VERSION " Copyright (c) 2005-2026 Quantum Leaps\n"
@@ -370,10 +671,10 @@ int main(int argc, char *argv[]) {
         rootDir = argv[1];
     }
     PRINTF_S("root-directory: %s\n", rootDir);
-    while ((optChar = getopt(argc, argv, ":hcqrl::")) != -1) {
+    while ((optChar = getopt(argc, argv, ":hcqrl::j::i::t::")) != -1) {
          switch (optChar) {
              case 'h': { // help
-                 PRINTF_S(l_helpStr, LINE_LIMIT);
+                 PRINTF_S(l_helpStr, LINE_LIMIT, CACHE_FILE, RULES_FILE);
                  return 0;
              }
              case 'q': { // query only (no cleanup)
@@ -402,15 +703,72 @@ int main(int argc, char *argv[]) {
                  PRINTF_S("-l line-length:%d\n", l_lineLimit);
                  break;
              }
+             case 'i': { // incremental run with the file-state cache
+                 l_cacheFile = (optarg != NULL) ? optarg : CACHE_FILE;
+                 PRINTF_S("-i cache:%s\n", l_cacheFile);
+                 break;
+             }
+             case 't': { // file-type rules from a file
+                 if (optarg != NULL) { // is optional argument provided?
+                     rulesFile = optarg;
+                 }
+                 else { // apply the default in the root directory
+                     SNPRINTF_S(rulesPath, sizeof(rulesPath), "%s/%s",
+                                rootDir, RULES_FILE);
+                     rulesFile = rulesPath;
+                 }
+                 PRINTF_S("-t rules:%s\n", rulesFile);
+                 break;
+             }
+             case 'j': { // parallel search and cleanup
+                 if (optarg != NULL) { // is optional argument provided?
+                     l_nThreads = (unsigned)strtoul(optarg, NULL, 10);
+                 }
+                 else { // one thread per CPU
+                     l_nThreads = 0U;
+                 }
+                 PRINTF_S("-j threads:%u%s\n", l_nThreads,
+                          (l_nThreads == 0U) ? "(CPUs)" : "");
+                 break;
+             }
              default: { // unknown option
-                 PRINTF_S(l_helpStr, LINE_LIMIT);
+                 PRINTF_S(l_helpStr, LINE_LIMIT, CACHE_FILE, RULES_FILE);
                  return -1;
              }
          }
     }
 
+    if (rulesFile != (char const *)0) {
+        if (!Rules_load(rulesFile)) {
+            return -1;
+        }
+    }
+    else if (!Rules_compile(l_fileTypes, l_fileNum)) {
+        PRINTF_S("%s\n", "out of memory");
+        return -1;
+    }
+
+    char cachePath[FILENAME_MAX];
+    if (l_cacheFile != (char const *)0) {
+        bool const isAbsolute = (l_cacheFile[0] == '/')
+            || (l_cacheFile[0] == '\\')
+            || ((l_cacheFile[0] != '\0') && (l_cacheFile[1] == ':')); // C:
+        if (!isAbsolute) { // relative to the root directory?
+            SNPRINTF_S(cachePath, sizeof(cachePath), "%s/%s",
+                       rootDir, l_cacheFile);
+            l_cacheFile = cachePath;
+        }
+        (void)Cache_load(l_cacheFile, (int64_t)time(NULL) * 1000000000LL);
+    }
+
     l_nFiles = 0;
-    filesearch(rootDir);
+    filesearch(rootDir, l_nThreads);
+
+    if (l_cacheFile != (char const *)0) {
+        if (!Cache_save(l_cacheFile)) {
+            PRINTF_S("\n%s: cannot write the cache\n", l_cacheFile);
+        }
+    }
     PRINTF_S("\n---------------------------------------"
            "----------------------------------------\n"
            "Files processed:%d ", l_nFiles);
@@ -0,0 +1,276 @@
+//============================================================================
+// QClean white space cleanup host utility
+//
+//                   Q u a n t u m  L e a P s
+//                   ------------------------
+//                   Modern Embedded Software
+//
+// Copyright (C) 2005 Quantum Leaps, LLC. <state-machine.com>
+//
+// SPDX-License-Identifier: GPL-3.0-or-later OR LicenseRef-QL-commercial
+//
+// This software is dual-licensed under the terms of the open source GNU
+// General Public License version 3 (or any later version), or alternatively,
+// under the terms of one of the closed source Quantum Leaps commercial
+// licenses.
+//
+// The terms of the open source GNU General Public License version 3
+// can be found at: <www.gnu.org/licenses/gpl-3.0>
+//
+// The terms of the closed source Quantum Leaps commercial licenses
+// can be found at: <www.state-machine.com/licensing>
+//
+// Redistributions in source code must retain this top-level comment block.
+// Plagiarizing this software to sidestep the license obligations is illegal.
+//
+// Contact information:
+// <www.state-machine.com>
+// <info@state-machine.com>
+//============================================================================
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+
+#include "safe_std.h" // "safe" <stdio.h> and <string.h> facilities
+#include "qclean.h"
+
+// The file-type rules are either the built-in table or loaded from a rules
+// file (-t option), which is a text file with one rule per line:
+//
+// <pattern> <flag>... [limit=<line-limit>] [tab=<tab-size>]
+//
+// The <pattern> is matched against the end of the file name, so it can be
+// a file extension (e.g., ".c") or a whole file name. The flags are:
+// CR (clean CRs, otherwise the CRLF convention is applied), TAB (replace
+// TABs), LONG (check long lines), ASCII (clean non-ASCII characters), or
+// a single '-' for files to be skipped. Everything after '#' is a comment.
+// When several patterns match, the rule listed first applies.
+//
+// The rules are compiled into a trie of the reversed patterns, which is
+// walked from the end of the file name. The trie edges are kept in one
+// open-addressing hash table, so matching a file name costs one lookup
+// per character, regardless of the number of rules.
+
+typedef struct {
+    uint32_t key;   // (parent node << 8) | character, 0 for empty slot
+    uint32_t child; // the child node
+} Edge;
+
+static FileType const *l_types;     // the rules (first match applies)
+static FileType       *l_loaded;    // the rules loaded from the rules file
+
+static int            *l_rule;      // rule of each trie node (-1 for none)
+static size_t          l_nNodes;
+static Edge           *l_edges;     // hash table of the trie edges
+static uint32_t        l_edgeMask;  // size of l_edges[] - 1 (power of 2)
+
+//............................................................................
+static inline uint32_t edgeHash(uint32_t key) {
+    return (key * 0x9E3779B1U) ^ (key >> 15);
+}
+//............................................................................
+static uint32_t findEdge(uint32_t node, uint8_t ch) {
+    uint32_t const key = (node << 8) | ch;
+    uint32_t i = edgeHash(key) & l_edgeMask;
+    for (; l_edges[i].key != 0U; i = (i + 1U) & l_edgeMask) {
+        if (l_edges[i].key == key) {
+            return l_edges[i].child;
+        }
+    }
+    return 0U; // no such edge (the root is never a child)
+}
+//............................................................................
+bool Rules_compile(FileType const *types, size_t nTypes) {
+    size_t maxNodes = 1U; // the root
+    for (size_t n = 0U; n < nTypes; ++n) {
+        maxNodes += types[n].len;
+    }
+    size_t nEdges = 16U;
+    while (nEdges < 2U * maxNodes) {
+        nEdges *= 2U;
+    }
+    free(l_rule);
+    free(l_edges);
+    l_rule  = (int *)malloc(maxNodes * sizeof(int));
+    l_edges = (Edge *)calloc(nEdges, sizeof(Edge));
+    if ((l_rule == (int *)0) || (l_edges == (Edge *)0)) {
+        return false;
+    }
+    l_edgeMask = (uint32_t)(nEdges - 1U);
+    l_types    = types;
+    l_nNodes   = 1U;
+    l_rule[0]  = -1;
+
+    for (size_t n = 0U; n < nTypes; ++n) {
+        uint32_t node = 0U;
+        for (int i = types[n].len - 1; i >= 0; --i) { // reversed pattern
+            uint8_t const ch = (uint8_t)types[n].pattern[i];
+            uint32_t child = findEdge(node, ch);
+            if (child == 0U) { // new edge?
+                child = (uint32_t)l_nNodes++;
+                l_rule[child] = -1;
+                uint32_t const key = (node << 8) | ch;
+                uint32_t k = edgeHash(key) & l_edgeMask;
+                while (l_edges[k].key != 0U) { // linear probing
+                    k = (k + 1U) & l_edgeMask;
+                }
+                l_edges[k].key   = key;
+                l_edges[k].child = child;
+            }
+            node = child;
+        }
+        if ((node != 0U) && (l_rule[node] < 0)) { // first such pattern?
+            l_rule[node] = (int)n;
+        }
+    }
+    return true;
+}
+//............................................................................
+int Rules_match(char const *fname) {
+    char const *s = &fname[strlen(fname)];
+    int match = -1;
+    uint32_t node = 0U;
+    while (s != fname) {
+        --s;
+        node = findEdge(node, (uint8_t)*s);
+        if (node == 0U) { // no longer pattern?
+            break;
+        }
+        int const r = l_rule[node];
+        if ((r >= 0) && ((r < match) || (match < 0))) {
+            match = r; // the rule listed first applies
+        }
+    }
+    return match;
+}
+//............................................................................
+FileType const *Rules_get(int rule) {
+    return &l_types[rule];
+}
+
+//............................................................................
+// parse one rule line (zero-terminated), returns false if invalid
+// and true also for empty lines (then ft->len is 0)
+static bool parseRule(char *line, FileType * const ft) {
+    char *hash = strchr(line, '#');
+    if (hash != (char *)0) {
+        *hash = '\0'; // strip the comment
+    }
+    memset(ft, 0, sizeof(*ft));
+    bool hasFlags = false;
+    char *tok = line;
+    for (;;) {
+        while (isspace((unsigned char)*tok)) {
+            ++tok;
+        }
+        if (*tok == '\0') {
+            break;
+        }
+        char *end = tok;
+        while ((*end != '\0') && !isspace((unsigned char)*end)) {
+            ++end;
+        }
+        size_t const len = (size_t)(end - tok);
+        if (*end != '\0') {
+            *end++ = '\0';
+        }
+
+        if (ft->len == 0U) { // the pattern comes first
+            if (len >= sizeof(ft->pattern)) {
+                return false;
+            }
+            memcpy(ft->pattern, tok, len + 1U);
+            ft->len = (uint8_t)len;
+        }
+        else if (strcmp(tok, "CR") == 0) {
+            ft->flags |= CR_FLG;
+            hasFlags = true;
+        }
+        else if (strcmp(tok, "TAB") == 0) {
+            ft->flags |= TAB_FLG;
+            hasFlags = true;
+        }
+        else if (strcmp(tok, "LONG") == 0) {
+            ft->flags |= LONG_LINE_FLG;
+            hasFlags = true;
+        }
+        else if (strcmp(tok, "ASCII") == 0) {
+            ft->flags |= ASCII_FLG;
+            hasFlags = true;
+        }
+        else if (strcmp(tok, "-") == 0) { // skip such files
+            hasFlags = true;
+        }
+        else if (strncmp(tok, "limit=", 6) == 0) {
+            unsigned long const n = strtoul(&tok[6], &tok, 10);
+            if ((*tok != '\0') || (n == 0UL) || (n > 0xFFFFUL)) {
+                return false;
+            }
+            ft->lineLimit = (uint16_t)n;
+        }
+        else if (strncmp(tok, "tab=", 4) == 0) {
+            unsigned long const n = strtoul(&tok[4], &tok, 10);
+            if ((*tok != '\0') || (n == 0UL) || (n > 16UL)) {
+                return false;
+            }
+            ft->tabSize = (uint8_t)n;
+        }
+        else {
+            return false;
+        }
+        tok = end;
+    }
+    return (ft->len == 0U) || hasFlags;
+}
+//............................................................................
+bool Rules_load(char const *rulesFile) {
+    FILE *f;
+    FOPEN_S(f, rulesFile, "r");
+    if (f == (FILE *)0) {
+        PRINTF_S("%s: cannot open the rules file\n", rulesFile);
+        return false;
+    }
+    size_t cap = 64U;
+    size_t n = 0U;
+    FileType *types = (FileType *)malloc(cap * sizeof(FileType));
+    bool ok = (types != (FileType *)0);
+    char line[256];
+    int lineNum = 0;
+    while (ok && (fgets(line, sizeof(line), f) != (char *)0)) {
+        ++lineNum;
+        if (n == cap) {
+            FileType *t = (FileType *)realloc(types, 2U * cap
+                                                     * sizeof(FileType));
+            if (t == (FileType *)0) {
+                ok = false;
+                break;
+            }
+            types = t;
+            cap *= 2U;
+        }
+        if (!parseRule(line, &types[n])) {
+            PRINTF_S("%s:%d: invalid rule\n", rulesFile, lineNum);
+            ok = false;
+        }
+        else if (types[n].len != 0U) { // not an empty line?
+            ++n;
+        }
+    }
+    fclose(f);
+
+    if (ok && (n == 0U)) {
+        PRINTF_S("%s: no rules\n", rulesFile);
+        ok = false;
+    }
+    if (ok) {
+        ok = Rules_compile(types, n);
+    }
+    if (!ok) {
+        free(types);
+        return false;
+    }
+    free(l_loaded);
+    l_loaded = types;
+    return true;
+}
@@ -32,10 +32,17 @@
 
 #define VERSION "8.0.0"
 
+#include <stddef.h>
+
 unsigned isMatching  (char const *fullPath);
 void     onMatchFound(char const *fullPath, unsigned flags, int ro_info);
 void     filesearch  (char const *dirname);
 
+// gzip-compress the src[] into the dst[] buffer (see gzip.c), returns
+// the size of the compressed data or 0 if it doesn't fit into dst[]
+size_t   gzipCompress(unsigned char const *src, size_t srcSize,
+                      unsigned char *dst, size_t dstSize);
+
 extern char const dir_separator; // platform-dependent directory separator
 
 #endif // QFSGEN_H_
@@ -45,6 +45,12 @@ if (fopen_s(&fp_, fName_, mode_) != 0) { \
 #define LOCALTIME_S(tm_, time_) \
     localtime_s(tm_, time_)
 
+#define STRNCPY_S(dest_, destsiz_, src_) \
+    strncpy_s(dest_, destsiz_, src_, _TRUNCATE)
+
+#define STRCAT_S(dest_, destsiz_, src_) \
+    strcat_s(dest_, destsiz_, src_)
+
 #else // other OS (Linux, MacOS, etc.) .....................................
 
 #define SNPRINTF_S(buf_, bufsiz_, format_, ...) \
@@ -65,6 +71,14 @@ if (fopen_s(&fp_, fName_, mode_) != 0) { \
 #define LOCALTIME_S(tm_, time_) \
     memcpy(tm_, localtime(time_), sizeof(struct tm))
 
+#define STRNCPY_S(dest_, destsiz_, src_) do { \
+    strncpy(dest_, src_, destsiz_); \
+    dest_[(destsiz_) - 1] = '\0'; \
+} while (0)
+
+#define STRCAT_S(dest_, destsiz_, src_) \
+    strncat(dest_, src_, (destsiz_) - strlen(dest_) - 1)
+
 #endif // _WIN32
 
 #endif // SAFE_STD_H_
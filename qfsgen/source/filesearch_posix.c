@@ -29,6 +29,7 @@
 //============================================================================
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <dirent.h>
 #include <stdbool.h>
@@ -37,47 +38,93 @@
 #include "qfsgen.h"
 
 /*..........................................................................*/
-char const dir_separator = '\\'; /* platform-dependent directory separator */
+char const dir_separator = '/'; /* platform-dependent directory separator */
 
 /*..........................................................................*/
-void filesearch(char const *dname) {
+/* recursive search of the directory dfd, which has the path[0..len).
+* All entries are accessed relative to dfd and are classified by d_type,
+* so that no system calls are needed for the entries except of opening
+* the subdirectories. The path of each entry is built in place.
+*/
+static void searchDir(int dfd, char *path, size_t len) {
+    DIR * const dir = fdopendir(dfd);
     struct dirent *dent;
-    DIR *dir;
-    struct stat st;
-    char fn[FILENAME_MAX];
-    int len = strlen(dname);
-    if (len >= FILENAME_MAX - 1) {
-        return;
-    }
-
-    strcpy(fn, dname);
-    fn[len++] = '/';
-    if ((dir = opendir(dname)) == NULL) {
+    if (dir == NULL) {
+        close(dfd);
         return;
     }
 
+    path[len] = '/';
     while ((dent = readdir(dir)) != NULL) {
-        if ((dent->d_name[0] != '.')
-             && (strcmp(dent->d_name, ".") != 0)
-             && (strcmp(dent->d_name, "..") != 0))
+        size_t nlen;
+        bool isDir;
+        if (dent->d_name[0] == '.') { /* hidden file/dir or "." or ".."? */
+            continue;
+        }
+        nlen = strlen(dent->d_name);
+        if (len + 1U + nlen >= FILENAME_MAX) {
+            continue;
+        }
+        memcpy(&path[len + 1U], dent->d_name, nlen + 1U);
+
+#ifdef DT_UNKNOWN
+        if (dent->d_type == DT_DIR) {
+            isDir = true;
+        }
+        else if (dent->d_type == DT_REG) {
+            isDir = false;
+        }
+        else if (dent->d_type != DT_UNKNOWN) {
+            continue; /* don't follow symlinks, skip special files */
+        }
+        else
+#endif
         {
-            strncpy(fn + len, dent->d_name, FILENAME_MAX - len);
-            if (lstat(fn, &st) != -1) {
-                /* don't follow symlink unless told so */
-                if (S_ISLNK(st.st_mode)) {
-                }
-                else if (S_ISDIR(st.st_mode)) { /* false for symlinked dirs */
-                    filesearch(fn); /* recursively follow dirs */
-                }
-                else {
-                    int flags = isMatching(dent->d_name);
-                    if ((flags & 0xFF) != 0) {
-                        onMatchFound(fn, flags, -1); /* no read-only info */
-                    }
-                }
+            struct stat st;
+            if (fstatat(dfd, dent->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+                continue;
+            }
+            if (S_ISDIR(st.st_mode)) { /* false for symlinked dirs */
+                isDir = true;
+            }
+            else if (S_ISREG(st.st_mode)) {
+                isDir = false;
+            }
+            else {
+                continue;
+            }
+        }
+
+        if (isDir) {
+            int const sub = openat(dfd, dent->d_name,
+                                   O_RDONLY | O_DIRECTORY | O_NOFOLLOW
+                                   | O_CLOEXEC);
+            if (sub != -1) {
+                searchDir(sub, path, len + 1U + nlen); /* follow dirs */
+            }
+        }
+        else {
+            unsigned const flags = isMatching(dent->d_name);
+            if ((flags & 0xFFU) != 0U) {
+                onMatchFound(path, flags, -1); /* no read-only info */
             }
         }
     }
 
-    closedir(dir);
+    closedir(dir); /* closes also dfd */
+}
+/*..........................................................................*/
+void filesearch(char const *dname) {
+    char path[FILENAME_MAX];
+    size_t const len = strlen(dname);
+    int dfd;
+    if (len >= FILENAME_MAX - 1U) {
+        return;
+    }
+    dfd = open(dname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dfd == -1) {
+        return;
+    }
+    memcpy(path, dname, len + 1U);
+    searchDir(dfd, path, len);
 }
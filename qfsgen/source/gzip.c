@@ -0,0 +1,289 @@
+//============================================================================
+// QFSGEN ROM file system generation host utility
+//
+//                   Q u a n t u m  L e a P s
+//                   ------------------------
+//                   Modern Embedded Software
+//
+// Copyright (C) 2005 Quantum Leaps, LLC. <state-machine.com>
+//
+// SPDX-License-Identifier: GPL-3.0-or-later OR LicenseRef-QL-commercial
+//
+// This software is dual-licensed under the terms of the open source GNU
+// General Public License version 3 (or any later version), or alternatively,
+// under the terms of one of the closed source Quantum Leaps commercial
+// licenses.
+//
+// The terms of the open source GNU General Public License version 3
+// can be found at: <www.gnu.org/licenses/gpl-3.0>
+//
+// The terms of the closed source Quantum Leaps commercial licenses
+// can be found at: <www.state-machine.com/licensing>
+//
+// Redistributions in source code must retain this top-level comment block.
+// Plagiarizing this software to sidestep the license obligations is illegal.
+//
+// Contact information:
+// <www.state-machine.com>
+// <info@state-machine.com>
+//============================================================================
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "safe_std.h" /* "safe" <stdio.h> and <string.h> facilities */
+#include "qfsgen.h"
+
+/* Minimal gzip (RFC 1952) encoder for pre-compressing the files at
+* generation time. The data is compressed as a single DEFLATE (RFC 1951)
+* block with the fixed Huffman codes, where the LZ77 matches are found
+* with hash chains and one step of lazy matching. This keeps qfsgen free
+* of external libraries, while the text files typically shrink 3-5 times.
+*/
+enum {
+    WIN_SIZE   = 32*1024,   /* LZ77 window size */
+    HASH_BITS  = 15,
+    HASH_SIZE  = 1 << HASH_BITS,
+    MIN_MATCH  = 3,
+    MAX_MATCH  = 258,
+    MAX_CHAIN  = 256,       /* the longest hash chain searched */
+    NIL        = -1
+};
+
+typedef struct {
+    unsigned char *dst;     /* output buffer */
+    size_t size;            /* size of the output buffer */
+    size_t len;             /* bytes in the output buffer */
+    uint32_t bits;          /* bits not output yet (LSB first) */
+    unsigned nBits;         /* number of bits in 'bits' */
+    bool overflow;          /* output buffer too small */
+} BitWriter;
+
+static uint16_t const l_lenBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static uint8_t const l_lenExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static uint16_t const l_distBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577
+};
+static uint8_t const l_distExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/*..........................................................................*/
+static void putByte(BitWriter * const me, unsigned b) {
+    if (me->len < me->size) {
+        me->dst[me->len++] = (unsigned char)b;
+    }
+    else {
+        me->overflow = true;
+    }
+}
+/*..........................................................................*/
+/* output the n bits of the value (LSB first) */
+static void putBits(BitWriter * const me, uint32_t value, unsigned n) {
+    me->bits |= value << me->nBits;
+    me->nBits += n;
+    while (me->nBits >= 8U) {
+        putByte(me, me->bits & 0xFFU);
+        me->bits >>= 8;
+        me->nBits -= 8U;
+    }
+}
+/*..........................................................................*/
+/* output the Huffman code of n bits (MSB first) */
+static void putCode(BitWriter * const me, uint32_t code, unsigned n) {
+    uint32_t rev = 0U;
+    unsigned i;
+    for (i = 0U; i < n; ++i) {
+        rev = (rev << 1) | ((code >> i) & 1U);
+    }
+    putBits(me, rev, n);
+}
+/*..........................................................................*/
+/* output the literal/length symbol with the fixed Huffman code */
+static void putSymbol(BitWriter * const me, unsigned sym) {
+    if (sym < 144U) {
+        putCode(me, 0x30U + sym, 8U);
+    }
+    else if (sym < 256U) {
+        putCode(me, 0x190U + (sym - 144U), 9U);
+    }
+    else if (sym < 280U) {
+        putCode(me, sym - 256U, 7U);
+    }
+    else {
+        putCode(me, 0xC0U + (sym - 280U), 8U);
+    }
+}
+/*..........................................................................*/
+static void putMatch(BitWriter * const me, unsigned len, unsigned dist) {
+    unsigned i = 28U;
+    while (l_lenBase[i] > len) {
+        --i;
+    }
+    putSymbol(me, 257U + i);
+    putBits(me, len - l_lenBase[i], l_lenExtra[i]);
+
+    i = 29U;
+    while (l_distBase[i] > dist) {
+        --i;
+    }
+    putCode(me, i, 5U); /* fixed distance codes */
+    putBits(me, dist - l_distBase[i], l_distExtra[i]);
+}
+/*..........................................................................*/
+static uint32_t crc32(unsigned char const *data, size_t n) {
+    static uint32_t table[256];
+    uint32_t crc = 0xFFFFFFFFU;
+    if (table[1] == 0U) { /* table not initialized yet? */
+        uint32_t i;
+        for (i = 0U; i < 256U; ++i) {
+            uint32_t c = i;
+            int k;
+            for (k = 0; k < 8; ++k) {
+                c = ((c & 1U) != 0U) ? (0xEDB88320U ^ (c >> 1)) : (c >> 1);
+            }
+            table[i] = c;
+        }
+    }
+    for (; n != 0U; --n, ++data) {
+        crc = table[(crc ^ *data) & 0xFFU] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFU;
+}
+/*..........................................................................*/
+static inline unsigned hash3(unsigned char const *p) {
+    return ((((unsigned)p[0] << 10) ^ ((unsigned)p[1] << 5) ^ p[2])
+            * 2654435761U) >> (32 - HASH_BITS) & (HASH_SIZE - 1);
+}
+/*..........................................................................*/
+/* the longest match for the position pos, returns its length (0 if none) */
+static unsigned findMatch(unsigned char const *src, size_t n, size_t pos,
+                          int32_t const *head, int32_t const *prev,
+                          unsigned *dist)
+{
+    unsigned best = 0U;
+    size_t const maxLen = ((n - pos) < MAX_MATCH) ? (n - pos) : MAX_MATCH;
+    int32_t cand;
+    int chain = MAX_CHAIN;
+    if (maxLen < MIN_MATCH) {
+        return 0U;
+    }
+    for (cand = head[hash3(&src[pos])];
+         (cand != NIL) && ((pos - (size_t)cand) <= WIN_SIZE) && (chain > 0);
+         cand = prev[(size_t)cand & (WIN_SIZE - 1)], --chain)
+    {
+        unsigned char const *a = &src[cand];
+        unsigned char const *b = &src[pos];
+        unsigned len;
+        if (a[best] != b[best]) { /* can't be longer than the best? */
+            continue;
+        }
+        for (len = 0U; (len < maxLen) && (a[len] == b[len]); ++len) {
+        }
+        if (len > best) {
+            best  = len;
+            *dist = (unsigned)(pos - (size_t)cand);
+            if (len == maxLen) {
+                break;
+            }
+        }
+    }
+    return (best >= MIN_MATCH) ? best : 0U;
+}
+/*..........................................................................*/
+size_t gzipCompress(unsigned char const *src, size_t n,
+                    unsigned char *dst, size_t dstSize)
+{
+    static unsigned char const header[10] = {
+        0x1F, 0x8B, 8U, /* magic, method: deflate */
+        0U,             /* flags: none */
+        0U, 0U, 0U, 0U, /* mtime: none (reproducible output) */
+        0U, 0xFFU       /* extra flags, OS: unknown */
+    };
+    int32_t *head = (int32_t *)malloc(HASH_SIZE * sizeof(int32_t));
+    int32_t *prev = (int32_t *)malloc(WIN_SIZE * sizeof(int32_t));
+    BitWriter bw;
+    size_t pos = 0U;
+    size_t i;
+    uint32_t crc;
+
+    if ((head == (int32_t *)0) || (prev == (int32_t *)0)) {
+        free(head);
+        free(prev);
+        return 0U;
+    }
+    for (i = 0U; i < HASH_SIZE; ++i) {
+        head[i] = NIL;
+    }
+    memset(&bw, 0, sizeof(bw));
+    bw.dst  = dst;
+    bw.size = dstSize;
+    for (i = 0U; i < sizeof(header); ++i) {
+        putByte(&bw, header[i]);
+    }
+
+    putBits(&bw, 1U, 1U); /* BFINAL */
+    putBits(&bw, 1U, 2U); /* BTYPE: fixed Huffman codes */
+    while ((pos < n) && !bw.overflow) {
+        unsigned dist = 0U;
+        unsigned len = findMatch(src, n, pos, head, prev, &dist);
+        size_t end;
+        if (len != 0U) { /* lazy matching: is the next match longer? */
+            unsigned dist2 = 0U;
+            if (pos + MIN_MATCH <= n) {
+                unsigned const h = hash3(&src[pos]);
+                prev[pos & (WIN_SIZE - 1)] = head[h];
+                head[h] = (int32_t)pos;
+            }
+            if (findMatch(src, n, pos + 1U, head, prev, &dist2) > len) {
+                putSymbol(&bw, src[pos]);
+                ++pos;
+                continue; /* position pos already inserted */
+            }
+            putMatch(&bw, len, dist);
+            end = pos + len;
+            ++pos; /* position pos already inserted */
+        }
+        else {
+            putSymbol(&bw, src[pos]);
+            end = pos + 1U;
+            if (pos + MIN_MATCH <= n) {
+                unsigned const h = hash3(&src[pos]);
+                prev[pos & (WIN_SIZE - 1)] = head[h];
+                head[h] = (int32_t)pos;
+            }
+            ++pos;
+        }
+        for (; pos < end; ++pos) { /* insert the skipped positions */
+            if (pos + MIN_MATCH <= n) {
+                unsigned const h = hash3(&src[pos]);
+                prev[pos & (WIN_SIZE - 1)] = head[h];
+                head[h] = (int32_t)pos;
+            }
+        }
+    }
+    putSymbol(&bw, 256U); /* end of block */
+    if (bw.nBits != 0U) { /* flush the last byte */
+        putBits(&bw, 0U, 8U - bw.nBits);
+    }
+
+    crc = crc32(src, n);
+    for (i = 0U; i < 4U; ++i) {
+        putByte(&bw, (crc >> (8U * i)) & 0xFFU);
+    }
+    for (i = 0U; i < 4U; ++i) {
+        putByte(&bw, ((uint32_t)n >> (8U * i)) & 0xFFU);
+    }
+    free(head);
+    free(prev);
+    return bw.overflow ? 0U : bw.len;
+}
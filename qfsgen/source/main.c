@@ -27,6 +27,8 @@
 // <www.state-machine.com>
 // <info@state-machine.com>
 //============================================================================
+#include <stdlib.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 #include "safe_std.h" /* "safe" <stdio.h> and <string.h> facilities */
@@ -37,35 +39,468 @@ static FILE *l_file;
 static bool  l_genHttpHeaders = false;
 static int   l_nFiles;
 static char  l_prevFile[256];
+static bool  l_gzip = false;  /* gzip-compress the text files (-z option) */
+static bool  l_genIndex = false; /* generate the lookup index (-i option) */
+static bool  l_etags = false; /* generate ETag headers (-e option) */
+static FILE *l_binFile;       /* binary image (-b option) or NULL */
+static char  l_binName[256];  /* file name of the binary image */
+static unsigned long l_binOffset; /* current offset in the binary image */
+static bool  l_wrErr = false; /* a write failed (e.g., disk full) */
 
+/*..........................................................................*/
+/* buffered hex emitter, which formats the bytes as C initializers
+* (10 bytes per line) through a lookup table and writes large blocks
+*/
+enum {
+    HEX_PER_LINE = 10,        /* bytes per line of the hex dump */
+    OUT_SIZE     = 64*1024,   /* size of the output buffer */
+    IN_SIZE      = 64*1024    /* size of the input blocks */
+};
+
+static char   l_hex[256][4];  /* "0xXX" for each byte value */
+static char   l_out[OUT_SIZE];/* output buffer of the hex emitter */
+static size_t l_outLen;       /* number of characters in l_out[] */
+static size_t l_hexCol;       /* bytes in the current hex dump */
+
+/*..........................................................................*/
+static void hexInit(void) {
+    static char const digits[] = "0123456789ABCDEF";
+    unsigned b;
+    for (b = 0U; b < 256U; ++b) {
+        l_hex[b][0] = '0';
+        l_hex[b][1] = 'x';
+        l_hex[b][2] = digits[b >> 4];
+        l_hex[b][3] = digits[b & 0xFU];
+    }
+}
+/*..........................................................................*/
+static void hexFlush(void) {
+    if (l_outLen != 0U) {
+        if (fwrite(l_out, 1U, l_outLen, l_file) != l_outLen) {
+            l_wrErr = true;
+        }
+        l_outLen = 0U;
+    }
+}
+/*..........................................................................*/
+static void hexBegin(void) {
+    l_hexCol = 0U;
+}
+/*..........................................................................*/
+static void hexWrite(unsigned char const *data, size_t n) {
+    /* the longest formatted byte: ",\x0A    0xXX" */
+    size_t const maxLen = 2U + 4U + sizeof(l_hex[0]);
+    char *d = &l_out[l_outLen];
+    for (; n != 0U; --n, ++data) {
+        if (d > &l_out[OUT_SIZE - maxLen]) { /* no room for the next? */
+            l_outLen = (size_t)(d - l_out);
+            hexFlush();
+            d = l_out;
+        }
+        if (l_hexCol == 0U) { /* beginning of the dump? */
+            memcpy(d, "    ", 4U);
+            d += 4;
+        }
+        else if ((l_hexCol % HEX_PER_LINE) == 0U) { /* new line? */
+            memcpy(d, ",\x0A    ", 6U);
+            d += 6;
+        }
+        else { /* inside the line */
+            d[0] = ',';
+            d[1] = ' ';
+            d += 2;
+        }
+        memcpy(d, l_hex[*data], sizeof(l_hex[0]));
+        d += sizeof(l_hex[0]);
+        ++l_hexCol;
+    }
+    l_outLen = (size_t)(d - l_out);
+}
+/*..........................................................................*/
+static void hexEnd(void) {
+    hexFlush(); /* before any other output to l_file */
+}
 /*..........................................................................*/
 static void dumpStrHex(char const *s) {
-    int len = 0;
-    int i = 0;
-    while (*s != '\0') {
-        if (i == 0) { /* new line? */
-            ++i;
-            if (len == 0) { /* beginning of the file? */
-                FPRINTF_S(l_file, "%s", "    ");
+    hexBegin();
+    hexWrite((unsigned char const *)s, strlen(s));
+    hexEnd();
+    if ((l_hexCol % HEX_PER_LINE) == 0U) { /* full last line? */
+        FPRINTF_S(l_file, "%s", "    "); /* as in the earlier versions */
+    }
+}
+/*..........................................................................*/
+/* append the bytes to the binary image (-b option) */
+static void binWrite(void const *data, size_t n) {
+    if (fwrite(data, 1U, n, l_binFile) != n) {
+        l_wrErr = true;
+    }
+    l_binOffset += (unsigned long)n;
+}
+/*..........................................................................*/
+/* O(1) lookup index (-i option) of the files by name, which is generated
+* as a minimal perfect hash (hash and displace). The first-level hash of
+* the name selects the displacement seed, with which the second-level
+* hash of the name gives the index of the file, so the lookup takes two
+* hashes and one name comparison regardless of the number of files.
+*/
+typedef struct {
+    char *name;             /* the file name, e.g., "/img/logo.png" */
+    char *fvar;             /* the C-variable name part, e.g., img_logo_png */
+    unsigned long hash;     /* the first-level hash of the name */
+    uint64_t etag;          /* the content hash (-e option), 0 for none */
+} IndexEntry;
+
+static IndexEntry *l_index;
+static size_t      l_nIndex;
+static size_t      l_capIndex;
+
+/*..........................................................................*/
+/* FNV-1a hash with the seed and a final mix, as generated for the target
+* in genIndex()
+*/
+static unsigned long fsHash(char const *name, unsigned long seed) {
+    unsigned long h = 0x811C9DC5UL ^ seed;
+    for (; *name != '\0'; ++name) {
+        h = ((h ^ (unsigned char)*name) * 0x01000193UL) & 0xFFFFFFFFUL;
+    }
+    h ^= h >> 16; /* mix the upper bits into the lower ones (% n) */
+    h = (h * 0x85EBCA6BUL) & 0xFFFFFFFFUL;
+    h ^= h >> 13;
+    return h;
+}
+/*..........................................................................*/
+static IndexEntry *indexAdd(char const *name, char const *fvar) {
+    IndexEntry *e;
+    if (l_nIndex == l_capIndex) {
+        size_t const cap = (l_capIndex != 0U) ? 2U * l_capIndex : 64U;
+        IndexEntry *p = (IndexEntry *)realloc(l_index,
+                                              cap * sizeof(IndexEntry));
+        if (p == (IndexEntry *)0) {
+            return (IndexEntry *)0;
+        }
+        l_index    = p;
+        l_capIndex = cap;
+    }
+    e = &l_index[l_nIndex];
+    e->name = (char *)malloc(strlen(name) + 1U);
+    e->fvar = (char *)malloc(strlen(fvar) + 1U);
+    if ((e->name == (char *)0) || (e->fvar == (char *)0)) {
+        free(e->name);
+        free(e->fvar);
+        return (IndexEntry *)0;
+    }
+    memcpy(e->name, name, strlen(name) + 1U);
+    memcpy(e->fvar, fvar, strlen(fvar) + 1U);
+    e->hash = fsHash(name, 0UL);
+    e->etag = 0U;
+    ++l_nIndex;
+    return e;
+}
+/*..........................................................................*/
+static void indexFree(void) {
+    size_t i;
+    for (i = 0U; i < l_nIndex; ++i) {
+        free(l_index[i].name);
+        free(l_index[i].fvar);
+    }
+    free(l_index);
+    l_index    = (IndexEntry *)0;
+    l_nIndex   = 0U;
+    l_capIndex = 0U;
+}
+/*..........................................................................*/
+/* ETags of the files (-e option) for answering If-None-Match with 304.
+* The ETags are kept in step with fs_index[], so the server compares
+* If-None-Match with the ETag of the requested file itself, even when
+* several files have the same content (and hence the same ETag).
+*/
+static void genEtags(size_t const *fileAt) {
+    size_t const n = l_nIndex;
+    size_t i;
+
+    FPRINTF_S(l_file, "%s",
+        "\x0A/* ETags of the files in fs_index[] (0, 0 for none) */\x0A"
+        "struct fs_etag {\x0A"
+        "    unsigned long hi; /* the upper 32 bits of the ETag */\x0A"
+        "    unsigned long lo; /* the lower 32 bits of the ETag */\x0A"
+        "};\x0A\x0A"
+        "struct fs_etag const fs_etag[FS_NUMFILES] = {\x0A");
+    for (i = 0U; i < n; ++i) {
+        IndexEntry const *e = &l_index[fileAt[i]];
+        FPRINTF_S(l_file, "    { 0x%08lXUL, 0x%08lXUL }%s\x0A",
+                  (unsigned long)(e->etag >> 32),
+                  (unsigned long)(e->etag & 0xFFFFFFFFU),
+                  (i + 1U < n) ? "," : "");
+    }
+    FPRINTF_S(l_file, "%s",
+        "};\x0A\x0A"
+        "/* does If-None-Match (e.g., \"0123...\", W/\"...\", a list of\x0A"
+        "* such ETags separated by commas or *) match the current ETag\x0A"
+        "* of the file with the name? The server then answers 304.\x0A"
+        "*/\x0A"
+        "int fs_etag_match(char const *name, char const *ifNoneMatch) {\x0A"
+        "    unsigned const k = fs_slot(name);\x0A"
+        "    char const *s = ifNoneMatch;\x0A"
+        "    if ((k == FS_NUMFILES)\x0A"
+        "        || ((fs_etag[k].hi == 0UL) && (fs_etag[k].lo == 0UL)))\x0A"
+        "    {\x0A"
+        "        return 0; /* no such file or no ETag */\x0A"
+        "    }\x0A"
+        "    while (*s != '\\0') {\x0A"
+        "        unsigned long hi = 0UL;\x0A"
+        "        unsigned long lo = 0UL;\x0A"
+        "        unsigned n = 0U; /* hex digits of the ETag */\x0A"
+        "        while ((*s == ' ') || (*s == '\\t') || (*s == ',')) {\x0A"
+        "            ++s;\x0A"
+        "        }\x0A"
+        "        if (*s == '*') {\x0A"
+        "            return 1; /* any current ETag */\x0A"
+        "        }\x0A"
+        "        if ((s[0] == 'W') && (s[1] == '/')) { /* weak comparison */\x0A"
+        "            s += 2;\x0A"
+        "        }\x0A"
+        "        if (*s != '\"') {\x0A"
+        "            return 0; /* malformed list */\x0A"
+        "        }\x0A"
+        "        for (++s; (*s != '\"') && (*s != '\\0'); ++s, ++n) {\x0A"
+        "            char const c = *s;\x0A"
+        "            unsigned long const x = ((c >= '0') && (c <= '9'))\x0A"
+        "                ? (unsigned long)(c - '0')\x0A"
+        "                : ((c >= 'A') && (c <= 'F'))\x0A"
+        "                    ? (unsigned long)(c - 'A' + 10) : 16UL;\x0A"
+        "            if (x == 16UL) { /* not one of our ETags (n > 16)? */\x0A"
+        "                n = 16U;\x0A"
+        "            }\x0A"
+        "            hi = ((hi << 4) | (lo >> 28)) & 0xFFFFFFFFUL;\x0A"
+        "            lo = ((lo << 4) | x) & 0xFFFFFFFFUL;\x0A"
+        "        }\x0A"
+        "        if (*s != '\"') {\x0A"
+        "            return 0; /* unterminated ETag */\x0A"
+        "        }\x0A"
+        "        ++s;\x0A"
+        "        if ((n == 16U) && (hi == fs_etag[k].hi)\x0A"
+        "            && (lo == fs_etag[k].lo))\x0A"
+        "        {\x0A"
+        "            return 1;\x0A"
+        "        }\x0A"
+        "    }\x0A"
+        "    return 0;\x0A"
+        "}\x0A");
+}
+/*..........................................................................*/
+static size_t const *l_bucketSize; /* for sorting the buckets */
+
+static int cmpBuckets(void const *a, void const *b) {
+    size_t const na = l_bucketSize[*(size_t const *)a];
+    size_t const nb = l_bucketSize[*(size_t const *)b];
+    return (na < nb) ? 1 : ((na > nb) ? -1 : 0);
+}
+/*..........................................................................*/
+static void genIndex(void) {
+    size_t const n = l_nIndex;
+    size_t *bucketSize = (size_t *)calloc(n, sizeof(size_t));
+    size_t *order      = (size_t *)malloc(n * sizeof(size_t));
+    size_t *slotOf     = (size_t *)malloc(n * sizeof(size_t));
+    size_t *fileAt     = (size_t *)malloc(n * sizeof(size_t));
+    size_t *first      = (size_t *)calloc(n + 1U, sizeof(size_t));
+    size_t *members    = (size_t *)malloc(n * sizeof(size_t));
+    unsigned long *seed = (unsigned long *)calloc(n, sizeof(unsigned long));
+    bool ok = (bucketSize != (size_t *)0) && (order != (size_t *)0)
+              && (slotOf != (size_t *)0) && (fileAt != (size_t *)0)
+              && (first != (size_t *)0) && (members != (size_t *)0)
+              && (seed != (unsigned long *)0);
+    size_t i;
+    size_t k;
+
+    if (ok) {
+        for (i = 0U; i < n; ++i) {
+            ++bucketSize[l_index[i].hash % n];
+            slotOf[i] = 0U;
+            order[i]  = i;
+            fileAt[i] = n; /* free slot */
+        }
+        /* group the files by buckets: members[first[b]..first[b+1]) */
+        for (i = 0U; i < n; ++i) {
+            first[i + 1U] = first[i] + bucketSize[i];
+        }
+        for (i = 0U; i < n; ++i) {
+            size_t const b = l_index[i].hash % n;
+            members[first[b] + slotOf[b]] = i;
+            ++slotOf[b];
+        }
+        /* place the largest buckets first, while most slots are free */
+        l_bucketSize = bucketSize;
+        qsort(order, n, sizeof(size_t), &cmpBuckets);
+    }
+    for (k = 0U; ok && (k < n) && (bucketSize[order[k]] != 0U); ++k) {
+        size_t const b = order[k];
+        unsigned long d;
+        for (d = 1UL; d < 0x1000000UL; ++d) { /* find the seed */
+            size_t placed = 0U;
+            for (i = first[b]; i < first[b + 1U]; ++i) {
+                size_t const slot = fsHash(l_index[members[i]].name, d) % n;
+                if (fileAt[slot] != n) { /* collision? */
+                    break;
+                }
+                fileAt[slot] = members[i]; /* tentatively */
+                slotOf[placed++] = slot;
             }
-            else {
-                FPRINTF_S(l_file, "%s", ",\x0A    ");
+            if (placed == bucketSize[b]) { /* all files of the bucket? */
+                seed[b] = d;
+                break;
+            }
+            while (placed != 0U) { /* undo the tentative placement */
+                fileAt[slotOf[--placed]] = n;
             }
         }
-        else if (i < 9) { /* inside the line? */
-            ++i;
-            FPRINTF_S(l_file, "%s", ", ");
+        if (seed[b] == 0UL) {
+            ok = false;
         }
-        else { /* end of line */
-            i = 0;
-            FPRINTF_S(l_file, "%s", ", ");
+    }
+
+    if (!ok) {
+        PRINTF_S("%s", "\nThe lookup index could not be generated.");
+    }
+    else {
+        FPRINTF_S(l_file, "%s",
+            "\x0A/* O(1) lookup of the files by name (minimal perfect hash) "
+            "*/\x0A"
+            "unsigned long const fs_seed[FS_NUMFILES] = {\x0A");
+        for (i = 0U; i < n; ++i) {
+            FPRINTF_S(l_file, "    %luUL%s\x0A", seed[i],
+                      (i + 1U < n) ? "," : "");
+        }
+        FPRINTF_S(l_file, "%s",
+            "};\x0A\x0A"
+            "struct fsdata_file const * const fs_index[FS_NUMFILES] = {\x0A");
+        for (i = 0U; i < n; ++i) {
+            FPRINTF_S(l_file, "    file_%s%s\x0A", l_index[fileAt[i]].fvar,
+                      (i + 1U < n) ? "," : "");
+        }
+        FPRINTF_S(l_file, "%s",
+            "};\x0A\x0A"
+            "static unsigned long fs_hash(char const *name, "
+            "unsigned long seed) {\x0A"
+            "    unsigned long h = 0x811C9DC5UL ^ seed;\x0A"
+            "    for (; *name != '\\0'; ++name) {\x0A"
+            "        h = ((h ^ (unsigned char)*name) * 0x01000193UL)"
+            " & 0xFFFFFFFFUL;\x0A"
+            "    }\x0A"
+            "    h ^= h >> 16;\x0A"
+            "    h = (h * 0x85EBCA6BUL) & 0xFFFFFFFFUL;\x0A"
+            "    h ^= h >> 13;\x0A"
+            "    return h;\x0A"
+            "}\x0A\x0A"
+            "/* the fs_index[] slot of the file with the name, e.g.,\x0A"
+            "* \"/index.htm\", or FS_NUMFILES\x0A"
+            "*/\x0A"
+            "static unsigned fs_slot(char const *name) {\x0A"
+            "    unsigned long const d = "
+            "fs_seed[fs_hash(name, 0UL) % FS_NUMFILES];\x0A"
+            "    unsigned const k = "
+            "(unsigned)(fs_hash(name, d) % FS_NUMFILES);\x0A"
+            "    char const *s = (char const *)fs_index[k]->name;\x0A"
+            "    while ((*s == *name) && (*s != '\\0')) {\x0A"
+            "        ++s;\x0A"
+            "        ++name;\x0A"
+            "    }\x0A"
+            "    return (*s == *name) ? k : FS_NUMFILES;\x0A"
+            "}\x0A\x0A"
+            "/* the file with the name, e.g., \"/index.htm\", or NULL */\x0A"
+            "struct fsdata_file const *fs_find(char const *name) {\x0A"
+            "    unsigned const k = fs_slot(name);\x0A"
+            "    return (k != FS_NUMFILES)\x0A"
+            "        ? fs_index[k] : (struct fsdata_file const *)0;\x0A"
+            "}\x0A");
+        if (l_etags) {
+            genEtags(fileAt);
+        }
+    }
+    free(bucketSize);
+    free(order);
+    free(slotOf);
+    free(fileAt);
+    free(first);
+    free(members);
+    free(seed);
+}
+
+/*..........................................................................*/
+/* content hash for the ETag (-e option): 64-bit FNV-1a, never 0 */
+static uint64_t etagHash(uint64_t h, unsigned char const *data, size_t n) {
+    for (; n != 0U; --n, ++data) {
+        h = (h ^ *data) * 0x100000001B3ULL;
+    }
+    return h;
+}
+#define ETAG_INIT 0xCBF29CE484222325ULL
+
+/*..........................................................................*/
+/* is the file extension of a text file worth compressing (-z option)? */
+static bool isCompressible(char const *ext) {
+    static char const * const exts[] = {
+        ".htm", ".html", ".css", ".js", ".json", ".svg", ".xml", ".txt"
+    };
+    size_t i;
+    for (i = 0U; i < sizeof(exts)/sizeof(exts[0]); ++i) {
+        if (strcmp(ext, exts[i]) == 0) {
+            return true;
         }
-        FPRINTF_S(l_file, "0x%02X", ((unsigned)*s & 0xFF));
-        ++s;
-        ++len;
     }
-    if (i == 0) {
-        FPRINTF_S(l_file, "%s", "    ");
+    return false;
+}
+/*..........................................................................*/
+/* gzip-compress the whole file (-z option). Returns the compressed data
+* (to be freed by the caller) or NULL when the compression doesn't pay,
+* in which case the file is rewound to be read again.
+*/
+static unsigned char *compressFile(FILE *fin, size_t *zLen, size_t *len) {
+    size_t size = 0U;
+    size_t cap = IN_SIZE;
+    unsigned char *data = (unsigned char *)malloc(cap);
+    unsigned char *z = (unsigned char *)0;
+    size_t n;
+    while ((data != (unsigned char *)0)
+           && ((n = FREAD_S(&data[size], cap - size,
+                            1U, cap - size, fin)) != 0U))
+    {
+        size += n;
+        if (size == cap) {
+            unsigned char *p = (unsigned char *)realloc(data, 2U * cap);
+            if (p == (unsigned char *)0) {
+                free(data);
+            }
+            data = p;
+            cap *= 2U;
+        }
+    }
+    if ((data != (unsigned char *)0) && (size != 0U)) {
+        z = (unsigned char *)malloc(size);
+        if (z != (unsigned char *)0) {
+            *zLen = gzipCompress(data, size, z, size);
+            /* pays off? at least 10% smaller incl. the extra header lines */
+            if ((*zLen == 0U) || ((*zLen + 64U) * 10U > size * 9U)) {
+                free(z);
+                z = (unsigned char *)0;
+            }
+        }
+    }
+    free(data);
+    if (z == (unsigned char *)0) {
+        rewind(fin);
+    }
+    *len = size;
+    return z;
+}
+/*..........................................................................*/
+/* append the data bytes to the binary image or the hex dump */
+static void dataWrite(unsigned char const *data, size_t n) {
+    if (l_binFile != (FILE *)0) {
+        binWrite(data, n);
+    }
+    else {
+        hexWrite(data, n);
     }
 }
 /*..........................................................................*/
@@ -86,14 +521,19 @@ unsigned isMatching(char const *fullPath) {
 /*..........................................................................*/
 void onMatchFound(char const *fullPath, unsigned flags, int ro_info) {
     static char buf[1024]; /* working buffer */
+    static unsigned char inBuf[IN_SIZE]; /* input blocks of the file */
     char const *fname = strstr(fullPath, l_fsDir);
     FILE *fin;
     char const *s;
     char *d;
     char fvar[256];
-    size_t len;
     size_t nBytes;
-    size_t i;
+    unsigned long nameOffset = 0UL; /* offsets in the binary image */
+    unsigned long dataOffset = 0UL;
+    unsigned char *zData = (unsigned char *)0; /* gzip-compressed data */
+    size_t zLen = 0U;
+    size_t len = 0U;
+    IndexEntry *entry = (IndexEntry *)0; /* for the -i and -e options */
 
     (void)flags;
     (void)ro_info;
@@ -142,11 +582,22 @@ void onMatchFound(char const *fullPath, unsigned flags, int ro_info) {
         ++d;
     }
     *d = '\0';
+    if (l_genIndex) {
+        entry = indexAdd(buf, fvar);
+    }
 
-    FPRINTF_S(l_file, "static unsigned char const data_%s[] = {\x0A", fvar);
-    FPRINTF_S(l_file, "%s", "    /* name: */\x0A");
-    dumpStrHex(buf); /* dump the file name */
-    FPRINTF_S(l_file, "%s", ", 0x00,\x0A"); /* zero-terminate */
+    if (l_binFile != (FILE *)0) { /* binary image? */
+        nameOffset = l_binOffset;
+        binWrite(buf, strlen(buf) + 1U); /* zero-terminated file name */
+    }
+    else {
+        FPRINTF_S(l_file, "static unsigned char const data_%s[] = {\x0A",
+                  fvar);
+        FPRINTF_S(l_file, "%s", "    /* name: */\x0A");
+        dumpStrHex(buf); /* dump the file name */
+        FPRINTF_S(l_file, "%s", ", 0x00,\x0A"); /* zero-terminate */
+    }
+    dataOffset = l_binOffset;
 
     if (l_genHttpHeaders) { /* encode HTTP header, if option -h provided */
         if (strstr(fname, "404") != 0) {
@@ -202,45 +653,93 @@ void onMatchFound(char const *fullPath, unsigned flags, int ro_info) {
         else {
             STRCAT_S(buf, sizeof(buf), "Content-type: text/plain\r\x0A");
         }
-        STRCAT_S(buf, sizeof(buf), "\r\x0A");
 
-        FPRINTF_S(l_file, "%s", "    /* HTTP header: */\x0A");
-        dumpStrHex(buf);
-        FPRINTF_S(l_file, "%s", ",\x0A");
-    }
-
-    FPRINTF_S(l_file, "%s", "    /* data: */\x0A");
-    len = 0;
-    i = 0;
-    while ((nBytes = fread(buf, 1, sizeof(buf), fin)) != 0) {
-        char const *pc = buf;
-        size_t n = nBytes;
-        while (n-- != 0) {
-            if (i == 0) { /* new line? */
-                ++i;
-                if (len == 0) { /* beginning of the file? */
-                    FPRINTF_S(l_file, "%s", "    ");
-                }
-                else {
-                    FPRINTF_S(l_file, "%s", ",\x0A    ");
-                }
+        /* pre-compressed text file? */
+        if (l_gzip && (s != 0) && isCompressible(s)) {
+            zData = compressFile(fin, &zLen, &len);
+        }
+        if (zData != (unsigned char *)0) {
+            char hdr[64];
+            SNPRINTF_S(hdr, sizeof(hdr), "Content-Length: %lu\r\x0A",
+                       (unsigned long)zLen);
+            STRCAT_S(buf, sizeof(buf), "Content-Encoding: gzip\r\x0A");
+            STRCAT_S(buf, sizeof(buf), hdr);
+        }
+
+        /* ETag of the stored data (not for .shtm/.shtml files, whose
+        * header is already terminated, as they are not static)
+        */
+        if (l_etags && (entry != (IndexEntry *)0)
+            && (strstr(buf, "\r\x0A\r\x0A") == (char *)0))
+        {
+            uint64_t etag = ETAG_INIT;
+            char hdr[64];
+            if (zData != (unsigned char *)0) {
+                etag = etagHash(etag, zData, zLen);
             }
-            else if (i < 9) { /* inside the line? */
-                ++i;
-                FPRINTF_S(l_file, "%s", ", ");
+            else {
+                while ((nBytes = FREAD_S(inBuf, IN_SIZE,
+                                         1U, IN_SIZE, fin)) != 0U)
+                {
+                    etag = etagHash(etag, inBuf, nBytes);
+                }
+                rewind(fin);
             }
-            else { /* end of line */
-                i = 0;
-                FPRINTF_S(l_file, "%s", ", ");
+            if (etag == 0U) {
+                etag = 1U; /* 0 is reserved for "no ETag" */
             }
-            FPRINTF_S(l_file, "0x%02X", ((unsigned)*pc & 0xFF));
-            ++pc;
-            len += nBytes;
+            entry->etag = etag;
+            SNPRINTF_S(hdr, sizeof(hdr), "ETag: \"%08lX%08lX\"\r\x0A",
+                       (unsigned long)(etag >> 32),
+                       (unsigned long)(etag & 0xFFFFFFFFU));
+            STRCAT_S(buf, sizeof(buf), hdr);
+            STRCAT_S(buf, sizeof(buf), "Cache-Control: no-cache\r\x0A");
+        }
+        STRCAT_S(buf, sizeof(buf), "\r\x0A");
+
+        if (l_binFile != (FILE *)0) { /* binary image? */
+            binWrite(buf, strlen(buf));
+        }
+        else {
+            FPRINTF_S(l_file, "%s", "    /* HTTP header: */\x0A");
+            dumpStrHex(buf);
+            FPRINTF_S(l_file, "%s", ",\x0A");
+        }
+    }
+
+    if (l_binFile == (FILE *)0) {
+        FPRINTF_S(l_file, "%s", "    /* data: */\x0A");
+        hexBegin();
+    }
+    if (zData != (unsigned char *)0) {
+        dataWrite(zData, zLen);
+        free(zData);
+        PRINTF_S(" (gzip %lu->%lu bytes)",
+                 (unsigned long)len, (unsigned long)zLen);
+    }
+    else {
+        while ((nBytes = FREAD_S(inBuf, IN_SIZE, 1U, IN_SIZE, fin)) != 0U) {
+            dataWrite(inBuf, nBytes);
         }
     }
-    FPRINTF_S(l_file, "%s", "\x0A};\x0A\x0A");
     fclose(fin);
 
+    if (l_binFile != (FILE *)0) { /* binary image? */
+        /* the file references the name and data in the image by offset */
+        FPRINTF_S(l_file, "struct fsdata_file const file_%s[] = {\x0A"
+                  "    {\x0A", fvar);
+        FPRINTF_S(l_file, "        %s,\x0A", l_prevFile);
+        FPRINTF_S(l_file, "        &FSDATA_IMAGE[%lu],\x0A", nameOffset);
+        FPRINTF_S(l_file, "        &FSDATA_IMAGE[%lu],\x0A", dataOffset);
+        FPRINTF_S(l_file, "        %lu\x0A", l_binOffset - dataOffset);
+        FPRINTF_S(l_file, "%s", "    }\x0A};\x0A\x0A");
+        SNPRINTF_S(l_prevFile, sizeof(l_prevFile) - 1U, "file_%s", fvar);
+        return;
+    }
+
+    hexEnd();
+    FPRINTF_S(l_file, "%s", "\x0A};\x0A\x0A");
+
     FPRINTF_S(l_file, "struct fsdata_file const file_%s[] = {\x0A    {\x0A",
               fvar);
     FPRINTF_S(l_file, "        %s,\x0A",      l_prevFile);
@@ -255,14 +754,20 @@ void onMatchFound(char const *fullPath, unsigned flags, int ro_info) {
 /*..........................................................................*/
 int main(int argc, char *argv[]) {
     char const *fileName = "fsdata.h";
+    bool genBinary = false;
 
     PRINTF_S("QFSGen %s Copyright (c) 2005 Quantum Leaps\n"
              "Documentation: https://state-machine.com/qtools/qfsgen.html\n",
              VERSION);
-    PRINTF_S("Usage: qfsgen fs-dir [output-file] [-h]\n"
+    PRINTF_S("Usage: qfsgen fs-dir [output-file] [-h] [-z] [-e] [-b] [-i]\n"
              "       fs-dir      file-system directory (must be provided)\n"
              "       output-file optional (default is %s)\n"
-             "       -h          generate the HTTP headers\n",
+             "       -h          generate the HTTP headers\n"
+             "       -z          gzip-compress text files (requires -h)\n"
+             "       -e          generate ETags and fs_etag_match() (requires -h,\n"
+             "                   implies -i)\n"
+             "       -b          generate binary image output-file.bin\n"
+             "       -i          generate the O(1) lookup index fs_find()\n",
              fileName);
 
     /* parse the command line... */
@@ -271,18 +776,30 @@ int main(int argc, char *argv[]) {
         return -1;
     }
     else {
+        int i;
         l_fsDir = argv[1];
-        if (argc > 2) {
-            if (strcmp(argv[2], "-h") == 0) {
+        for (i = 2; i < argc; ++i) {
+            if (strcmp(argv[i], "-h") == 0) {
                 l_genHttpHeaders = true;
             }
-            else {
-                fileName = argv[2];
+            else if (strcmp(argv[i], "-e") == 0) {
+                l_etags = true;
             }
-            if (argc > 3) {
-                if (strcmp(argv[3], "-h") == 0) {
-                    l_genHttpHeaders = true;
-                }
+            else if (strcmp(argv[i], "-i") == 0) {
+                l_genIndex = true;
+            }
+            else if (strcmp(argv[i], "-z") == 0) {
+                l_gzip = true;
+            }
+            else if (strcmp(argv[i], "-b") == 0) {
+                genBinary = true;
+            }
+            else if ((argv[i][0] != '-') && (i == 2)) {
+                fileName = argv[i];
+            }
+            else {
+                PRINTF_S("unknown option %s\n", argv[i]);
+                return -1;
             }
         }
     }
@@ -290,6 +807,43 @@ int main(int argc, char *argv[]) {
     PRINTF_S("outut-file  : %s\n", fileName);
     PRINTF_S("HTTP headers: %s\n", l_genHttpHeaders
                                  ? "generated" : "not-generated");
+    if (l_gzip) {
+        if (!l_genHttpHeaders) { /* no header for Content-Encoding? */
+            l_gzip = false;
+        }
+        PRINTF_S("gzip text   : %s\n", l_gzip
+                                 ? "compressed" : "ignored without -h");
+    }
+    if (l_etags) {
+        if (!l_genHttpHeaders) { /* no header for the ETag? */
+            l_etags = false;
+        }
+        else {
+            l_genIndex = true; /* the ETags are kept in step with fs_index[] */
+        }
+        PRINTF_S("ETags       : %s\n", l_etags
+                                 ? "generated" : "ignored without -h");
+    }
+
+    if (genBinary) { /* binary image next to the output file? */
+        char *ext;
+        STRNCPY_S(l_binName, sizeof(l_binName) - 4U, fileName);
+        ext = strrchr(l_binName, '.');
+        if ((ext != (char *)0)
+            && (strchr(ext, '/') == (char *)0)
+            && (strchr(ext, '\\') == (char *)0))
+        {
+            *ext = '\0'; /* replace the extension */
+        }
+        STRCAT_S(l_binName, sizeof(l_binName), ".bin");
+        PRINTF_S("binary image: %s\n", l_binName);
+
+        FOPEN_S(l_binFile, l_binName, "wb");
+        if (l_binFile == (FILE *)0) {
+            PRINTF_S("File %s could not be opened for writing.", l_binName);
+            return -1;
+        }
+    }
 
     /* binary to use LF EOL convention */
     FOPEN_S(l_file, fileName, "wb");
@@ -300,12 +854,58 @@ int main(int argc, char *argv[]) {
 
     FPRINTF_S(l_file, "%s", "/* This file has been generated "
                     "with the qfsgen utility. */\x0A\x0A");
+    if (l_binFile != (FILE *)0) {
+        char sym[sizeof(l_binName)];
+        char *d;
+        STRNCPY_S(sym, sizeof(sym), l_binName);
+        for (d = sym; *d != '\0'; ++d) { /* symbol name used by objcopy */
+            if (!(((*d >= 'a') && (*d <= 'z'))
+                  || ((*d >= 'A') && (*d <= 'Z'))
+                  || ((*d >= '0') && (*d <= '9'))))
+            {
+                *d = '_';
+            }
+        }
+        FPRINTF_S(l_file,
+            "/* The names and data of the files are in the binary image\x0A"
+            "* %s, which must be linked as the FSDATA_IMAGE array, e.g.:\x0A"
+            "* - GNU assembler:\x0A"
+            "*       .section .rodata\x0A"
+            "*       .global fsdata_image\x0A"
+            "*   fsdata_image:\x0A"
+            "*       .incbin \"%s\"\x0A"
+            "* - objcopy -I binary -O <bfd-name> -B <arch> %s <file.o>\x0A"
+            "*   and -DFSDATA_IMAGE=_binary_%s_start\x0A"
+            "*/\x0A"
+            "#ifndef FSDATA_IMAGE\x0A"
+            "#define FSDATA_IMAGE fsdata_image\x0A"
+            "#endif\x0A"
+            "extern unsigned char const FSDATA_IMAGE[];\x0A\x0A",
+            l_binName, l_binName, l_binName, sym);
+    }
     l_nFiles = 0;
     STRNCPY_S(l_prevFile, sizeof(l_prevFile), "(struct fsdata_file *)0");
+    hexInit();
     filesearch(l_fsDir); /* search through the file-system directory tree */
     FPRINTF_S(l_file, "#define FS_ROOT %s\x0A\x0A", l_prevFile);
     FPRINTF_S(l_file, "#define FS_NUMFILES %d\x0A", l_nFiles);
-    fclose(l_file);
+    if (l_genIndex && (l_nFiles > 0)) {
+        genIndex();
+    }
+    indexFree();
+    if ((ferror(l_file) != 0) | (fclose(l_file) != 0)) { /* always close */
+        l_wrErr = true;
+        PRINTF_S("\nFile %s could not be written.", fileName);
+    }
+    if (l_binFile != (FILE *)0) {
+        if ((ferror(l_binFile) != 0) | (fclose(l_binFile) != 0)) {
+            l_wrErr = true;
+            PRINTF_S("\nFile %s could not be written.", l_binName);
+        }
+    }
+    if (l_wrErr) {
+        return -1; /* the output is incomplete */
+    }
 
     PRINTF_S("\n---------------------------------------"
            "----------------------------------------\n"
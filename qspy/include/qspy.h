@@ -97,6 +97,7 @@ void QSPY_configTxReset(QSPY_resetFun txResetFun);
 void QSPY_configMatFile(void *matFile);
 
 void QSPY_reset(void);
+void QSPY_resync(void); // start parsing at the next frame (e.g., after a seek)
 void QSPY_parse(uint8_t const *buf, uint32_t nBytes);
 void QSPY_txReset(void);
 
@@ -175,6 +176,33 @@ enum QSpyGroups_plus {
 // returns the "group" of a given QS record-ID
 int QSPY_getGroup(int recId);
 
+// returns the name of a given QS record-ID, e.g. "QS_QF_PUBLISH",
+// or NULL for a user record without an entry in the user dictionary
+char const *QSPY_getRecName(int recId);
+char const *QSPY_getRecFields(int recId); // e.g., "t,sig,obj,state"
+bool QSPY_hasTstamp(int recId); // does the record start with the timestamp?
+
+// host-side filter applied right after deframing, so that the records
+// filtered out are neither decoded nor output (but still captured).
+// The object filter applies to the "obj" field (or to the "sender" field
+// of the records without "obj", such as QS_QF_PUBLISH), but not to the
+// secondary objects ("ao", "queue", "sender" of a post). The signal filter
+// applies to the "sig" field (see QSPY_getRecFields()). The records
+// without the filtered field (e.g., the scheduler records) pass the
+// object/signal filters, so use the record map to exclude them.
+// The INF and DIC records always pass.
+typedef struct {
+    uint8_t recMap[16]; // record-IDs passing the filter (bitmap)
+    bool    hasObj;     // filter by the "obj" field?
+    bool    hasSig;     // filter by the "sig" field?
+    KeyType obj;        // the object to pass
+    SigType sig;        // the signal to pass
+} QSpyHostFilter;
+
+void QSPY_setHostFilter(QSpyHostFilter const *filter); // NULL: pass all
+void QSPY_getHostFilter(QSpyHostFilter *filter);
+void QSPY_hostFilter(QSpyRecord * const qrec); // FE packet QSPY_HOST_FILTER
+
 // last output generated
 extern QSPY_LastOutput QSPY_output;
 
@@ -287,6 +315,8 @@ typedef enum {
     QSPY_SEND_TEST_PROBE, // send Test-Probe (QSPY supplying apiId)
     QSPY_CLEAR_SCREEN,    // clear the QSPY screen
     QSPY_SHOW_NOTE,       // show a note in QSPY output
+    QSPY_HOST_FILTER,     // set the host-side filter in QSPY
+    QSPY_QUERY_QUEUES,    // report the queue model of QSPY
     // ...
 } QSpyCommands;
 
@@ -325,6 +355,158 @@ void QSEQ_genAnnotation(uint32_t tstamp, int obj, char const* ann);
 void QSEQ_genTick(uint32_t rate, uint32_t nTick);
 void QSEQ_dictionaryReset(void);
 
+// the numbers (and strings) of the Matlab output of a record, in the
+// order of the text output, which feed the binary outputs below
+typedef enum {
+    QSPY_VAL_I32, // %d
+    QSPY_VAL_U32, // %u, %x
+    QSPY_VAL_I64, // %ld, %lld, PRId64
+    QSPY_VAL_U64, // %lu, %llu, PRIu64
+    QSPY_VAL_F64, // %e, %f, %g
+    QSPY_VAL_STR, // %s
+} QSpyValType;
+
+typedef struct {
+    QSpyValType type;
+    union {
+        int64_t     i; // QSPY_VAL_I32, QSPY_VAL_I64
+        uint64_t    u; // QSPY_VAL_U32, QSPY_VAL_U64
+        double      f; // QSPY_VAL_F64
+        char const *s; // QSPY_VAL_STR (valid only until the end of the row)
+    } u;
+} QSpyVal;
+
+// binary MAT-file (Level 5) Matlab output, used instead of the text
+// output of QSPY_configMatFile(). The file must be opened for writing in
+// binary mode, and the MAT-file is completed when the output is closed by
+// calling QMAT_configFile() again (e.g., with NULL).
+void QMAT_configFile(void *matFile);
+bool QMAT_isActive(void);
+void QMAT_putVal(QSpyVal const *val);
+void QMAT_endRow(void);
+
+// NumPy output: a .npz archive with one column array per field of every
+// record type. The file must be opened for writing in binary mode, and
+// the archive is completed when the output is closed by calling
+// QNPY_configFile() again (e.g., with NULL).
+void QNPY_configFile(void *npzFile);
+bool QNPY_isActive(void);
+void QNPY_putVal(QSpyVal const *val);
+void QNPY_endRow(void);
+
+// trace-event (JSON) output for the Chrome and Perfetto trace viewers with
+// the RTC steps, ISRs, event posts, queue levels and the scheduler activity.
+// The file is written while the records arrive, and it is completed when the
+// output is closed by calling QTRC_configFile() again (e.g., with NULL).
+// The tickUs is the duration of the QS timestamp tick in microseconds.
+void QTRC_configFile(void *traceFile, double tickUs);
+bool QTRC_isActive(void);
+void QTRC_putVal(QSpyVal const *val);
+void QTRC_endRow(void);
+
+// capture container (.qsc): the QS records in blocks of frames with the
+// index of the blocks and the QSPY configuration with the dictionaries.
+// The file must be opened for writing in binary mode, and the container is
+// completed when the output is closed by calling QCAP_configFile() again
+// (e.g., with NULL). The records are added by QSPY_parse().
+void QCAP_configFile(void *capFile);
+bool QCAP_isActive(void);
+void QCAP_putRecord(uint8_t const *rec, uint32_t nBytes);
+
+// block of the capture container; the timestamps are in the ticks of the
+// QS timestamp extended to 64 bits and the sequence numbers are the QS
+// sequence numbers extended to 64 bits (both counted from the capture start)
+typedef struct {
+    uint64_t offset;   // offset of the block data in the file
+    uint32_t size;     // size of the block data [bytes]
+    uint32_t nRecs;    // number of records in the block
+    uint64_t seqFirst; // sequence number of the first record
+    uint64_t seqLast;  // sequence number of the last record
+    uint64_t tFirst;   // the first timestamp in the block
+    uint64_t tLast;    // the last timestamp in the block
+    uint8_t  recMap[32]; // bitmap of the record-IDs in the block
+    uint8_t  tstampSize; // size of the timestamps in the block
+    bool     hasTstamp;  // does the block have any timestamps?
+} QCapBlock;
+
+// opens the capture container for reading (the file must be opened for
+// reading in binary mode) and restores the QSPY configuration and the
+// dictionaries saved in the container. Returns the number of blocks or -1
+// when the file is not a capture container. The previously opened file is
+// closed, and QCAP_open(NULL) only closes it.
+int QCAP_open(void *capFile);
+QCapBlock const *QCAP_getBlock(uint32_t idx);
+uint32_t QCAP_findBlock(uint64_t tstamp); // first block ending at/after
+
+// the records are decoded by QSPY_parse() only within the time window
+// [tFrom..tTo] and only for the record-IDs in the recMap bitmap (all
+// record-IDs for recMap==NULL), the other records are skipped unparsed
+bool QCAP_hasRecs(uint32_t idx, uint8_t const *recMap);
+uint32_t QCAP_decodeBlock(uint32_t idx, uint64_t tFrom, uint64_t tTo,
+                          uint8_t const *recMap);
+uint32_t QCAP_decode(uint64_t tFrom, uint64_t tTo, uint8_t const *recMap);
+
+// query over the capture container: the records selected by type, object,
+// signal and time window, counted in groups with the statistics of a value
+// field. QQRY_main() is the entry point of the query mode of QSPY (the
+// command-line option -Q followed by the query options; see -Q -h), where
+// QSPY should not print the decoded records.
+int  QQRY_main(int argc, char *argv[]);
+bool QQRY_isActive(void);
+void QQRY_putVal(QSpyVal const *val);
+void QQRY_endRow(void);
+
+// live model of the event queues of the active objects and of the raw
+// event queues, updated from the Free/Min fields of the queue records.
+// The window [QS timestamp ticks] is the period of the windowed low-water
+// mark and of the post/get counts (0 disables the model). A queue is
+// flagged (warn) when at the trend of the last window it would run out of
+// the free entries within two windows, or when it ran out (or a post
+// failed the margin) in the last window.
+typedef struct {
+    KeyType  obj;      // the queue (the AO or the QEQueue object)
+    bool     isAO;     // the queue of an active object?
+    bool     warn;     // trending toward an overflow?
+    uint32_t nFree;    // current free entries
+    uint32_t maxFree;  // max free entries seen (empty queue)
+    uint32_t minAll;   // all-time low-water mark of the free entries
+    uint32_t minWin;   // low-water mark in the last and current window
+    uint32_t posts;    // posts in the last complete window
+    uint32_t gets;     // gets in the last complete window
+    int32_t  trend;    // change of the free entries in the last window
+    uint64_t nPost;    // all posts
+    uint64_t nGet;     // all gets
+    uint64_t nAttempt; // all posts that failed the margin
+} QQueStat;
+
+void QQUE_config(uint32_t window);
+bool QQUE_isActive(void);
+void QQUE_putVal(QSpyVal const *val);
+void QQUE_endRow(void);
+uint32_t QQUE_getCount(void);
+QQueStat const *QQUE_getAt(uint32_t idx); // in the order of appearance
+QQueStat const *QQUE_find(KeyType obj);
+void QQUE_report(void); // FE packet QSPY_QUERY_QUEUES
+
+// demand-driven Target filters: the Global/Local-Filters pushed to the
+// Target through QSPY_encode() are the union of the records needed by the
+// attached consumers and by the active outputs, limited to the records
+// passing the host-side filter. QFLT_update() pushes the filters when
+// they change (e.g., after the outputs are toggled) or always for force.
+enum QFltConsumers {
+    QFLT_TEXT, // human-readable output (screen or text file)
+    QFLT_FE,   // the attached Front-End
+    QFLT_MAX
+};
+void QFLT_config(bool enable);
+bool QFLT_isActive(void);
+void QFLT_attach(int consumer,  // the bitmaps NULL mean all
+                 uint8_t const *glbMap, uint8_t const *locMap);
+void QFLT_detach(int consumer);
+void QFLT_update(bool force);
+
+bool QSPY_isMatFileActive(void);
+
 void QSPY_configChanged(void);
 
 #endif // QSPY_APP
@@ -18,6 +18,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
 #include <time.h>
 #include <inttypes.h>
 
@@ -243,10 +245,19 @@ static char const *  l_qs_rx_rec[] = {
 // facilities for QSPY host application only (but not for QSPY parser)
 #ifdef QSPY_APP
 
-#define FPRINF_MATFILE(format_, ...)                \
+#define FPRINF_MATFILE(format_, ...) do {            \
     if (l_matFile != (FILE *)0) {                   \
         FPRINTF_S(l_matFile, format_, __VA_ARGS__); \
-    } else (void)0
+    }                                               \
+    if (QMAT_isActive() || QNPY_isActive()          \
+        || QTRC_isActive() || QQRY_isActive()       \
+        || QQUE_isActive())                         \
+    {                                               \
+        QSPY_putMatVals(format_, __VA_ARGS__);      \
+    }                                               \
+} while (0)
+
+static void QSPY_putMatVals(char const *format, ...);
 
 #else
 
@@ -300,6 +311,12 @@ void QSPY_configMatFile(void *matFile) {
     }
     l_matFile = (FILE *)matFile;
 }
+#ifdef QSPY_APP
+//............................................................................
+bool QSPY_isMatFileActive(void) {
+    return l_matFile != (FILE *)0;
+}
+#endif
 
 //............................................................................
 void QSpyRecord_init(QSpyRecord * const me,
@@ -1752,6 +1769,10 @@ static void QSpyRecord_process(QSpyRecord * const me) {
                     if (l_txResetFun != (QSPY_resetFun)0) {
                         (*l_txResetFun)();
                     }
+#ifdef QSPY_APP
+                    // the Target starts with its own filters after reset
+                    QFLT_update(true);
+#endif
                 }
                 // config changed and this is not the first target info?
                 else if ((d != 0U) && (c != 0U)) {
@@ -2153,6 +2174,10 @@ static uint8_t *l_pos   = l_record; // position within the record
 static uint8_t l_chksum = 0U;
 static uint8_t l_esc    = 0U;
 static uint8_t l_seq    = 0U;
+static bool    l_isJustStarted = true;
+
+static bool    l_hostFilterOn  = false; // any host-side filter set?
+static bool QSPY_hostFilterPass(QSpyRecord const * const qrec);
 
 //............................................................................
 void QSPY_reset(void) {
@@ -2162,9 +2187,14 @@ void QSPY_reset(void) {
     l_seq    = 0U;
 }
 //............................................................................
+void QSPY_resync(void) {
+    l_pos    = l_record; // position within the record
+    l_chksum = 0U;
+    l_esc    = 0U;
+    l_isJustStarted = true; // don't check the sequence of the next record
+}
+//............................................................................
 void QSPY_parse(uint8_t const *buf, uint32_t nBytes) {
-    static bool isJustStarted = true;
-
     for (; nBytes != 0U; --nBytes) {
         uint8_t b = *buf++;
 
@@ -2199,7 +2229,7 @@ void QSPY_parse(uint8_t const *buf, uint32_t nBytes) {
         }
         else if (b == QS_FRAME) { // frame byte?
             if (l_chksum != QS_GOOD_CHKSUM) { // bad checksum?
-                if (!isJustStarted) {
+                if (!l_isJustStarted) {
                     SNPRINTF_LINE("   <COMMS> ERROR    %s",
                                   "Bad checksum in ");
                     if (l_record[1] < QS_USER) {
@@ -2232,7 +2262,7 @@ void QSPY_parse(uint8_t const *buf, uint32_t nBytes) {
                 int parse = 1;
                 ++l_seq; // increment with natural wrap-around
 
-                if (!isJustStarted) {
+                if (!l_isJustStarted) {
                     // data discontinuity found?
                     // but not for the QS_EMPTY record?
 
@@ -2246,13 +2276,21 @@ void QSPY_parse(uint8_t const *buf, uint32_t nBytes) {
                     }
                 }
                 else {
-                    isJustStarted = false;
+                    l_isJustStarted = false;
                 }
                 l_seq = l_record[0];
 
+#ifdef QSPY_APP
+                if (QCAP_isActive()) {
+                    QCAP_putRecord(l_record, (uint32_t)(l_pos - l_record));
+                }
+#endif
                 QSpyRecord_init(&qrec, l_record, (int32_t)(l_pos - l_record));
 
-                if (l_custParseFun != (QSPY_CustParseFun)0) {
+                if (l_hostFilterOn && !QSPY_hostFilterPass(&qrec)) {
+                    parse = 0; // filtered out on the host (not decoded)
+                }
+                else if (l_custParseFun != (QSPY_CustParseFun)0) {
                     parse = (*l_custParseFun)(&qrec);
                     if (parse) {
                         // re-initialize the record for parsing again
@@ -2343,6 +2381,360 @@ int QSPY_getGroup(int recId) {
         ? l_recRender[recId].group
         : QS_GRP_UA;
 }
+//............................................................................
+char const *QSPY_getRecName(int recId) {
+    if (recId < QS_USER) { // is it a Predefined record?
+        return l_recRender[recId].name;
+    }
+    int const idx = Dictionary_find(&QSPY_usrDict, recId);
+    return (idx >= 0)
+        ? Dictionary_at(&QSPY_usrDict, (unsigned)idx)
+        : (char const *)0;
+}
+//............................................................................
+// names of the fields of the predefined records, in the order of the
+// Matlab output (NOTE: keep in synch with QSpyRecord_process())
+static char const * const l_recFields[QS_USER] = {
+    [QS_QEP_STATE_ENTRY]         = "obj,state",
+    [QS_QEP_STATE_EXIT]          = "obj,state",
+    [QS_QEP_STATE_INIT]          = "obj,source,target",
+    [QS_QEP_TRAN_HIST]           = "obj,source,target",
+    [QS_RESERVED_56]             = "obj,source,target",
+    [QS_RESERVED_57]             = "obj,source,target",
+    [QS_QEP_INIT_TRAN]           = "t,obj,target",
+    [QS_QEP_INTERN_TRAN]         = "t,sig,obj,state",
+    [QS_QEP_TRAN]                = "t,sig,obj,source,target",
+    [QS_QEP_IGNORED]             = "t,sig,obj,state",
+    [QS_QEP_DISPATCH]            = "t,sig,obj,state",
+    [QS_QEP_UNHANDLED]           = "sig,obj,state",
+
+    [QS_QF_ACTIVE_DEFER]         = "t,obj,queue,sig,pool,ref",
+    [QS_QF_ACTIVE_DEFER_ATTEMPT] = "t,obj,queue,sig,pool,ref",
+    [QS_QF_ACTIVE_RECALL]        = "t,obj,queue,sig,pool,ref",
+    [QS_QF_ACTIVE_RECALL_ATTEMPT]= "t,obj,queue",
+    [QS_QF_ACTIVE_SUBSCRIBE]     = "t,sig,obj",
+    [QS_QF_ACTIVE_UNSUBSCRIBE]   = "t,sig,obj",
+    [QS_QF_ACTIVE_POST]          = "t,sender,sig,obj,pool,ref,free,min",
+    [QS_QF_ACTIVE_POST_ATTEMPT]  = "t,sender,sig,obj,pool,ref,free,margin",
+    [QS_QF_ACTIVE_POST_LIFO]     = "t,sig,obj,pool,ref,free,min",
+    [QS_QF_ACTIVE_GET]           = "t,sig,obj,pool,ref,free",
+    [QS_QF_ACTIVE_GET_LAST]      = "t,sig,obj,pool,ref",
+
+    [QS_QF_EQUEUE_POST]          = "t,sig,obj,pool,ref,free,min",
+    [QS_QF_EQUEUE_POST_ATTEMPT]  = "t,sig,obj,pool,ref,free,margin",
+    [QS_QF_EQUEUE_POST_LIFO]     = "t,sig,obj,pool,ref,free,min",
+    [QS_QF_EQUEUE_GET]           = "t,sig,obj,pool,ref,free",
+    [QS_QF_EQUEUE_GET_LAST]      = "t,sig,obj,pool,ref",
+
+    [QS_QF_MPOOL_GET]            = "t,obj,free,min",
+    [QS_QF_MPOOL_GET_ATTEMPT]    = "t,obj,free,margin",
+    [QS_QF_MPOOL_PUT]            = "t,obj,free",
+
+    [QS_QF_NEW]                  = "t,size,sig",
+    [QS_QF_NEW_ATTEMPT]          = "t,size,sig",
+    [QS_QF_PUBLISH]              = "t,sender,sig,pool",
+    [QS_QF_NEW_REF]              = "t,sig,pool,ref",
+    [QS_QF_DELETE_REF]           = "t,sig,pool,ref",
+    [QS_QF_GC]                   = "t,sig,pool,ref",
+    [QS_QF_GC_ATTEMPT]           = "t,sig,pool,ref",
+    [QS_QF_TICK]                 = "ctr",
+    [QS_QF_CRIT_ENTRY]           = "t,nest",
+    [QS_QF_CRIT_EXIT]            = "t,nest",
+    [QS_QF_ISR_ENTRY]            = "t,nest,prio",
+    [QS_QF_ISR_EXIT]             = "t,nest,prio",
+
+    [QS_QF_TIMEEVT_ARM]          = "t,obj,ao,ctr,interval",
+    [QS_QF_TIMEEVT_DISARM]       = "t,obj,ao,ctr,interval",
+    [QS_QF_TIMEEVT_AUTO_DISARM]  = "obj,ao",
+    [QS_QF_TIMEEVT_DISARM_ATTEMPT] = "t,obj,ao",
+    [QS_QF_TIMEEVT_REARM]        = "t,obj,ao,ctr,interval,was",
+    [QS_QF_TIMEEVT_POST]         = "t,obj,sig,ao",
+
+    [QS_SCHED_PREEMPT]           = "t,prev,prio",
+    [QS_SCHED_RESTORE]           = "t,prev,prio",
+    [QS_SCHED_LOCK]              = "t,prev,ceil",
+    [QS_SCHED_UNLOCK]            = "t,prev,ceil",
+    [QS_SCHED_NEXT]              = "t,prio,prev",
+    [QS_SCHED_IDLE]              = "t,prev",
+
+    [QS_ASSERT_FAIL]             = "t,loc,module",
+
+    [QS_SEM_TAKE]                = "t,obj,thread,count",
+    [QS_SEM_BLOCK]               = "t,obj,thread,count",
+    [QS_SEM_SIGNAL]              = "t,obj,thread,count",
+    [QS_SEM_BLOCK_ATTEMPT]       = "t,obj,thread,count",
+
+    [QS_MTX_LOCK]                = "t,obj,holder,nest",
+    [QS_MTX_UNLOCK]              = "t,obj,holder,nest",
+    [QS_MTX_LOCK_ATTEMPT]        = "t,obj,holder,nest",
+    [QS_MTX_UNLOCK_ATTEMPT]      = "t,obj,holder,nest",
+    [QS_MTX_BLOCK]               = "t,obj,holder,thread",
+    [QS_MTX_BLOCK_ATTEMPT]       = "t,obj,holder,thread",
+};
+
+char const *QSPY_getRecFields(int recId) {
+    if ((QSPY_conf.qpVersion < 710U)
+        && ((recId == QS_SCHED_PREEMPT) || (recId == QS_SCHED_RESTORE)))
+    {
+        return "t,prio,ceil"; // old QS_MUTEX_LOCK/QS_MUTEX_UNLOCK
+    }
+    return (recId < QS_USER) // is it a Predefined record?
+        ? l_recFields[recId]
+        : "t";
+}
+//............................................................................
+bool QSPY_hasTstamp(int recId) {
+    switch (recId) {
+        case QS_EMPTY:
+        case QS_QEP_STATE_ENTRY:
+        case QS_QEP_STATE_EXIT:
+        case QS_QEP_STATE_INIT:
+        case QS_QEP_TRAN_HIST:
+        case QS_RESERVED_56:
+        case QS_RESERVED_57:
+        case QS_QEP_UNHANDLED:
+        case QS_QF_TICK:
+        case QS_QF_TIMEEVT_AUTO_DISARM:
+        case QS_TEST_PAUSED:
+        case QS_TARGET_INFO:
+        case QS_RX_STATUS:
+        case QS_QF_RUN:
+            return false;
+        default:
+            return QSPY_getGroup(recId) != QSPY_GRP_DIC;
+    }
+}
+
+// host-side filter ==========================================================
+static QSpyHostFilter l_hostFilter;
+
+// offsets of the "obj"/"sig" fields (or -1 if not present) for the
+// target sizes encoded in the layout (0 means "not calculated yet").
+// The object is the "obj" field, or the "sender" in the records without
+// the "obj" field (QS_QF_PUBLISH), but never the secondary objects
+// ("sender" of a post, "ao" of a time event, "queue" of a deferral).
+static uint32_t l_hostLayout[QS_USER];
+static int8_t   l_hostObjOff[QS_USER];
+static int8_t   l_hostSigOff[QS_USER];
+
+//............................................................................
+void QSPY_setHostFilter(QSpyHostFilter const *filter) {
+    if (filter != (QSpyHostFilter *)0) {
+        l_hostFilter = *filter;
+        l_hostFilterOn = filter->hasObj || filter->hasSig;
+        for (unsigned i = 0U; i < sizeof(l_hostFilter.recMap); ++i) {
+            if (l_hostFilter.recMap[i] != 0xFFU) {
+                l_hostFilterOn = true;
+            }
+        }
+    }
+    else {
+        memset(&l_hostFilter, 0, sizeof(l_hostFilter));
+        memset(l_hostFilter.recMap, 0xFF, sizeof(l_hostFilter.recMap));
+        l_hostFilterOn = false;
+    }
+#ifdef QSPY_APP
+    QFLT_update(false); // the records consumed might have changed
+#endif
+}
+//............................................................................
+void QSPY_getHostFilter(QSpyHostFilter *filter) {
+    if (l_hostFilterOn) {
+        *filter = l_hostFilter;
+    }
+    else { // pass-all filter
+        memset(filter, 0, sizeof(*filter));
+        memset(filter->recMap, 0xFF, sizeof(filter->recMap));
+    }
+}
+//............................................................................
+static void hostFilterLayout(int recId, uint32_t layout) {
+    char const * const fields = QSPY_getRecFields(recId); // NULL: no fields
+    char const *f = fields;
+    int off = 0;
+    int senderOff = -1;
+
+    l_hostObjOff[recId] = -1;
+    l_hostSigOff[recId] = -1;
+    while ((f != (char const *)0) && (*f != '\0')) {
+        size_t const n = strcspn(f, ",");
+        int size;
+        if ((n == 1U) && (f[0] == 't')) {
+            size = QSPY_conf.tstampSize;
+        }
+        else if (((n == 3U) && (strncmp(f, "obj", n) == 0))
+                 || ((n == 6U) && (strncmp(f, "sender", n) == 0))
+                 || ((n == 2U) && (strncmp(f, "ao", n) == 0))
+                 || ((n == 5U) && (strncmp(f, "queue", n) == 0)))
+        {
+            if ((n == 3U) && (l_hostObjOff[recId] < 0)) {
+                l_hostObjOff[recId] = (int8_t)off;
+            }
+            else if ((n == 6U) && (senderOff < 0)) {
+                senderOff = off;
+            }
+            size = QSPY_conf.objPtrSize;
+        }
+        else if ((n == 3U) && (strncmp(f, "sig", n) == 0)) {
+            l_hostSigOff[recId] = (int8_t)off;
+            size = QSPY_conf.sigSize;
+        }
+        else if (((n == 5U) && (strncmp(f, "state", n) == 0))
+                 || ((n == 6U) && (strncmp(f, "source", n) == 0))
+                 || ((n == 6U) && (strncmp(f, "target", n) == 0)))
+        {
+            size = QSPY_conf.funPtrSize;
+        }
+        else if ((n == 4U) && (strncmp(f, "size", n) == 0)) {
+            size = QSPY_conf.evtSize;
+        }
+        else { // the remaining fields are not needed
+            break;
+        }
+        off += size;
+        f += n;
+        if (*f == ',') {
+            ++f;
+        }
+    }
+    if ((l_hostObjOff[recId] < 0) && (fields != (char const *)0)
+        && (strstr(fields, "obj") == (char *)0))
+    {
+        l_hostObjOff[recId] = (int8_t)senderOff; // e.g., QS_QF_PUBLISH
+    }
+    l_hostLayout[recId] = layout;
+}
+//............................................................................
+static uint64_t hostFilterField(QSpyRecord const * const qrec,
+                                int off, uint8_t size, bool *ok)
+{
+    uint64_t val = 0U;
+    if ((off < 0) || ((int32_t)off + (int32_t)size > qrec->len)) {
+        *ok = false; // field not present in this record
+    }
+    else {
+        uint8_t const *p = &qrec->pos[off];
+        for (unsigned i = size; i > 0U; --i) {
+            val = (val << 8) | p[i - 1U];
+        }
+        *ok = true;
+    }
+    return val;
+}
+//............................................................................
+// does the deframed record pass the host-side filter?
+// (NOTE: uses only the record-ID and the leading fields of the record)
+static bool QSPY_hostFilterPass(QSpyRecord const * const qrec) {
+    int const recId = qrec->rec;
+
+    if ((recId < 128)
+        && ((l_hostFilter.recMap[recId >> 3] & (1U << (recId & 7))) == 0U))
+    {
+        int const grp = QSPY_getGroup(recId);
+        return (grp == QSPY_GRP_INF) || (grp == QSPY_GRP_DIC);
+    }
+    if ((recId >= QS_USER) || !(l_hostFilter.hasObj || l_hostFilter.hasSig)) {
+        return true; // no "obj"/"sig" fields to filter by
+    }
+    int const grp = QSPY_getGroup(recId);
+    if ((grp == QSPY_GRP_INF) || (grp == QSPY_GRP_DIC)
+        || (grp == QSPY_GRP_TST))
+    {
+        return true; // records needed by QSPY itself (no field layout)
+    }
+
+    uint32_t const layout = 0x80000000U
+        | ((uint32_t)QSPY_conf.tstampSize)
+        | ((uint32_t)QSPY_conf.objPtrSize << 4)
+        | ((uint32_t)QSPY_conf.funPtrSize << 8)
+        | ((uint32_t)QSPY_conf.sigSize    << 12)
+        | ((uint32_t)QSPY_conf.evtSize    << 16);
+    if (l_hostLayout[recId] != layout) { // target sizes changed?
+        hostFilterLayout(recId, layout);
+    }
+
+    bool ok;
+    if (l_hostFilter.hasObj) {
+        KeyType const obj = hostFilterField(qrec, l_hostObjOff[recId],
+                                            QSPY_conf.objPtrSize, &ok);
+        if (ok && (obj != l_hostFilter.obj)) {
+            return false;
+        }
+    }
+    if (l_hostFilter.hasSig) {
+        SigType const sig = (SigType)hostFilterField(qrec,
+                                l_hostSigOff[recId], QSPY_conf.sigSize, &ok);
+        if (ok && (sig != l_hostFilter.sig)) {
+            return false;
+        }
+    }
+    return true;
+}
+//............................................................................
+void QSPY_hostFilter(QSpyRecord * const qrec) {
+    QSpyHostFilter filter;
+    memset(&filter, 0, sizeof(filter));
+
+    // the record-ID bitmap (like the QS_RX_GLB_FILTER packet)
+    for (unsigned i = 0U; i < sizeof(filter.recMap); i += 8U) {
+        uint64_t const bits = QSpyRecord_getUint64(qrec, 8U);
+        for (unsigned j = 0U; j < 8U; ++j) {
+            filter.recMap[i + j] = (uint8_t)(bits >> (j * 8U));
+        }
+    }
+    uint8_t const flags = (uint8_t)QSpyRecord_getUint32(qrec, 1U);
+    if (qrec->len < 0) { // packet too short?
+        return; // error already reported
+    }
+
+    char *end;
+    if ((flags & 1U) != 0U) { // filter by the object?
+        char const *name = QSpyRecord_getStr(qrec);
+        if (name == (char const *)0) {
+            return;
+        }
+        filter.hasObj = true;
+        filter.obj = QSPY_findObj(name);
+        if (filter.obj == KEY_NOT_FOUND) { // not in the dictionary?
+            filter.obj = (KeyType)strtoull(name, &end, 0);
+            if ((end == name) || (*end != '\0')) {
+                SNPRINTF_LINE("   <QSPY-> ERROR    Host-Filter obj=%s "
+                              "not found", name);
+                QSPY_printError();
+                return;
+            }
+        }
+    }
+    if ((flags & 2U) != 0U) { // filter by the signal?
+        char const *name = QSpyRecord_getStr(qrec);
+        if (name == (char const *)0) {
+            return;
+        }
+        filter.hasSig = true;
+        filter.sig = QSPY_findSig(name,
+                         filter.hasObj ? (ObjType)filter.obj : 0U);
+        if (filter.sig == (SigType)0) { // not in the dictionary?
+            filter.sig = (SigType)strtoul(name, &end, 0);
+            if ((end == name) || (*end != '\0')) {
+                SNPRINTF_LINE("   <QSPY-> ERROR    Host-Filter sig=%s "
+                              "not found", name);
+                QSPY_printError();
+                return;
+            }
+        }
+    }
+    QSPY_setHostFilter(&filter);
+
+    SNPRINTF_LINE("   <QSPY-> Host-Filter %s",
+                  l_hostFilterOn ? "ON" : "OFF");
+    if (filter.hasObj) {
+        SNPRINTF_APPEND(" obj=0x%" PRIX64, (uint64_t)filter.obj);
+    }
+    if (filter.hasSig) {
+        SNPRINTF_APPEND(" sig=%u", (unsigned)filter.sig);
+    }
+    QSPY_printInfo();
+}
 
 // Dictionary class ========================================================*/
 int Dictionary_comp(void const *arg1, void const *arg2) {
@@ -2624,6 +3016,157 @@ void SigDictionary_reset(SigDictionary * const me) {
     me->entries = 0;
 }
 
+#ifdef QSPY_APP
+//----------------------------------------------------------------------------
+static void putMatVal(QSpyVal const *val) {
+    if (QMAT_isActive()) {
+        QMAT_putVal(val);
+    }
+    if (QNPY_isActive()) {
+        QNPY_putVal(val);
+    }
+    if (QTRC_isActive()) {
+        QTRC_putVal(val);
+    }
+    if (QQRY_isActive()) {
+        QQRY_putVal(val);
+    }
+    if (QQUE_isActive()) {
+        QQUE_putVal(val);
+    }
+}
+//............................................................................
+static void endMatRow(void) {
+    if (QMAT_isActive()) {
+        QMAT_endRow();
+    }
+    if (QNPY_isActive()) {
+        QNPY_endRow();
+    }
+    if (QTRC_isActive()) {
+        QTRC_endRow();
+    }
+    if (QQRY_isActive()) {
+        QQRY_endRow();
+    }
+    if (QQUE_isActive()) {
+        QQUE_endRow();
+    }
+}
+//............................................................................
+// feed the numbers formatted by the text Matlab output to the binary outputs
+// as values of the row, where the newline ends the row
+static void QSPY_putMatVals(char const *format, ...) {
+    va_list va;
+    va_start(va, format);
+    for (char const *f = format; *f != '\0'; ++f) {
+        if (*f == '\n') {
+            endMatRow();
+            continue;
+        }
+        if ((*f != '%') || (f[1] == '%')) { // not a conversion?
+            if (*f == '%') {
+                ++f;
+            }
+            continue;
+        }
+        ++f;
+        while ((*f != '\0') && (strchr("-+ #0", *f) != (char *)0)) {
+            ++f; // skip the flags
+        }
+        if (*f == '*') { // width in the argument?
+            (void)va_arg(va, int);
+            ++f;
+        }
+        while ((*f >= '0') && (*f <= '9')) {
+            ++f;
+        }
+        if (*f == '.') { // precision?
+            ++f;
+            if (*f == '*') {
+                (void)va_arg(va, int);
+                ++f;
+            }
+            while ((*f >= '0') && (*f <= '9')) {
+                ++f;
+            }
+        }
+        int lng = 0; // 0:int, 1:long, 2:long long/64-bit, 3:size_t/ptrdiff
+        for (;; ++f) {
+            if (*f == 'l') {
+                ++lng;
+            }
+            else if (*f == 'j') {
+                lng = 2;
+            }
+            else if ((*f == 'z') || (*f == 't')) {
+                lng = 3;
+            }
+            else if ((f[0] == 'I') && (f[1] == '6') && (f[2] == '4')) {
+                lng = 2;  // MSVC 64-bit
+                f += 2;
+            }
+            else if ((f[0] == 'I') && (f[1] == '3') && (f[2] == '2')) {
+                f += 2;   // MSVC 32-bit
+            }
+            else if ((*f != 'h') && (*f != 'L')) {
+                break;
+            }
+        }
+
+        QSpyVal val;
+        switch (*f) {
+            case 'd':
+            case 'i':
+                val.type = (lng == 0) ? QSPY_VAL_I32 : QSPY_VAL_I64;
+                val.u.i  = (lng == 0) ? (int64_t)va_arg(va, int)
+                         : (lng == 1) ? (int64_t)va_arg(va, long)
+                         : (lng == 2) ? (int64_t)va_arg(va, long long)
+                         : (int64_t)va_arg(va, ptrdiff_t);
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                val.type = (lng == 0) ? QSPY_VAL_U32 : QSPY_VAL_U64;
+                val.u.u  = (lng == 0) ? (uint64_t)va_arg(va, unsigned)
+                         : (lng == 1) ? (uint64_t)va_arg(va, unsigned long)
+                         : (lng == 2) ? (uint64_t)va_arg(va,
+                                                     unsigned long long)
+                         : (uint64_t)va_arg(va, size_t);
+                break;
+            case 'e':
+            case 'E':
+            case 'f':
+            case 'F':
+            case 'g':
+            case 'G':
+                val.type = QSPY_VAL_F64;
+                val.u.f  = va_arg(va, double);
+                break;
+            case 'c':
+                if (va_arg(va, int) == '\n') {
+                    endMatRow();
+                }
+                continue; // the characters are only separators
+            case 's':
+                val.type = QSPY_VAL_STR;
+                val.u.s  = va_arg(va, char const *);
+                break;
+            case 'p':
+                val.type = QSPY_VAL_U64;
+                val.u.u  = (uint64_t)(uintptr_t)va_arg(va, void *);
+                break;
+            default: // unsupported conversion
+                va_end(va);
+                return;
+        }
+        putMatVal(&val);
+    }
+    va_end(va);
+}
+#endif // QSPY_APP
+
 //----------------------------------------------------------------------------
 // simplified string_copy() implementation "good enough" for the intended use
 int string_copy(char *dest, size_t dest_size, char const *src) {
@@ -0,0 +1,794 @@
+//============================================================================
+// QSPY software tracing host-side utility
+//
+//                   Q u a n t u m  L e a P s
+//                   ------------------------
+//                   Modern Embedded Software
+//
+// Copyright(C) 2005 Quantum Leaps, LLC.All rights reserved.
+//
+// This software is licensed under the terms of the Quantum Leaps
+// QSPY SOFTWARE TRACING HOST UTILITY SOFTWARE END USER LICENSE.
+// Please see the file LICENSE-qspy.txt for the complete license text.
+//
+// Quantum Leaps contact information :
+// <www.state-machine.com/licensing>
+// <info@state-machine.com>
+//============================================================================
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // for fseeko()
+#define _FILE_OFFSET_BITS 64    // for the large capture files
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+#define Q_SPY   1       // this is QS implementation
+#define QP_IMPL 1       // this is QP implementation
+typedef int      int_t;   // dummy definition for including "qpc_qs.h"
+typedef int      enum_t;  // dummy definition for including "qpc_qs.h"
+typedef uint16_t QSignal; // dummy definition for including "qpc_qs.h"
+typedef uint32_t QSFun;   // dummy definition for including "qpc_qs.h"
+typedef uint32_t QSObj;   // dummy definition for including "qpc_qs.h"
+typedef uint32_t QEvt;    // dummy definition for including "qpc_qs.h"
+typedef uint32_t QActive; // dummy definition for including "qpc_qs.h"
+typedef uint32_t QPSet;   // dummy definition for including "qpc_qs.h"
+#include "qpc_qs.h"       // QS target-resident interface
+#include "qpc_qs_pkg.h"   // QS package-scope interface
+
+#include "safe_std.h"   // "safe" <stdio.h> and <string.h> facilities
+#include "qspy.h"       // QSPY data parser
+
+// Capture container (.qsc)
+//
+// The container keeps the QS records in the form received from the target
+// (HDLC-framed, with the sequence numbers and checksums), so the records
+// are decoded by QSPY_parse() exactly as in the live session. The records
+// are grouped in blocks of about CAP_BLOCK_SIZE bytes, every block starts
+// at the beginning of a frame and ends with the QS_FRAME byte, so decoding
+// can start at any block (after QSPY_resync()). The file layout is:
+//
+//     file header    (CAP_HDR_SIZE bytes)
+//     block 0        block header (CAP_BLK_HDR_SIZE bytes) + frames
+//     block 1        ...
+//     meta           QSPY configuration and the dictionaries
+//     index          data offset + copy of the block header for each block
+//
+// The block header holds the first/last sequence number, the first/last
+// timestamp and the bitmap of the record-IDs in the block. The sequence
+// numbers and the timestamps are extended to 64 bits (wrap-arounds are
+// counted), so they grow monotonically over the whole capture and the
+// blocks of a time window are found by binary search of the index.
+//
+// The meta and the index are written when the output is closed, and the
+// file header is then updated to point to them. A container that has not
+// been closed (e.g., after a crash) is still readable: the index is then
+// rebuilt from the block headers and the current configuration is used.
+//
+// All numbers are little-endian. The file header is:
+//
+//     0  "QSPYCAP\0"       32 u64 offset of the index
+//     8  u32 version        40 u32 nominal block size
+//     12 u32 header size    44 reserved (0)
+//     16 u64 offset of the meta
+//     24 u32 size of the meta
+//     28 u32 number of blocks
+//
+// The meta is the QSpyConfig (23 bytes) followed by the dictionaries,
+// each as u8 kind, u8 enum-group, u32 entries and the entries (u64 key or
+// u32 sig + u64 obj, u8 name length, name), terminated by kind 0.
+
+enum {
+    CAP_VERSION      = 1,
+    CAP_HDR_SIZE     = 64,
+    CAP_BLK_HDR_SIZE = 80,
+    CAP_IDX_SIZE     = 8 + CAP_BLK_HDR_SIZE, // index entry
+    CAP_BLOCK_SIZE   = 128 * 1024,       // nominal size of the block data
+    CAP_FRAME_MAX    = 2 * QS_RECORD_SIZE_MAX + 1, // escaped frame
+    CAP_BLOCK_MAX    = 64 * 1024 * 1024, // max block accepted by the reader
+};
+
+enum { // kinds of the dictionaries in the meta
+    CAP_DICT_END,
+    CAP_DICT_OBJ,
+    CAP_DICT_FUN,
+    CAP_DICT_USR,
+    CAP_DICT_SIG,
+    CAP_DICT_ENUM,
+};
+
+#ifdef _WIN32
+#define FSEEK64(fp_, off_) _fseeki64((fp_), (off_), SEEK_SET)
+#define FEND64(fp_)        _fseeki64((fp_), 0, SEEK_END)
+#define FTELL64(fp_)       _ftelli64(fp_)
+#else
+#define FSEEK64(fp_, off_) fseeko((fp_), (off_t)(off_), SEEK_SET)
+#define FEND64(fp_)        fseeko((fp_), 0, SEEK_END)
+#define FTELL64(fp_)       ftello(fp_)
+#endif
+
+static char const l_magic[8] = { 'Q', 'S', 'P', 'Y', 'C', 'A', 'P', '\0' };
+static char const l_blkMagic[4] = { 'Q', 'S', 'B', 'K' };
+
+// the writer ................................................................
+static FILE     *l_file;
+static uint64_t  l_pos;      // the current position in the file
+static bool      l_ioErr;    // write error reported
+static uint8_t   l_blk[CAP_BLOCK_SIZE + CAP_FRAME_MAX]; // frames of block
+static uint32_t  l_blkLen;
+static QCapBlock l_cur;      // the block being filled
+static QCapBlock *l_blocks;  // the blocks written so far (for the index)
+static uint32_t  l_nBlocks;
+static uint32_t  l_capBlocks;
+static bool      l_hasSeq;   // any record captured?
+static uint64_t  l_seq;      // extended sequence number
+static uint64_t  l_tHigh;    // the timestamp wrap-arounds
+static uint64_t  l_tLast;    // the last (not extended) timestamp
+static uint64_t  l_t;        // the last extended timestamp
+
+// the reader ................................................................
+static FILE      *l_rdFile;
+static QCapBlock *l_idx;     // the blocks of the container
+static uint32_t   l_nIdx;
+static uint8_t   *l_rdBuf;
+static uint32_t   l_rdSize;  // max block size of the container
+
+static void QCAP_close(void);
+
+//............................................................................
+static void putError(char const *msg) {
+    SNPRINTF_LINE("   <QSPY-> ERROR    %s", msg);
+    QSPY_printError();
+}
+//............................................................................
+static void setU16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8U);
+}
+static void setU32(uint8_t *p, uint32_t v) {
+    setU16(p, (uint16_t)v);
+    setU16(&p[2], (uint16_t)(v >> 16U));
+}
+static void setU64(uint8_t *p, uint64_t v) {
+    setU32(p, (uint32_t)v);
+    setU32(&p[4], (uint32_t)(v >> 32U));
+}
+static uint16_t getU16(uint8_t const *p) {
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8U));
+}
+static uint32_t getU32(uint8_t const *p) {
+    return getU16(p) | ((uint32_t)getU16(&p[2]) << 16U);
+}
+static uint64_t getU64(uint8_t const *p) {
+    return getU32(p) | ((uint64_t)getU32(&p[4]) << 32U);
+}
+//............................................................................
+static void putBytes(void const *data, uint32_t size) {
+    if (fwrite(data, 1U, size, l_file) != size) {
+        if (!l_ioErr) {
+            l_ioErr = true;
+            putError("Writing capture container failed");
+        }
+    }
+    l_pos += size;
+}
+//............................................................................
+// the period of the wrap-around of the timestamp (0 for 64-bit timestamps)
+static uint64_t tstampWrap(uint8_t tstampSize) {
+    return (tstampSize < 8U)
+           ? ((uint64_t)1U << (8U * tstampSize))
+           : 0U;
+}
+//............................................................................
+static uint64_t getTstamp(uint8_t const *p, uint8_t tstampSize) {
+    uint64_t t = 0U;
+    for (uint8_t i = tstampSize; i > 0U; --i) {
+        t = (t << 8U) | p[i - 1U];
+    }
+    return t;
+}
+//............................................................................
+static void putBlockHdr(uint8_t *p, QCapBlock const *blk) {
+    memcpy(p, l_blkMagic, sizeof(l_blkMagic));
+    setU32(&p[4],  blk->size);
+    setU32(&p[8],  blk->nRecs);
+    p[12] = blk->hasTstamp ? 1U : 0U;
+    p[13] = blk->tstampSize;
+    setU16(&p[14], 0U);
+    setU64(&p[16], blk->seqFirst);
+    setU64(&p[24], blk->seqLast);
+    setU64(&p[32], blk->tFirst);
+    setU64(&p[40], blk->tLast);
+    memcpy(&p[48], blk->recMap, sizeof(blk->recMap));
+}
+//............................................................................
+static bool getBlockHdr(uint8_t const *p, QCapBlock *blk) {
+    if (memcmp(p, l_blkMagic, sizeof(l_blkMagic)) != 0) {
+        return false;
+    }
+    blk->size       = getU32(&p[4]);
+    blk->nRecs      = getU32(&p[8]);
+    blk->hasTstamp  = ((p[12] & 1U) != 0U);
+    blk->tstampSize = p[13];
+    blk->seqFirst   = getU64(&p[16]);
+    blk->seqLast    = getU64(&p[24]);
+    blk->tFirst     = getU64(&p[32]);
+    blk->tLast      = getU64(&p[40]);
+    memcpy(blk->recMap, &p[48], sizeof(blk->recMap));
+    return (blk->tstampSize <= 8U);
+}
+//............................................................................
+static void putFileHdr(uint64_t metaPos, uint32_t metaSize,
+                       uint64_t idxPos)
+{
+    uint8_t hdr[CAP_HDR_SIZE];
+    memset(hdr, 0, sizeof(hdr));
+    memcpy(hdr, l_magic, sizeof(l_magic));
+    setU32(&hdr[8],  CAP_VERSION);
+    setU32(&hdr[12], CAP_HDR_SIZE);
+    setU64(&hdr[16], metaPos);
+    setU32(&hdr[24], metaSize);
+    setU32(&hdr[28], l_nBlocks);
+    setU64(&hdr[32], idxPos);
+    setU32(&hdr[40], CAP_BLOCK_SIZE);
+    putBytes(hdr, sizeof(hdr));
+}
+//............................................................................
+static void startBlock(void) {
+    memset(&l_cur, 0, sizeof(l_cur));
+    l_cur.tFirst = l_t; // until the first timestamp in the block
+    l_cur.tLast  = l_t;
+    l_cur.tstampSize = QSPY_conf.tstampSize;
+    l_blkLen = 0U;
+}
+//............................................................................
+static void flushBlock(void) {
+    if (l_blkLen == 0U) {
+        return;
+    }
+    if (l_nBlocks == l_capBlocks) {
+        uint32_t const cap = (l_capBlocks != 0U) ? 2U * l_capBlocks : 256U;
+        QCapBlock *blocks = (QCapBlock *)realloc(l_blocks,
+                                                 cap * sizeof(QCapBlock));
+        if (blocks == (QCapBlock *)0) {
+            putError("Out of memory for capture container index");
+            startBlock(); // drop the block
+            return;
+        }
+        l_blocks = blocks;
+        l_capBlocks = cap;
+    }
+    uint8_t hdr[CAP_BLK_HDR_SIZE];
+    l_cur.size   = l_blkLen;
+    l_cur.offset = l_pos + CAP_BLK_HDR_SIZE;
+    putBlockHdr(hdr, &l_cur);
+    putBytes(hdr, sizeof(hdr));
+    putBytes(l_blk, l_blkLen);
+    l_blocks[l_nBlocks] = l_cur;
+    ++l_nBlocks;
+    startBlock();
+}
+//............................................................................
+void QCAP_configFile(void *capFile) {
+    if (l_file != (FILE *)0) {
+        QCAP_close();
+    }
+    l_file = (FILE *)capFile;
+    if (l_file != (FILE *)0) {
+        l_pos     = 0U;
+        l_ioErr   = false;
+        l_nBlocks = 0U;
+        l_hasSeq  = false;
+        l_seq     = 0U;
+        l_tHigh   = 0U;
+        l_tLast   = 0U;
+        l_t       = 0U;
+        startBlock();
+        putFileHdr(0U, 0U, 0U); // updated when the container is closed
+    }
+}
+//............................................................................
+bool QCAP_isActive(void) {
+    return l_file != (FILE *)0;
+}
+//............................................................................
+void QCAP_putRecord(uint8_t const *rec, uint32_t nBytes) {
+    if (nBytes < 3U) { // not a complete record?
+        return;
+    }
+    if (l_blkLen + 2U * nBytes + 1U > CAP_BLOCK_SIZE) { // won't fit?
+        flushBlock();
+    }
+
+    // extend the sequence number
+    if (l_hasSeq) {
+        uint8_t const delta = (uint8_t)(rec[0] - (uint8_t)l_seq);
+        l_seq += (delta != 0U) ? delta : 256U;
+    }
+    else {
+        l_hasSeq = true;
+        l_seq = rec[0];
+    }
+
+    // extend the timestamp
+    uint8_t const tsz = QSPY_conf.tstampSize;
+    if (QSPY_hasTstamp(rec[1]) && (nBytes >= 3U + tsz)) {
+        uint64_t const t = getTstamp(&rec[2], tsz);
+        if (t < l_tLast) { // wrap-around?
+            l_tHigh += tstampWrap(tsz);
+        }
+        l_tLast = t;
+        l_t = l_tHigh + t;
+        if (!l_cur.hasTstamp) {
+            l_cur.hasTstamp = true;
+            l_cur.tFirst = l_t;
+        }
+        l_cur.tLast = l_t;
+        l_cur.tstampSize = tsz;
+    }
+
+    if (l_cur.nRecs == 0U) {
+        l_cur.seqFirst = l_seq;
+    }
+    l_cur.seqLast = l_seq;
+    ++l_cur.nRecs;
+    l_cur.recMap[rec[1] >> 3U] |= (uint8_t)(1U << (rec[1] & 7U));
+
+    // the frame, escaped as sent by the target
+    uint8_t *p = &l_blk[l_blkLen];
+    for (uint32_t i = 0U; i < nBytes; ++i) {
+        uint8_t const b = rec[i];
+        if ((b == QS_FRAME) || (b == QS_ESC)) {
+            *p++ = QS_ESC;
+            *p++ = (uint8_t)(b ^ QS_ESC_XOR);
+        }
+        else {
+            *p++ = b;
+        }
+    }
+    *p++ = QS_FRAME;
+    l_blkLen = (uint32_t)(p - l_blk);
+}
+
+//............................................................................
+static void putDict(uint8_t kind, uint8_t group, Dictionary const *dict) {
+    uint8_t buf[16];
+    buf[0] = kind;
+    buf[1] = group;
+    setU32(&buf[2], (uint32_t)dict->entries);
+    putBytes(buf, 6U);
+    for (int i = 0; i < dict->entries; ++i) {
+        size_t const len = strlen(dict->sto[i].name);
+        setU64(buf, dict->sto[i].key);
+        buf[8] = (uint8_t)len;
+        putBytes(buf, 9U);
+        putBytes(dict->sto[i].name, (uint32_t)len);
+    }
+}
+//............................................................................
+static void putSigDict(SigDictionary const *dict) {
+    uint8_t buf[16];
+    buf[0] = CAP_DICT_SIG;
+    buf[1] = 0U;
+    setU32(&buf[2], (uint32_t)dict->entries);
+    putBytes(buf, 6U);
+    for (int i = 0; i < dict->entries; ++i) {
+        size_t const len = strlen(dict->sto[i].name);
+        setU32(buf, dict->sto[i].sig);
+        setU64(&buf[4], dict->sto[i].obj);
+        buf[12] = (uint8_t)len;
+        putBytes(buf, 13U);
+        putBytes(dict->sto[i].name, (uint32_t)len);
+    }
+}
+//............................................................................
+static void putMeta(void) {
+    uint8_t buf[32];
+    setU32(buf, QSPY_conf.qpDate);
+    setU16(&buf[4], QSPY_conf.qpVersion);
+    buf[6]  = QSPY_conf.qpType;
+    buf[7]  = QSPY_conf.endianness;
+    buf[8]  = QSPY_conf.objPtrSize;
+    buf[9]  = QSPY_conf.funPtrSize;
+    buf[10] = QSPY_conf.tstampSize;
+    buf[11] = QSPY_conf.sigSize;
+    buf[12] = QSPY_conf.evtSize;
+    buf[13] = QSPY_conf.queueCtrSize;
+    buf[14] = QSPY_conf.poolCtrSize;
+    buf[15] = QSPY_conf.poolBlkSize;
+    buf[16] = QSPY_conf.tevtCtrSize;
+    memcpy(&buf[17], QSPY_conf.tbuild, sizeof(QSPY_conf.tbuild));
+    putBytes(buf, 23U);
+
+    putDict(CAP_DICT_OBJ, 0U, &QSPY_objDict);
+    putDict(CAP_DICT_FUN, 0U, &QSPY_funDict);
+    putDict(CAP_DICT_USR, 0U, &QSPY_usrDict);
+    putSigDict(&QSPY_sigDict);
+    for (uint8_t g = 0U;
+         g < sizeof(QSPY_enumDict)/sizeof(QSPY_enumDict[0]);
+         ++g)
+    {
+        if (QSPY_enumDict[g].entries > 0) {
+            putDict(CAP_DICT_ENUM, g, &QSPY_enumDict[g]);
+        }
+    }
+    buf[0] = CAP_DICT_END;
+    putBytes(buf, 1U);
+}
+//............................................................................
+static void QCAP_close(void) {
+    flushBlock();
+
+    uint64_t const metaPos = l_pos;
+    putMeta();
+    uint32_t const metaSize = (uint32_t)(l_pos - metaPos);
+
+    uint64_t const idxPos = l_pos;
+    for (uint32_t i = 0U; i < l_nBlocks; ++i) {
+        uint8_t entry[CAP_IDX_SIZE];
+        setU64(entry, l_blocks[i].offset);
+        putBlockHdr(&entry[8], &l_blocks[i]);
+        putBytes(entry, sizeof(entry));
+    }
+
+    if (FSEEK64(l_file, 0) == 0) {
+        putFileHdr(metaPos, metaSize, idxPos);
+    }
+    else {
+        putError("Cannot complete capture container (not seekable)");
+    }
+    fclose(l_file);
+    l_file = (FILE *)0;
+
+    free(l_blocks);
+    l_blocks = (QCapBlock *)0;
+    l_nBlocks = 0U;
+    l_capBlocks = 0U;
+}
+
+//============================================================================
+// the reader...
+static bool readAt(uint64_t pos, void *buf, size_t size) {
+    return (FSEEK64(l_rdFile, pos) == 0)
+           && (fread(buf, 1U, size, l_rdFile) == size);
+}
+//............................................................................
+static bool addIdx(QCapBlock const *blk, uint32_t *cap) {
+    if (l_nIdx == *cap) {
+        uint32_t const n = (*cap != 0U) ? 2U * *cap : 256U;
+        QCapBlock *idx = (QCapBlock *)realloc(l_idx, n * sizeof(QCapBlock));
+        if (idx == (QCapBlock *)0) {
+            return false;
+        }
+        l_idx = idx;
+        *cap = n;
+    }
+    l_idx[l_nIdx] = *blk;
+    ++l_nIdx;
+    return true;
+}
+//............................................................................
+// load the index saved at the end of the container
+static bool readIndex(uint64_t idxPos, uint32_t nBlocks) {
+    // the index must fit in the file (before trusting nBlocks for malloc)
+    uint64_t const idxSize = (uint64_t)nBlocks * CAP_IDX_SIZE;
+    int64_t const fileSize = (FEND64(l_rdFile) == 0)
+                             ? (int64_t)FTELL64(l_rdFile) : -1;
+    if ((fileSize < 0) || (idxPos > (uint64_t)fileSize)
+        || (idxSize > (uint64_t)fileSize - idxPos)
+        || (idxSize > (uint64_t)(SIZE_MAX / 2U)))
+    {
+        return false;
+    }
+    uint8_t *buf = (uint8_t *)malloc((size_t)idxSize + 1U);
+    l_idx = (QCapBlock *)malloc((size_t)nBlocks * sizeof(QCapBlock) + 1U);
+    bool ok = (buf != (uint8_t *)0) && (l_idx != (QCapBlock *)0)
+              && readAt(idxPos, buf, (size_t)idxSize);
+    for (uint32_t i = 0U; ok && (i < nBlocks); ++i) {
+        uint8_t const *e = &buf[(size_t)i * CAP_IDX_SIZE];
+        ok = getBlockHdr(&e[8], &l_idx[i]);
+        l_idx[i].offset = getU64(e);
+    }
+    l_nIdx = ok ? nBlocks : 0U;
+    free(buf);
+    return ok;
+}
+//............................................................................
+// rebuild the index from the block headers (container not completed)
+static bool scanIndex(void) {
+    uint32_t cap = 0U;
+    uint64_t pos = CAP_HDR_SIZE;
+    uint8_t hdr[CAP_BLK_HDR_SIZE];
+    QCapBlock blk;
+    while (readAt(pos, hdr, sizeof(hdr)) && getBlockHdr(hdr, &blk)) {
+        blk.offset = pos + CAP_BLK_HDR_SIZE;
+        if ((FSEEK64(l_rdFile, blk.offset + blk.size - 1U) != 0)
+            || (fgetc(l_rdFile) != QS_FRAME)) // block truncated?
+        {
+            break;
+        }
+        if (!addIdx(&blk, &cap)) {
+            return false;
+        }
+        pos = blk.offset + blk.size;
+    }
+    return true;
+}
+//............................................................................
+// restore the QSPY configuration and the dictionaries from the meta
+static bool readMeta(uint64_t metaPos, uint32_t metaSize) {
+    uint8_t *buf = (uint8_t *)malloc((size_t)metaSize + 1U);
+    if ((buf == (uint8_t *)0) || (metaSize < 24U)
+        || !readAt(metaPos, buf, metaSize))
+    {
+        free(buf);
+        return false;
+    }
+    QSPY_conf.qpDate       = getU32(buf);
+    QSPY_conf.qpVersion    = getU16(&buf[4]);
+    QSPY_conf.qpType       = buf[6];
+    QSPY_conf.endianness   = buf[7];
+    QSPY_conf.objPtrSize   = buf[8];
+    QSPY_conf.funPtrSize   = buf[9];
+    QSPY_conf.tstampSize   = buf[10];
+    QSPY_conf.sigSize      = buf[11];
+    QSPY_conf.evtSize      = buf[12];
+    QSPY_conf.queueCtrSize = buf[13];
+    QSPY_conf.poolCtrSize  = buf[14];
+    QSPY_conf.poolBlkSize  = buf[15];
+    QSPY_conf.tevtCtrSize  = buf[16];
+    memcpy(QSPY_conf.tbuild, &buf[17], sizeof(QSPY_conf.tbuild));
+
+    Dictionary_config(&QSPY_funDict, QSPY_conf.funPtrSize);
+    Dictionary_config(&QSPY_objDict, QSPY_conf.objPtrSize);
+    SigDictionary_config(&QSPY_sigDict, QSPY_conf.objPtrSize);
+    QSPY_resetAllDictionaries();
+    for (unsigned g = 0U;
+         g < sizeof(QSPY_enumDict)/sizeof(QSPY_enumDict[0]);
+         ++g)
+    {
+        Dictionary_reset(&QSPY_enumDict[g]);
+    }
+
+    uint8_t const *p   = &buf[23];
+    uint8_t const *end = &buf[metaSize];
+    bool ok = true;
+    while (ok && (p < end) && (*p != CAP_DICT_END)) {
+        uint8_t const kind  = p[0];
+        uint8_t const group = p[1];
+        uint32_t n = 0U;
+        if (end - p >= 6) {
+            n = getU32(&p[2]);
+            p += 6;
+        }
+        else {
+            ok = false;
+        }
+        uint32_t const keyLen = (kind == CAP_DICT_SIG) ? 12U : 8U;
+        for (; ok && (n > 0U); --n) {
+            char name[QS_DNAME_LEN_MAX];
+            ok = ((uint32_t)(end - p) > keyLen);
+            uint32_t const len = ok ? p[keyLen] : 0U;
+            ok = ok && (len < sizeof(name))
+                 && ((uint32_t)(end - p) >= keyLen + 1U + len);
+            if (ok) {
+                memcpy(name, &p[keyLen + 1U], len);
+                name[len] = '\0';
+                switch (kind) {
+                    case CAP_DICT_OBJ:
+                        Dictionary_put(&QSPY_objDict, getU64(p), name);
+                        break;
+                    case CAP_DICT_FUN:
+                        Dictionary_put(&QSPY_funDict, getU64(p), name);
+                        break;
+                    case CAP_DICT_USR:
+                        Dictionary_put(&QSPY_usrDict, getU64(p), name);
+                        break;
+                    case CAP_DICT_SIG:
+                        SigDictionary_put(&QSPY_sigDict,
+                                          getU32(p), getU64(&p[4]), name);
+                        break;
+                    case CAP_DICT_ENUM:
+                        ok = (group < sizeof(QSPY_enumDict)
+                                      / sizeof(QSPY_enumDict[0]));
+                        if (ok) {
+                            Dictionary_put(&QSPY_enumDict[group],
+                                           getU64(p), name);
+                        }
+                        break;
+                    default: // unknown dictionary
+                        ok = false;
+                        break;
+                }
+                p += keyLen + 1U + len;
+            }
+        }
+    }
+    free(buf);
+    return ok;
+}
+//............................................................................
+int QCAP_open(void *capFile) {
+    if (l_rdFile != (FILE *)0) {
+        fclose(l_rdFile);
+    }
+    free(l_idx);
+    free(l_rdBuf);
+    l_idx    = (QCapBlock *)0;
+    l_nIdx   = 0U;
+    l_rdBuf  = (uint8_t *)0;
+    l_rdFile = (FILE *)capFile;
+    if (l_rdFile == (FILE *)0) {
+        return 0;
+    }
+
+    uint8_t hdr[CAP_HDR_SIZE];
+    bool ok = readAt(0U, hdr, sizeof(hdr))
+              && (memcmp(hdr, l_magic, sizeof(l_magic)) == 0)
+              && (getU32(&hdr[8]) == CAP_VERSION)
+              && (getU32(&hdr[12]) == CAP_HDR_SIZE);
+    if (!ok) {
+        putError("Not a capture container");
+    }
+    else if (getU64(&hdr[32]) != 0U) { // completed container?
+        ok = readIndex(getU64(&hdr[32]), getU32(&hdr[28]));
+        if (ok && !readMeta(getU64(&hdr[16]), getU32(&hdr[24]))) {
+            putError("Corrupted configuration in capture container");
+            ok = false;
+        }
+    }
+    else {
+        SNPRINTF_LINE("   <QSPY-> %s",
+                      "Capture container not completed (blocks scanned)");
+        QSPY_printInfo();
+        ok = scanIndex();
+    }
+
+    l_rdSize = 0U;
+    for (uint32_t i = 0U; ok && (i < l_nIdx); ++i) {
+        if (l_idx[i].size > CAP_BLOCK_MAX) {
+            ok = false;
+        }
+        else if (l_idx[i].size > l_rdSize) {
+            l_rdSize = l_idx[i].size;
+        }
+    }
+    if (ok) {
+        l_rdBuf = (uint8_t *)malloc((size_t)l_rdSize + 1U);
+        ok = (l_rdBuf != (uint8_t *)0);
+    }
+    if (!ok) {
+        putError("Cannot read capture container");
+        QCAP_open((void *)0);
+        return -1;
+    }
+    return (int)l_nIdx;
+}
+//............................................................................
+QCapBlock const *QCAP_getBlock(uint32_t idx) {
+    return (idx < l_nIdx) ? &l_idx[idx] : (QCapBlock const *)0;
+}
+//............................................................................
+uint32_t QCAP_findBlock(uint64_t tstamp) {
+    uint32_t lo = 0U;
+    uint32_t hi = l_nIdx;
+    while (lo < hi) { // binary search (the timestamps are monotonic)
+        uint32_t const mid = lo + (hi - lo) / 2U;
+        if (l_idx[mid].tLast < tstamp) {
+            lo = mid + 1U;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+//............................................................................
+static bool hasRec(uint8_t const *recMap, uint8_t recId) {
+    return (recMap[recId >> 3U] & (uint8_t)(1U << (recId & 7U))) != 0U;
+}
+//............................................................................
+bool QCAP_hasRecs(uint32_t idx, uint8_t const *recMap) {
+    QCapBlock const *blk = QCAP_getBlock(idx);
+    if (blk == (QCapBlock *)0) {
+        return false;
+    }
+    if (recMap == (uint8_t const *)0) {
+        return true;
+    }
+    for (uint32_t i = 0U; i < sizeof(blk->recMap); ++i) {
+        if ((blk->recMap[i] & recMap[i]) != 0U) {
+            return true;
+        }
+    }
+    return false;
+}
+//............................................................................
+uint32_t QCAP_decodeBlock(uint32_t idx, uint64_t tFrom, uint64_t tTo,
+                          uint8_t const *recMap)
+{
+    if (!QCAP_hasRecs(idx, recMap)) { // nothing to decode in the block?
+        return 0U;
+    }
+    QCapBlock const *blk = &l_idx[idx];
+    if (!readAt(blk->offset, l_rdBuf, blk->size)) {
+        return 0U;
+    }
+
+    // the timestamps are extended the same way as by the writer
+    uint8_t  const tsz  = blk->tstampSize;
+    uint64_t const wrap = tstampWrap(tsz);
+    uint64_t tLast = (wrap != 0U) ? (blk->tFirst & (wrap - 1U)) : blk->tFirst;
+    uint64_t tHigh = blk->tFirst - tLast;
+    uint64_t t     = blk->tFirst;
+
+    QSPY_resync();
+    bool skipped = false;
+    uint32_t nRecs = 0U;
+    uint8_t const *frame = l_rdBuf;
+    uint8_t const *end   = &l_rdBuf[blk->size];
+    while (frame < end) {
+        uint8_t head[2 + 8]; // seq, record-ID and the timestamp
+        uint32_t n = 0U;
+        uint8_t const *p = frame;
+        for (; (p < end) && (*p != QS_FRAME); ++p) {
+            uint8_t b = *p;
+            if (b == QS_ESC) {
+                if (++p == end) {
+                    break;
+                }
+                b = (uint8_t)(*p ^ QS_ESC_XOR);
+            }
+            if (n < sizeof(head)) {
+                head[n] = b;
+            }
+            ++n;
+        }
+        if (p == end) { // incomplete frame?
+            break;
+        }
+        ++p; // include the QS_FRAME byte
+
+        if (blk->hasTstamp && (n >= 3U + tsz)
+            && QSPY_hasTstamp(head[1]))
+        {
+            uint64_t const ts = getTstamp(&head[2], tsz);
+            if (ts < tLast) { // wrap-around?
+                tHigh += wrap;
+            }
+            tLast = ts;
+            t = tHigh + ts;
+        }
+        if (t > tTo) {
+            break;
+        }
+        if ((t < tFrom) || (n < 3U)
+            || ((recMap != (uint8_t const *)0) && !hasRec(recMap, head[1])))
+        {
+            skipped = true; // the record is not even parsed
+        }
+        else {
+            if (skipped) { // the sequence numbers won't follow?
+                QSPY_resync();
+                skipped = false;
+            }
+            QSPY_parse(frame, (uint32_t)(p - frame));
+            ++nRecs;
+        }
+        frame = p;
+    }
+    return nRecs;
+}
+//............................................................................
+uint32_t QCAP_decode(uint64_t tFrom, uint64_t tTo, uint8_t const *recMap) {
+    uint32_t nRecs = 0U;
+    for (uint32_t i = QCAP_findBlock(tFrom);
+         (i < l_nIdx) && (l_idx[i].tFirst <= tTo);
+         ++i)
+    {
+        nRecs += QCAP_decodeBlock(i, tFrom, tTo, recMap);
+    }
+    return nRecs;
+}
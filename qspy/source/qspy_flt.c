@@ -0,0 +1,264 @@
+//============================================================================
+// QSPY software tracing host-side utility
+//
+//                   Q u a n t u m  L e a P s
+//                   ------------------------
+//                   Modern Embedded Software
+//
+// Copyright(C) 2005 Quantum Leaps, LLC.All rights reserved.
+//
+// This software is licensed under the terms of the Quantum Leaps
+// QSPY SOFTWARE TRACING HOST UTILITY SOFTWARE END USER LICENSE.
+// Please see the file LICENSE-qspy.txt for the complete license text.
+//
+// Quantum Leaps contact information :
+// <www.state-machine.com/licensing>
+// <info@state-machine.com>
+//============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+#define Q_SPY   1       // this is QS implementation
+#define QP_IMPL 1       // this is QP implementation
+typedef int      int_t;   // dummy definition for including "qpc_qs.h"
+typedef int      enum_t;  // dummy definition for including "qpc_qs.h"
+typedef uint16_t QSignal; // dummy definition for including "qpc_qs.h"
+typedef uint32_t QSFun;   // dummy definition for including "qpc_qs.h"
+typedef uint32_t QSObj;   // dummy definition for including "qpc_qs.h"
+typedef uint32_t QEvt;    // dummy definition for including "qpc_qs.h"
+typedef uint32_t QActive; // dummy definition for including "qpc_qs.h"
+typedef uint32_t QPSet;   // dummy definition for including "qpc_qs.h"
+#include "qpc_qs.h"       // QS target-resident interface
+#include "qpc_qs_pkg.h"   // QS package-scope interface
+
+#include "safe_std.h"   // "safe" <stdio.h> and <string.h> facilities
+#include "qspy.h"       // QSPY data parser
+#include "pal.h"        // Platform Abstraction Layer
+
+// Demand-driven Target filters
+//
+// The Global-Filter pushed to the Target is the union of the records
+// needed by the consumers of the QSPY output:
+//
+//  - the attached consumers (the human-readable output, the Front-End,
+//    ...), which declare the needed records in QFLT_attach();
+//  - the active outputs (Matlab, NPY, trace, sequence, queue model),
+//    whose records are known to QSPY, and which are checked in
+//    QFLT_update().
+//
+// All these consumers see only the records passing the host-side filter
+// (see QSPY_setHostFilter()), so their union is limited to the records in
+// the host-side filter. The only exception is the capture container,
+// which keeps all records received from the Target.
+//
+// The Local-Filter is the union of the QS-IDs needed by the consumers.
+// The records needed by QSPY itself (Target info, dictionaries, test
+// records) are always enabled.
+
+#define FLT_MAP_SIZE 16U
+
+static bool    l_active;
+static bool    l_pushed;  // were the filters pushed to the Target yet?
+static uint8_t l_glb[FLT_MAP_SIZE]; // the Global-Filter pushed last
+static uint8_t l_loc[FLT_MAP_SIZE]; // the Local-Filter pushed last
+
+static struct {
+    bool    attached;
+    uint8_t glb[FLT_MAP_SIZE];
+    uint8_t loc[FLT_MAP_SIZE];
+} l_cons[QFLT_MAX];
+
+// records used by the trace-event output (see QTRC_endRow())
+static uint8_t const l_trcRecs[] = {
+    QS_QEP_DISPATCH,
+    QS_QF_ACTIVE_POST, QS_QF_ACTIVE_POST_ATTEMPT, QS_QF_ACTIVE_POST_LIFO,
+    QS_QF_ACTIVE_GET, QS_QF_ACTIVE_GET_LAST,
+    QS_QF_EQUEUE_POST, QS_QF_EQUEUE_POST_LIFO,
+    QS_QF_EQUEUE_GET, QS_QF_EQUEUE_GET_LAST,
+    QS_QF_MPOOL_GET, QS_QF_MPOOL_PUT, QS_QF_PUBLISH,
+    QS_QF_ISR_ENTRY, QS_QF_ISR_EXIT,
+    QS_SCHED_NEXT, QS_SCHED_IDLE, QS_SCHED_PREEMPT, QS_SCHED_RESTORE,
+    0U
+};
+
+// records used by the sequence output (besides the user records),
+// see the QSEQ_gen...() calls in QSpyRecord_process()
+static uint8_t const l_seqRecs[] = {
+    QS_QEP_TRAN,
+    QS_QF_ACTIVE_POST, QS_QF_ACTIVE_POST_ATTEMPT, QS_QF_ACTIVE_POST_LIFO,
+    QS_QF_ACTIVE_DEFER, QS_QF_ACTIVE_DEFER_ATTEMPT,
+    QS_QF_ACTIVE_RECALL, QS_QF_ACTIVE_RECALL_ATTEMPT,
+    QS_QF_PUBLISH, QS_QF_TICK,
+    0U
+};
+
+// records used by the queue model (see QQUE_endRow())
+static uint8_t const l_queRecs[] = {
+    QS_QF_ACTIVE_POST, QS_QF_ACTIVE_POST_ATTEMPT, QS_QF_ACTIVE_POST_LIFO,
+    QS_QF_ACTIVE_GET, QS_QF_ACTIVE_GET_LAST,
+    QS_QF_EQUEUE_POST, QS_QF_EQUEUE_POST_ATTEMPT, QS_QF_EQUEUE_POST_LIFO,
+    QS_QF_EQUEUE_GET, QS_QF_EQUEUE_GET_LAST,
+    0U
+};
+
+//............................................................................
+static void setRec(uint8_t *map, int rec) {
+    map[rec >> 3] |= (uint8_t)(1U << (rec & 7));
+}
+//............................................................................
+static void setRecs(uint8_t *map, uint8_t const *recs) {
+    for (; *recs != 0U; ++recs) {
+        setRec(map, *recs);
+    }
+}
+//............................................................................
+static void setMap(uint8_t *map, uint8_t const *bits) {
+    for (unsigned i = 0U; i < FLT_MAP_SIZE; ++i) {
+        map[i] |= (bits != (uint8_t const *)0) ? bits[i] : 0xFFU;
+    }
+}
+//............................................................................
+static void sendFilter(uint8_t recId, uint8_t const *map) {
+    uint8_t pkt[2U + FLT_MAP_SIZE];
+    uint8_t buf[2U*(sizeof(pkt) + 2U) + 2U]; // escaped in the worst case
+
+    pkt[0] = recId;
+    pkt[1] = (uint8_t)FLT_MAP_SIZE;
+    memcpy(&pkt[2], map, FLT_MAP_SIZE);
+
+    uint32_t const n = QSPY_encode(buf, sizeof(buf), pkt, sizeof(pkt));
+    if ((n != 0U) && (PAL_vtbl.send2Target != 0)) {
+        (*PAL_vtbl.send2Target)(buf, n);
+    }
+}
+
+//............................................................................
+void QFLT_config(bool enable) {
+    l_active = enable;
+    l_pushed = false;
+    if (enable) {
+        QFLT_update(true);
+    }
+}
+//............................................................................
+bool QFLT_isActive(void) {
+    return l_active;
+}
+//............................................................................
+void QFLT_attach(int consumer, uint8_t const *glbMap, uint8_t const *locMap) {
+    if ((0 <= consumer) && (consumer < QFLT_MAX)) {
+        l_cons[consumer].attached = true;
+        memset(l_cons[consumer].glb, 0, FLT_MAP_SIZE);
+        memset(l_cons[consumer].loc, 0, FLT_MAP_SIZE);
+        setMap(l_cons[consumer].glb, glbMap);
+        setMap(l_cons[consumer].loc, locMap);
+        if (l_active) {
+            QFLT_update(false);
+        }
+    }
+}
+//............................................................................
+void QFLT_detach(int consumer) {
+    if ((0 <= consumer) && (consumer < QFLT_MAX)) {
+        l_cons[consumer].attached = false;
+        if (l_active) {
+            QFLT_update(false);
+        }
+    }
+}
+//............................................................................
+void QFLT_update(bool force) {
+    if (!l_active) {
+        return;
+    }
+
+    uint8_t glb[FLT_MAP_SIZE];
+    uint8_t loc[FLT_MAP_SIZE];
+    memset(glb, 0, sizeof(glb));
+    memset(loc, 0, sizeof(loc));
+
+    // the attached consumers
+    for (int i = 0; i < QFLT_MAX; ++i) {
+        if (l_cons[i].attached) {
+            setMap(glb, l_cons[i].glb);
+            setMap(loc, l_cons[i].loc);
+        }
+    }
+
+    // the active outputs (all QS-IDs)
+    bool const isRows = QSPY_isMatFileActive() || QMAT_isActive()
+                        || QNPY_isActive();
+    if (isRows) { // all records with the fields?
+        for (int rec = 1; rec < QS_USER; ++rec) {
+            if (QSPY_getRecFields(rec) != (char const *)0) {
+                setRec(glb, rec);
+            }
+        }
+    }
+    if (isRows || QSEQ_isActive()) { // the user records
+        for (int rec = QS_USER; rec <= QS_USER4 + 4; ++rec) {
+            setRec(glb, rec);
+        }
+    }
+    if (QTRC_isActive()) {
+        setRecs(glb, l_trcRecs);
+    }
+    if (QSEQ_isActive()) {
+        setRecs(glb, l_seqRecs);
+    }
+    if (QQUE_isActive()) {
+        setRecs(glb, l_queRecs);
+    }
+    if (isRows || QSEQ_isActive() || QTRC_isActive() || QQUE_isActive()) {
+        setMap(loc, (uint8_t const *)0);
+    }
+
+    // only the records passing the host-side filter are consumed...
+    QSpyHostFilter hf;
+    QSPY_getHostFilter(&hf);
+    for (unsigned i = 0U; i < FLT_MAP_SIZE; ++i) {
+        glb[i] &= hf.recMap[i];
+    }
+
+    // ...except by the capture container, which needs all records
+    if (QCAP_isActive()) {
+        setMap(glb, (uint8_t const *)0);
+        setMap(loc, (uint8_t const *)0);
+    }
+
+    // the records needed by QSPY itself
+    for (int rec = 0; rec < QS_USER; ++rec) {
+        int const grp = QSPY_getGroup(rec);
+        if ((grp == QSPY_GRP_INF) || (grp == QSPY_GRP_DIC)
+            || (grp == QSPY_GRP_TST))
+        {
+            setRec(glb, rec);
+        }
+    }
+    for (int rec = QS_USER4 + 5; rec < 8*(int)FLT_MAP_SIZE; ++rec) {
+        glb[rec >> 3] &= (uint8_t)~(1U << (rec & 7)); // no such records
+    }
+
+    bool const glbChanged = (memcmp(glb, l_glb, sizeof(glb)) != 0);
+    bool const locChanged = (memcmp(loc, l_loc, sizeof(loc)) != 0);
+    if (force || !l_pushed || glbChanged) {
+        memcpy(l_glb, glb, sizeof(glb));
+        sendFilter(QS_RX_GLB_FILTER, l_glb);
+    }
+    if (force || !l_pushed || locChanged) {
+        memcpy(l_loc, loc, sizeof(loc));
+        sendFilter(QS_RX_LOC_FILTER, l_loc);
+    }
+    if (force || !l_pushed || glbChanged || locChanged) {
+        int n = 0;
+        for (unsigned i = 0U; i < 8U*FLT_MAP_SIZE; ++i) {
+            n += (l_glb[i >> 3] >> (i & 7U)) & 1U;
+        }
+        SNPRINTF_LINE("   <QSPY-> Target Glb-Filter: %d records "
+                      "(demand-driven)", n);
+        QSPY_printInfo();
+    }
+    l_pushed = true;
+}
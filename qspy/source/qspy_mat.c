@@ -0,0 +1,444 @@
+//============================================================================
+// QSPY software tracing host-side utility
+//
+//                   Q u a n t u m  L e a P s
+//                   ------------------------
+//                   Modern Embedded Software
+//
+// Copyright(C) 2005 Quantum Leaps, LLC.All rights reserved.
+//
+// This software is licensed under the terms of the Quantum Leaps
+// QSPY SOFTWARE TRACING HOST UTILITY SOFTWARE END USER LICENSE.
+// Please see the file LICENSE-qspy.txt for the complete license text.
+//
+// Quantum Leaps contact information :
+// <www.state-machine.com/licensing>
+// <info@state-machine.com>
+//============================================================================
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // for fseeko()
+#define _FILE_OFFSET_BITS 64    // for the large temporary files
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#define Q_SPY   1       // this is QS implementation
+#define QP_IMPL 1       // this is QP implementation
+typedef int      int_t;   // dummy definition for including "qpc_qs.h"
+typedef int      enum_t;  // dummy definition for including "qpc_qs.h"
+typedef uint16_t QSignal; // dummy definition for including "qpc_qs.h"
+typedef uint32_t QSFun;   // dummy definition for including "qpc_qs.h"
+typedef uint32_t QSObj;   // dummy definition for including "qpc_qs.h"
+typedef uint32_t QEvt;    // dummy definition for including "qpc_qs.h"
+typedef uint32_t QActive; // dummy definition for including "qpc_qs.h"
+typedef uint32_t QPSet;   // dummy definition for including "qpc_qs.h"
+#include "qpc_qs.h"       // QS target-resident interface
+
+#include "safe_std.h"   // "safe" <stdio.h> and <string.h> facilities
+#include "qspy.h"       // QSPY data parser
+
+// Matlab output in the binary MAT-file format (Level 5)
+//
+// The records are collected into one numeric matrix per record group
+// (Q_STATE, Q_ACTIVE, Q_EQUEUE, Q_MPOOL, Q_TIME, ...). Every row holds the
+// same numbers as the corresponding line of the text Matlab output, that is,
+// the record-ID in the first column followed by the record data. Rows
+// shorter than the matrix are padded with NaN, and so are the string data.
+// The dictionaries are saved as variables, like the text output defines
+// them, and the whole capture is then loaded with a single `load`.
+//
+// MAT-files store matrices column by column, while the records arrive
+// row by row. Therefore the rows are collected in chunks of CHUNK_ROWS rows
+// stored by columns. The full chunks are spilled to a temporary file, so the
+// memory stays bounded for long captures. When the output is closed, every
+// matrix is written column after column, where each column of a chunk is
+// a single contiguous read from the temporary file.
+
+enum {
+    CHUNK_ROWS   = 4096, // rows per chunk
+    MAT_COLS_MAX = 256,  // max columns of a row (the rest is dropped)
+};
+
+// MAT-file (Level 5) data types and array classes
+enum {
+    miINT8   = 1,
+    miINT32  = 5,
+    miUINT32 = 6,
+    miDOUBLE = 9,
+    miMATRIX = 14,
+    mxDOUBLE_CLASS = 6,
+};
+
+// the groups of records collected into the matrices
+enum {
+    MAT_STATE, MAT_ACTIVE, MAT_EQUEUE, MAT_MPOOL, MAT_QF, MAT_TIME,
+    MAT_SCHED, MAT_SEM, MAT_MUTEX, MAT_USER, MAT_MISC,
+    MAT_NGROUPS,
+    MAT_NONE = MAT_NGROUPS // records not collected (dictionaries)
+};
+
+typedef struct {
+    int64_t  offset;  // offset of the chunk in the temporary file
+    uint32_t rows;
+    uint32_t cols;
+} MatChunk;
+
+typedef struct {
+    double   *buf;      // current chunk [CHUNK_ROWS x cols], by columns
+    uint32_t  rows;     // rows in the current chunk
+    uint32_t  cols;     // columns of the current chunk
+    MatChunk *spilled;  // the chunks spilled to the temporary file
+    uint32_t  nSpilled;
+    uint32_t  capSpilled;
+    uint64_t  totRows;  // rows in all chunks of the group
+    uint32_t  maxCols;  // columns of the matrix
+} MatGroup;
+
+#ifdef _WIN32
+#define FSEEK64(fp_, off_) _fseeki64((fp_), (off_), SEEK_SET)
+#else
+#define FSEEK64(fp_, off_) fseeko((fp_), (off_t)(off_), SEEK_SET)
+#endif
+
+//............................................................................
+static FILE    *l_file;  // the MAT-file
+static FILE    *l_spill; // the temporary file for the full chunks
+static int64_t  l_spillSize;
+static uint64_t l_tot;   // total number of records in the matrices
+static bool     l_wrErr; // failed write to the MAT-file?
+static MatGroup l_grp[MAT_NGROUPS];
+
+// names of the Matlab variables for the groups
+static char const * const l_grpName[MAT_NGROUPS] = {
+    "Q_STATE", "Q_ACTIVE", "Q_EQUEUE", "Q_MPOOL", "Q_QF", "Q_TIME",
+    "Q_SCHED", "Q_SEM",    "Q_MUTEX",  "Q_USER",  "Q_MISC"
+};
+
+static double   l_row[MAT_COLS_MAX]; // the row being composed
+static uint32_t l_nCols;
+static double   l_colBuf[CHUNK_ROWS];
+
+static void QMAT_close(void);
+
+//............................................................................
+static int groupOf(int recId) {
+    switch (QSPY_getGroup(recId)) {
+        case QS_GRP_SM:    return MAT_STATE;
+        case QS_GRP_AO:    return MAT_ACTIVE;
+        case QS_GRP_EQ:    return MAT_EQUEUE;
+        case QS_GRP_MP:    return MAT_MPOOL;
+        case QS_GRP_QF:    return MAT_QF;
+        case QS_GRP_TE:    return MAT_TIME;
+        case QS_GRP_SC:    return MAT_SCHED;
+        case QS_GRP_SEM:   return MAT_SEM;
+        case QS_GRP_MTX:   return MAT_MUTEX;
+        case QS_GRP_UA:    return MAT_USER;
+        case QSPY_GRP_DIC: return MAT_NONE; // saved from the dictionaries
+        default:           return MAT_MISC;
+    }
+}
+//............................................................................
+void QMAT_configFile(void *matFile) {
+    if (l_file != (FILE *)0) {
+        QMAT_close();
+    }
+    l_file  = (FILE *)matFile;
+    l_nCols = 0U;
+    l_tot   = 0U;
+    l_wrErr = false;
+    if (l_file != (FILE *)0) {
+        l_spill = tmpfile();
+        l_spillSize = 0;
+        if (l_spill == (FILE *)0) {
+            SNPRINTF_LINE("   <QSPY-> ERROR    %s",
+                          "Cannot create temporary file for Matlab output");
+            QSPY_printError();
+            fclose(l_file);
+            l_file = (FILE *)0;
+        }
+    }
+}
+//............................................................................
+bool QMAT_isActive(void) {
+    return l_file != (FILE *)0;
+}
+//............................................................................
+// collect the values of the text Matlab output into the row
+void QMAT_putVal(QSpyVal const *val) {
+    double x;
+    switch (val->type) {
+        case QSPY_VAL_I32:
+        case QSPY_VAL_I64:
+            x = (double)val->u.i;
+            break;
+        case QSPY_VAL_U32:
+        case QSPY_VAL_U64:
+            x = (double)val->u.u;
+            break;
+        case QSPY_VAL_F64:
+            x = val->u.f;
+            break;
+        default: // strings
+            x = NAN;
+            break;
+    }
+    if (l_nCols < MAT_COLS_MAX) {
+        l_row[l_nCols] = x;
+        ++l_nCols;
+    }
+}
+//............................................................................
+static bool spillChunk(MatGroup * const grp) {
+    if (grp->nSpilled == grp->capSpilled) {
+        uint32_t const cap = (grp->capSpilled != 0U)
+                             ? 2U * grp->capSpilled : 64U;
+        MatChunk *spilled = (MatChunk *)realloc(grp->spilled,
+                                                cap * sizeof(MatChunk));
+        if (spilled == (MatChunk *)0) {
+            return false;
+        }
+        grp->spilled    = spilled;
+        grp->capSpilled = cap;
+    }
+    MatChunk * const chunk = &grp->spilled[grp->nSpilled];
+    chunk->offset = l_spillSize;
+    chunk->rows   = grp->rows;
+    chunk->cols   = grp->cols;
+    if (FSEEK64(l_spill, l_spillSize) != 0) {
+        return false;
+    }
+    for (uint32_t c = 0U; c < grp->cols; ++c) {
+        if (fwrite(&grp->buf[(size_t)c * CHUNK_ROWS], sizeof(double),
+                   grp->rows, l_spill) != grp->rows)
+        {
+            return false;
+        }
+    }
+    l_spillSize += (int64_t)grp->rows * grp->cols * (int64_t)sizeof(double);
+    ++grp->nSpilled;
+    grp->rows = 0U;
+    return true;
+}
+//............................................................................
+void QMAT_endRow(void) {
+    uint32_t const n = l_nCols;
+    l_nCols = 0U;
+    if (n == 0U) {
+        return;
+    }
+    int const g = groupOf((int)l_row[0]);
+    if (g == MAT_NONE) {
+        return;
+    }
+    MatGroup * const grp = &l_grp[g];
+
+    if ((grp->rows == CHUNK_ROWS)
+        || ((n > grp->cols) && (grp->rows != 0U)))
+    {
+        // the chunk is full or too narrow for this row
+        if (!spillChunk(grp)) {
+            SNPRINTF_LINE("   <QSPY-> ERROR    %s",
+                          "Cannot write temporary file for Matlab output");
+            QSPY_printError();
+            return;
+        }
+    }
+    if ((n > grp->cols) || (grp->buf == (double *)0)) {
+        // the chunk is empty here, so it can be re-allocated wider
+        uint32_t const cols = (n > grp->cols) ? n : grp->cols;
+        double *buf = (double *)realloc(grp->buf,
+                          (size_t)cols * CHUNK_ROWS * sizeof(double));
+        if (buf == (double *)0) {
+            return;
+        }
+        grp->buf  = buf;
+        grp->cols = cols;
+        if (grp->maxCols < cols) {
+            grp->maxCols = cols;
+        }
+    }
+    uint32_t c;
+    for (c = 0U; c < n; ++c) {
+        grp->buf[(size_t)c * CHUNK_ROWS + grp->rows] = l_row[c];
+    }
+    for (; c < grp->cols; ++c) {
+        grp->buf[(size_t)c * CHUNK_ROWS + grp->rows] = NAN;
+    }
+    ++grp->rows;
+    ++grp->totRows;
+    ++l_tot;
+}
+
+//............................................................................
+static void putData(void const *data, size_t size, size_t n) {
+    if (fwrite(data, size, n, l_file) != n) {
+        l_wrErr = true; // e.g., disk full
+    }
+}
+//............................................................................
+static void putTag(uint32_t type, uint32_t nBytes) {
+    uint32_t const tag[2] = { type, nBytes };
+    putData(tag, sizeof(tag), 1U);
+}
+//............................................................................
+// start a real double matrix, returns the number of rows that fit into
+// the MAT-file element (limited to 4GB)
+static uint32_t putMatrixHeader(char const *name,
+                                uint64_t rows, uint32_t cols)
+{
+    static uint8_t const zeros[8] = { 0U };
+    uint32_t const nameLen = (uint32_t)strlen(name);
+    uint32_t const namePad = (nameLen + 7U) & ~7U;
+    uint32_t const overhead = 16U + 16U + 8U + namePad + 8U;
+    uint64_t const rowsMax = (0xFFFFFFF8U - overhead)
+                             / ((uint64_t)cols * sizeof(double));
+    if (rows > rowsMax) {
+        rows = rowsMax;
+    }
+    uint32_t const dataBytes = (uint32_t)(rows * cols * sizeof(double));
+    uint32_t const flags[2] = { mxDOUBLE_CLASS, 0U };
+    int32_t  const dims[2]  = { (int32_t)rows, (int32_t)cols };
+
+    putTag(miMATRIX, overhead + dataBytes);
+    putTag(miUINT32, sizeof(flags));
+    putData(flags, sizeof(flags), 1U);
+    putTag(miINT32, sizeof(dims));
+    putData(dims, sizeof(dims), 1U);
+    putTag(miINT8, nameLen);
+    putData(name, 1U, nameLen);
+    putData(zeros, 1U, namePad - nameLen);
+    putTag(miDOUBLE, dataBytes);
+    return (uint32_t)rows;
+}
+//............................................................................
+static void putVector(char const *name, double const *x, uint32_t n) {
+    (void)putMatrixHeader(name, 1U, n);
+    putData(x, sizeof(double), n);
+}
+//............................................................................
+static void putGroup(MatGroup * const grp, char const *name) {
+    uint32_t const rows = putMatrixHeader(name, grp->totRows, grp->maxCols);
+    if (rows < grp->totRows) {
+        SNPRINTF_LINE("   <QSPY-> ERROR    Matlab %s truncated to %u rows",
+                      name, (unsigned)rows);
+        QSPY_printError();
+    }
+    for (uint32_t c = 0U; c < grp->maxCols; ++c) {
+        uint32_t left = rows; // rows left to write in this column
+        for (uint32_t k = 0U; (k <= grp->nSpilled) && (left != 0U); ++k) {
+            uint32_t const n = (k < grp->nSpilled)
+                               ? grp->spilled[k].rows
+                               : grp->rows; // the current chunk
+            uint32_t const m = (n < left) ? n : left;
+            double const *col = l_colBuf;
+            if (k < grp->nSpilled) {
+                MatChunk const * const chunk = &grp->spilled[k];
+                if (c < chunk->cols) {
+                    int64_t const off = chunk->offset
+                        + (int64_t)c * chunk->rows * (int64_t)sizeof(double);
+                    if ((FSEEK64(l_spill, off) != 0)
+                        || (fread(l_colBuf, sizeof(double), m, l_spill)
+                            != m))
+                    {
+                        for (uint32_t r = 0U; r < m; ++r) {
+                            l_colBuf[r] = NAN;
+                        }
+                    }
+                }
+                else { // the chunk is narrower than the matrix
+                    for (uint32_t r = 0U; r < m; ++r) {
+                        l_colBuf[r] = NAN;
+                    }
+                }
+            }
+            else if (c < grp->cols) {
+                col = &grp->buf[(size_t)c * CHUNK_ROWS];
+            }
+            else {
+                for (uint32_t r = 0U; r < m; ++r) {
+                    l_colBuf[r] = NAN;
+                }
+            }
+            putData(col, sizeof(double), m);
+            left -= m;
+        }
+    }
+}
+//............................................................................
+static void putHeader(void) {
+    char text[116 + 1];
+    time_t now = time(NULL);
+    struct tm tm;
+    LOCALTIME_S(&tm, &now);
+    int n = SNPRINTF_S(text, sizeof(text),
+                "MATLAB 5.0 MAT-file, Platform: QSPY %s, "
+                "Created on: %04d-%02d-%02d %02d:%02d:%02d",
+                QSPY_VER, tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                tm.tm_hour, tm.tm_min, tm.tm_sec);
+    if ((n < 0) || (n > 116)) {
+        n = 116;
+    }
+    memset(&text[n], ' ', (size_t)(116 - n));
+    putData(text, 1U, 116U);
+
+    static uint8_t const subsys[8] = { 0U };
+    putData(subsys, 1U, sizeof(subsys));
+
+    // the version and the endian indicator in the native byte order
+    uint16_t const ver[2] = { 0x0100U, ((uint16_t)'M' << 8) | 'I' };
+    putData(ver, sizeof(ver), 1U);
+}
+//............................................................................
+static void QMAT_close(void) {
+    QMAT_endRow(); // finish the row possibly in progress
+
+    putHeader();
+    for (int g = 0; g < MAT_NGROUPS; ++g) {
+        MatGroup * const grp = &l_grp[g];
+        if (grp->totRows != 0U) {
+            putGroup(grp, l_grpName[g]);
+        }
+        free(grp->buf);
+        free(grp->spilled);
+        grp->buf      = (double *)0;
+        grp->spilled  = (MatChunk *)0;
+        grp->rows     = 0U;
+        grp->cols     = 0U;
+        grp->nSpilled = 0U;
+        grp->capSpilled = 0U;
+        grp->totRows  = 0U;
+        grp->maxCols  = 0U;
+    }
+    double x = (double)l_tot;
+    putVector("Q_TOT", &x, 1U);
+
+    // the dictionaries, like the text output defines them
+    for (int i = 0; i < QSPY_objDict.entries; ++i) {
+        x = (double)(int64_t)QSPY_objDict.sto[i].key;
+        putVector(QSPY_getMatDict(QSPY_objDict.sto[i].name), &x, 1U);
+    }
+    for (int i = 0; i < QSPY_funDict.entries; ++i) {
+        x = (double)(int64_t)QSPY_funDict.sto[i].key;
+        putVector(QSPY_getMatDict(QSPY_funDict.sto[i].name), &x, 1U);
+    }
+    for (int i = 0; i < QSPY_sigDict.entries; ++i) {
+        double const sig[2] = {
+            (double)QSPY_sigDict.sto[i].sig,
+            (double)(int64_t)QSPY_sigDict.sto[i].obj
+        };
+        putVector(QSPY_getMatDict(QSPY_sigDict.sto[i].name), sig, 2U);
+    }
+
+    if ((fclose(l_file) != 0) || l_wrErr) {
+        SNPRINTF_LINE("   <QSPY-> ERROR    %s",
+                      "Cannot write Matlab output (file truncated)");
+        QSPY_printError();
+    }
+    fclose(l_spill);
+    l_file  = (FILE *)0;
+    l_spill = (FILE *)0;
+}
@@ -0,0 +1,792 @@
+//============================================================================
+// QSPY software tracing host-side utility
+//
+//                   Q u a n t u m  L e a P s
+//                   ------------------------
+//                   Modern Embedded Software
+//
+// Copyright(C) 2005 Quantum Leaps, LLC.All rights reserved.
+//
+// This software is licensed under the terms of the Quantum Leaps
+// QSPY SOFTWARE TRACING HOST UTILITY SOFTWARE END USER LICENSE.
+// Please see the file LICENSE-qspy.txt for the complete license text.
+//
+// Quantum Leaps contact information :
+// <www.state-machine.com/licensing>
+// <info@state-machine.com>
+//============================================================================
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // for fseeko()
+#define _FILE_OFFSET_BITS 64    // for the large temporary files
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <math.h>
+#include <time.h>
+
+#define Q_SPY   1       // this is QS implementation
+#define QP_IMPL 1       // this is QP implementation
+typedef int      int_t;   // dummy definition for including "qpc_qs.h"
+typedef int      enum_t;  // dummy definition for including "qpc_qs.h"
+typedef uint16_t QSignal; // dummy definition for including "qpc_qs.h"
+typedef uint32_t QSFun;   // dummy definition for including "qpc_qs.h"
+typedef uint32_t QSObj;   // dummy definition for including "qpc_qs.h"
+typedef uint32_t QEvt;    // dummy definition for including "qpc_qs.h"
+typedef uint32_t QActive; // dummy definition for including "qpc_qs.h"
+typedef uint32_t QPSet;   // dummy definition for including "qpc_qs.h"
+#include "qpc_qs.h"       // QS target-resident interface
+
+#include "safe_std.h"   // "safe" <stdio.h> and <string.h> facilities
+#include "qspy.h"       // QSPY data parser
+
+// NumPy output in the .npz format (ZIP archive of .npy arrays)
+//
+// Every record type gets its own set of columns, one 1-D array per field,
+// named "<record>/<field>", for example "QS_QF_ACTIVE_POST/t",
+// "QS_QF_ACTIVE_POST/sender", ... "QS_QF_ACTIVE_POST/min". The fields are
+// the values of the Matlab output of the record (without the record-ID),
+// named by QSPY_getRecFields(). The user records are named after the
+// user dictionary (or "USER+nnn") and their fields "t", "c1", "c2", ...
+// in the order of QSpyRecord_processUser(). The string fields are stored
+// as indexes into the "strings" array and the dictionaries are saved as
+// the arrays "obj_dict/key", "obj_dict/name", "fun_dict/...",
+// "sig_dict/sig", "sig_dict/obj", "sig_dict/name" and "usr_dict/...".
+// The whole capture is then loaded with numpy.load(), e.g.:
+//
+//     z = numpy.load('capture.npz')
+//     post_t = z['QS_QF_ACTIVE_POST/t']
+//
+// The type of every column is determined by its first value (uint32 for
+// %u, int64 for the 64-bit object and function pointers, float64, ...)
+// and widened when a later value does not fit it (e.g., int32 and uint32
+// to int64, any integer and float64 to float64).
+// Rows shorter than the record type (e.g., user records with variable
+// number of fields) are padded with 0 (NaN for floats, -1 for strings).
+//
+// The columns are collected in blocks of BLOCK_ROWS rows per record type.
+// The full blocks are spilled to a temporary file, so the memory stays
+// bounded for long captures. When the output is closed, every column is
+// assembled from its segments of the blocks into one .npy member of the
+// archive. The members are stored uncompressed and the archive is limited
+// to 4GB (no ZIP64 extensions).
+
+enum {
+    BLOCK_ROWS   = 4096,  // rows of a block
+    NPY_COLS_MAX = 64,    // max fields of a record (the rest is dropped)
+    NPY_REC_MAX  = 256,   // record-IDs
+    STR_MAX      = 65536, // max different strings in the user records
+    STR_HASH     = 2 * STR_MAX, // size of the string hash table
+};
+
+typedef struct {
+    int64_t  offset;  // offset of the block in the temporary file
+    uint32_t rows;
+    uint32_t cols;    // columns of the record type at the time of spilling
+    uint8_t  type[NPY_COLS_MAX]; // QSpyValType of the columns when spilled
+} NpyBlock;
+
+typedef struct {
+    uint8_t  *buf[NPY_COLS_MAX];  // current block of the columns
+    uint8_t   type[NPY_COLS_MAX]; // QSpyValType of the columns
+    uint32_t  cols;
+    uint32_t  rows;     // rows in the current block
+    NpyBlock *spilled;  // the blocks spilled to the temporary file
+    uint32_t  nSpilled;
+    uint32_t  capSpilled;
+    uint64_t  totRows;  // rows in all blocks of the record type
+} NpyRec;
+
+typedef struct {
+    uint32_t crc;
+    uint32_t size;
+    uint32_t offset;   // offset of the local header
+    char    *name;
+} ZipEntry;
+
+#ifdef _WIN32
+#define FSEEK64(fp_, off_) _fseeki64((fp_), (off_), SEEK_SET)
+#else
+#define FSEEK64(fp_, off_) fseeko((fp_), (off_t)(off_), SEEK_SET)
+#endif
+
+//............................................................................
+static FILE    *l_file;  // the .npz file
+static FILE    *l_spill; // the temporary file for the full blocks
+static int64_t  l_spillSize;
+static NpyRec   l_rec[NPY_REC_MAX];
+
+static QSpyVal  l_row[1 + NPY_COLS_MAX]; // the row being composed
+static uint32_t l_nVals;
+
+static char    *l_str[STR_MAX];   // the strings of the user records
+static uint32_t l_nStr;
+static int32_t  l_strHash[STR_HASH]; // indexes into l_str[] + 1 (0: empty)
+
+static ZipEntry *l_zipDir;  // the central directory of the archive
+static uint32_t  l_nZip;
+static uint32_t  l_capZip;
+static uint64_t  l_zipPos;  // the current position in the archive
+static uint32_t  l_zipCrc;  // CRC-32 of the current member
+static uint32_t  l_zipSize; // size of the current member
+static uint16_t  l_zipTime;
+static uint16_t  l_zipDate;
+static bool      l_zipFull; // the archive reached the 4GB limit
+static bool      l_wrErr;   // writing the archive failed (e.g., disk full)
+
+static uint32_t  l_crcTable[256];
+static uint8_t   l_ioBuf[BLOCK_ROWS * 8];
+
+static void QNPY_close(void);
+
+//............................................................................
+static uint32_t itemSize(uint8_t type) {
+    return ((type == QSPY_VAL_I32) || (type == QSPY_VAL_U32)
+            || (type == QSPY_VAL_STR)) ? 4U : 8U;
+}
+//............................................................................
+static void putError(char const *msg) {
+    SNPRINTF_LINE("   <QSPY-> ERROR    %s", msg);
+    QSPY_printError();
+}
+//............................................................................
+void QNPY_configFile(void *npzFile) {
+    if (l_file != (FILE *)0) {
+        QNPY_close();
+    }
+    l_file  = (FILE *)npzFile;
+    l_nVals = 0U;
+    if (l_file != (FILE *)0) {
+        l_spill = tmpfile();
+        l_spillSize = 0;
+        if (l_spill == (FILE *)0) {
+            putError("Cannot create temporary file for NumPy output");
+            fclose(l_file);
+            l_file = (FILE *)0;
+        }
+    }
+}
+//............................................................................
+bool QNPY_isActive(void) {
+    return l_file != (FILE *)0;
+}
+
+//............................................................................
+// index of the string in the string table (added when not there yet)
+static int32_t strIndex(char const *s) {
+    uint32_t h = 2166136261U; // FNV-1a
+    for (char const *c = s; *c != '\0'; ++c) {
+        h = (h ^ (uint8_t)*c) * 16777619U;
+    }
+    for (uint32_t i = h & (STR_HASH - 1U); ; i = (i + 1U) & (STR_HASH - 1U)) {
+        int32_t const k = l_strHash[i];
+        if (k == 0) { // empty slot?
+            if (l_nStr == STR_MAX) {
+                return -1; // string table full
+            }
+            size_t const len = strlen(s) + 1U;
+            char *str = (char *)malloc(len);
+            if (str == (char *)0) {
+                return -1;
+            }
+            memcpy(str, s, len);
+            l_str[l_nStr] = str;
+            ++l_nStr;
+            l_strHash[i] = (int32_t)l_nStr;
+            return (int32_t)(l_nStr - 1U);
+        }
+        if (strcmp(l_str[k - 1], s) == 0) {
+            return k - 1;
+        }
+    }
+}
+//............................................................................
+void QNPY_putVal(QSpyVal const *val) {
+    if (l_nVals < sizeof(l_row)/sizeof(l_row[0])) {
+        l_row[l_nVals] = *val;
+        ++l_nVals;
+    }
+}
+//............................................................................
+// store the value in the representation of the column
+static void putCell(uint8_t *cell, uint8_t type, QSpyVal const *val) {
+    int64_t  i;
+    uint64_t u;
+    double   f;
+    switch (val->type) {
+        case QSPY_VAL_U32:
+        case QSPY_VAL_U64:
+            u = val->u.u;
+            i = (int64_t)u;
+            f = (double)u;
+            break;
+        case QSPY_VAL_F64:
+            f = val->u.f;
+            i = (int64_t)f;
+            u = (uint64_t)i;
+            break;
+        case QSPY_VAL_STR:
+            i = strIndex(val->u.s);
+            u = (uint64_t)i;
+            f = NAN;
+            break;
+        default: // signed integers
+            i = val->u.i;
+            u = (uint64_t)i;
+            f = (double)i;
+            break;
+    }
+    switch (type) {
+        case QSPY_VAL_I32: {
+            int32_t const x = (int32_t)i;
+            memcpy(cell, &x, sizeof(x));
+            break;
+        }
+        case QSPY_VAL_U32: {
+            uint32_t const x = (uint32_t)u;
+            memcpy(cell, &x, sizeof(x));
+            break;
+        }
+        case QSPY_VAL_STR: {
+            int32_t const x = (val->type == QSPY_VAL_STR) ? (int32_t)i : -1;
+            memcpy(cell, &x, sizeof(x));
+            break;
+        }
+        case QSPY_VAL_F64:
+            memcpy(cell, &f, sizeof(f));
+            break;
+        case QSPY_VAL_U64:
+            memcpy(cell, &u, sizeof(u));
+            break;
+        default:
+            memcpy(cell, &i, sizeof(i));
+            break;
+    }
+}
+//............................................................................
+// the type of the column holding both the values of the given types
+static uint8_t widenType(uint8_t type, uint8_t valType) {
+    if ((type == valType) || (type == QSPY_VAL_STR)
+        || (valType == QSPY_VAL_STR))
+    {
+        return type; // strings are never mixed with numbers
+    }
+    if ((type == QSPY_VAL_F64) || (valType == QSPY_VAL_F64)) {
+        return QSPY_VAL_F64;
+    }
+    if (((type == QSPY_VAL_U32) || (type == QSPY_VAL_U64))
+        && ((valType == QSPY_VAL_U32) || (valType == QSPY_VAL_U64)))
+    {
+        return QSPY_VAL_U64;
+    }
+    return QSPY_VAL_I64;
+}
+//............................................................................
+// convert n cells to the type of the same or larger size (in place)
+static void widenCells(uint8_t *cells, uint8_t type, uint8_t from,
+                       uint32_t n)
+{
+    uint32_t const size    = itemSize(type);
+    uint32_t const oldSize = itemSize(from);
+    for (uint32_t k = n; k > 0U; --k) { // backwards, as the cells grow
+        uint8_t * const cell = &cells[(k - 1U) * oldSize];
+        QSpyVal val;
+        val.type = (QSpyValType)from;
+        switch (from) {
+            case QSPY_VAL_I32: {
+                int32_t x;
+                memcpy(&x, cell, sizeof(x));
+                val.u.i = x;
+                break;
+            }
+            case QSPY_VAL_U32: {
+                uint32_t x;
+                memcpy(&x, cell, sizeof(x));
+                val.u.u = x;
+                break;
+            }
+            case QSPY_VAL_U64:
+                memcpy(&val.u.u, cell, sizeof(val.u.u));
+                break;
+            default: // QSPY_VAL_I64 (columns of strings are not widened)
+                memcpy(&val.u.i, cell, sizeof(val.u.i));
+                break;
+        }
+        putCell(&cells[(k - 1U) * size], type, &val);
+    }
+}
+//............................................................................
+// store the padding value of the column (for the missing fields)
+static void padCells(uint8_t *cell, uint8_t type, uint32_t n) {
+    uint32_t const size = itemSize(type);
+    if (type == QSPY_VAL_F64) {
+        double const nan = NAN;
+        for (uint32_t k = 0U; k < n; ++k, cell += size) {
+            memcpy(cell, &nan, size);
+        }
+    }
+    else {
+        memset(cell, (type == QSPY_VAL_STR) ? 0xFF : 0, (size_t)n * size);
+    }
+}
+//............................................................................
+static bool spillBlock(NpyRec * const rec) {
+    if (rec->nSpilled == rec->capSpilled) {
+        uint32_t const cap = (rec->capSpilled != 0U)
+                             ? 2U * rec->capSpilled : 64U;
+        NpyBlock *spilled = (NpyBlock *)realloc(rec->spilled,
+                                                cap * sizeof(NpyBlock));
+        if (spilled == (NpyBlock *)0) {
+            return false;
+        }
+        rec->spilled    = spilled;
+        rec->capSpilled = cap;
+    }
+    NpyBlock * const blk = &rec->spilled[rec->nSpilled];
+    blk->offset = l_spillSize;
+    blk->rows   = rec->rows;
+    blk->cols   = rec->cols;
+    memcpy(blk->type, rec->type, rec->cols);
+    if (FSEEK64(l_spill, l_spillSize) != 0) {
+        return false;
+    }
+    for (uint32_t c = 0U; c < rec->cols; ++c) {
+        uint32_t const size = itemSize(rec->type[c]);
+        if (fwrite(rec->buf[c], size, rec->rows, l_spill) != rec->rows) {
+            return false;
+        }
+        l_spillSize += (int64_t)rec->rows * size;
+    }
+    ++rec->nSpilled;
+    rec->rows = 0U;
+    return true;
+}
+//............................................................................
+void QNPY_endRow(void) {
+    uint32_t const n = l_nVals;
+    l_nVals = 0U;
+    if ((n == 0U) || (l_row[0].type != QSPY_VAL_I32)
+        || (l_row[0].u.i < 0) || (l_row[0].u.i >= NPY_REC_MAX))
+    {
+        return; // not a record row
+    }
+    int const recId = (int)l_row[0].u.i;
+    if (QSPY_getGroup(recId) == QSPY_GRP_DIC) {
+        return; // saved from the dictionaries
+    }
+    NpyRec * const rec = &l_rec[recId];
+
+    if (rec->rows == BLOCK_ROWS) {
+        if (!spillBlock(rec)) {
+            putError("Cannot write temporary file for NumPy output");
+            return;
+        }
+    }
+    uint32_t const nFields = n - 1U;
+    for (uint32_t c = rec->cols; c < nFields; ++c) { // new columns?
+        uint8_t const type = (uint8_t)l_row[1U + c].type;
+        // room for the widest type, so the column can be widened in place
+        uint8_t *buf = (uint8_t *)malloc((size_t)BLOCK_ROWS * 8U);
+        if (buf == (uint8_t *)0) {
+            putError("Out of memory for NumPy output");
+            return;
+        }
+        padCells(buf, type, rec->rows); // the rows so far miss the field
+        rec->buf[c]  = buf;
+        rec->type[c] = type;
+        rec->cols    = c + 1U;
+    }
+    uint32_t c;
+    for (c = 0U; c < nFields; ++c) {
+        uint8_t const type = widenType(rec->type[c],
+                                       (uint8_t)l_row[1U + c].type);
+        if (type != rec->type[c]) { // the value does not fit the column?
+            widenCells(rec->buf[c], type, rec->type[c], rec->rows);
+            rec->type[c] = type;
+        }
+        putCell(&rec->buf[c][rec->rows * itemSize(rec->type[c])],
+                rec->type[c], &l_row[1U + c]);
+    }
+    for (; c < rec->cols; ++c) {
+        padCells(&rec->buf[c][rec->rows * itemSize(rec->type[c])],
+                 rec->type[c], 1U);
+    }
+    ++rec->rows;
+    ++rec->totRows;
+}
+
+// ZIP archive ...............................................................
+static void put16(uint8_t *p, uint32_t x) {
+    p[0] = (uint8_t)x;
+    p[1] = (uint8_t)(x >> 8);
+}
+//............................................................................
+static void put32(uint8_t *p, uint32_t x) {
+    put16(p, x);
+    put16(&p[2], x >> 16);
+}
+//............................................................................
+static void zipWrite(void const *data, size_t n) {
+    if (fwrite(data, 1U, n, l_file) != n) {
+        l_wrErr = true;
+    }
+    l_zipPos += n;
+}
+//............................................................................
+static void zipData(void const *data, size_t n) {
+    uint8_t const *p = (uint8_t const *)data;
+    uint32_t crc = l_zipCrc;
+    for (size_t k = 0U; k < n; ++k) {
+        crc = l_crcTable[(crc ^ p[k]) & 0xFFU] ^ (crc >> 8);
+    }
+    l_zipCrc   = crc;
+    l_zipSize += (uint32_t)n;
+    zipWrite(data, n);
+}
+//............................................................................
+// start the member of the archive with the given size, where the CRC is
+// patched when the member is ended
+static bool zipBegin(char const *name, uint64_t size) {
+    if (l_zipFull) {
+        return false;
+    }
+    size_t const nameLen = strlen(name);
+    if ((l_zipPos + 30U + nameLen + size > 0xFFFFFFFFU)
+        || (l_nZip == 0xFFFFU))
+    {
+        putError("NumPy output exceeds 4GB, the rest is dropped");
+        l_zipFull = true;
+        return false;
+    }
+    if (l_nZip == l_capZip) {
+        uint32_t const cap = (l_capZip != 0U) ? 2U * l_capZip : 64U;
+        ZipEntry *dir = (ZipEntry *)realloc(l_zipDir,
+                                            cap * sizeof(ZipEntry));
+        if (dir == (ZipEntry *)0) {
+            return false;
+        }
+        l_zipDir = dir;
+        l_capZip = cap;
+    }
+    ZipEntry * const e = &l_zipDir[l_nZip];
+    e->name = (char *)malloc(nameLen + 1U);
+    if (e->name == (char *)0) {
+        return false;
+    }
+    memcpy(e->name, name, nameLen + 1U);
+    e->offset = (uint32_t)l_zipPos;
+    e->size   = (uint32_t)size;
+    ++l_nZip;
+
+    uint8_t hdr[30];
+    put32(&hdr[0],  0x04034B50U); // local file header signature
+    put16(&hdr[4],  20U);         // version needed to extract
+    put16(&hdr[6],  0U);          // flags
+    put16(&hdr[8],  0U);          // stored
+    put16(&hdr[10], l_zipTime);
+    put16(&hdr[12], l_zipDate);
+    put32(&hdr[14], 0U);          // CRC-32 (patched)
+    put32(&hdr[18], (uint32_t)size);
+    put32(&hdr[22], (uint32_t)size);
+    put16(&hdr[26], (uint32_t)nameLen);
+    put16(&hdr[28], 0U);          // extra field length
+    zipWrite(hdr, sizeof(hdr));
+    zipWrite(name, nameLen);
+    l_zipCrc  = 0xFFFFFFFFU;
+    l_zipSize = 0U;
+    return true;
+}
+//............................................................................
+static void zipEnd(void) {
+    ZipEntry * const e = &l_zipDir[l_nZip - 1U];
+    e->crc = l_zipCrc ^ 0xFFFFFFFFU;
+    if (l_zipSize != e->size) {
+        putError("NumPy output member size mismatch");
+    }
+    uint8_t crc[4];
+    put32(crc, e->crc);
+    if ((FSEEK64(l_file, (int64_t)e->offset + 14) != 0)
+        || (fwrite(crc, 1U, sizeof(crc), l_file) != sizeof(crc))
+        || (FSEEK64(l_file, (int64_t)l_zipPos) != 0))
+    {
+        l_wrErr = true;
+    }
+}
+//............................................................................
+static void zipFinish(void) {
+    uint64_t const dirPos = l_zipPos;
+    uint32_t n = 0U;
+    for (uint32_t k = 0U; k < l_nZip; ++k) {
+        ZipEntry * const e = &l_zipDir[k];
+        size_t const nameLen = strlen(e->name);
+        uint8_t hdr[46];
+        put32(&hdr[0],  0x02014B50U); // central file header signature
+        put16(&hdr[4],  20U);         // version made by
+        put16(&hdr[6],  20U);         // version needed to extract
+        put16(&hdr[8],  0U);          // flags
+        put16(&hdr[10], 0U);          // stored
+        put16(&hdr[12], l_zipTime);
+        put16(&hdr[14], l_zipDate);
+        put32(&hdr[16], e->crc);
+        put32(&hdr[20], e->size);
+        put32(&hdr[24], e->size);
+        put16(&hdr[28], (uint32_t)nameLen);
+        put16(&hdr[30], 0U);          // extra field length
+        put16(&hdr[32], 0U);          // file comment length
+        put16(&hdr[34], 0U);          // disk number start
+        put16(&hdr[36], 0U);          // internal file attributes
+        put32(&hdr[38], 0U);          // external file attributes
+        put32(&hdr[42], e->offset);
+        zipWrite(hdr, sizeof(hdr));
+        zipWrite(e->name, nameLen);
+        free(e->name);
+        ++n;
+    }
+    uint8_t end[22];
+    put32(&end[0],  0x06054B50U); // end of central directory signature
+    put16(&end[4],  0U);          // number of this disk
+    put16(&end[6],  0U);          // disk with the central directory
+    put16(&end[8],  n);
+    put16(&end[10], n);
+    put32(&end[12], (uint32_t)(l_zipPos - dirPos));
+    put32(&end[16], (uint32_t)dirPos);
+    put16(&end[20], 0U);          // comment length
+    zipWrite(end, sizeof(end));
+
+    free(l_zipDir);
+    l_zipDir = (ZipEntry *)0;
+    l_nZip   = 0U;
+    l_capZip = 0U;
+}
+
+// NumPy arrays ..............................................................
+// start the .npy member of the archive with the 1-D array of n items
+static bool npyBegin(char const *name, char const *descr,
+                     uint32_t size, uint64_t n)
+{
+    uint16_t const one = 1U;
+    char header[128];
+    int len = SNPRINTF_S(header, sizeof(header) - 1U,
+        "{'descr': '%c%s', 'fortran_order': False, 'shape': (%llu,), }",
+        (*(uint8_t const *)&one != 0U) ? '<' : '>', descr,
+        (unsigned long long)n);
+    // pad the header with spaces to the 64-byte alignment of the data
+    while (((10 + len + 1) % 64) != 0) {
+        header[len] = ' ';
+        ++len;
+    }
+    header[len] = '\n';
+    ++len;
+
+    char member[2*QS_DNAME_LEN_MAX + 8];
+    SNPRINTF_S(member, sizeof(member), "%s.npy", name);
+    if (!zipBegin(member, 10U + (uint64_t)len + n * size)) {
+        return false;
+    }
+    uint8_t magic[10] = { 0x93U, 'N', 'U', 'M', 'P', 'Y', 1U, 0U };
+    put16(&magic[8], (uint32_t)len);
+    zipData(magic, sizeof(magic));
+    zipData(header, (size_t)len);
+    return true;
+}
+//............................................................................
+// save the strings as the array of fixed-length byte strings
+static void putNames(char const *name, char const * const *str, uint32_t n) {
+    size_t w = 1U;
+    for (uint32_t k = 0U; k < n; ++k) {
+        size_t const len = strlen(str[k]);
+        if (w < len) {
+            w = len;
+        }
+    }
+    if (w > sizeof(l_ioBuf)) {
+        w = sizeof(l_ioBuf); // longer strings are truncated
+    }
+    char descr[16];
+    SNPRINTF_S(descr, sizeof(descr), "S%u", (unsigned)w);
+    if (npyBegin(name, descr, (uint32_t)w, n)) {
+        for (uint32_t k = 0U; k < n; ++k) {
+            size_t const len = strlen(str[k]);
+            memset(l_ioBuf, 0, w);
+            memcpy(l_ioBuf, str[k], (len < w) ? len : w);
+            zipData(l_ioBuf, w);
+        }
+        zipEnd();
+    }
+}
+//............................................................................
+// save the keys of the dictionary entries (of the given size and offset
+// in the entry) as the array of integers
+static void putKeys(char const *name, char const *descr, uint32_t size,
+                    void const *sto, size_t stride, size_t off, uint32_t n)
+{
+    if (npyBegin(name, descr, size, n)) {
+        for (uint32_t k = 0U; k < n; ++k) {
+            zipData((uint8_t const *)sto + k * stride + off, size);
+        }
+        zipEnd();
+    }
+}
+//............................................................................
+// assemble the column from the spilled blocks and the current block
+static void putColumn(NpyRec * const rec, uint32_t c, char const *name) {
+    static char const * const descr[] = {
+        "i4", "u4", "i8", "u8", "f8", "i4"
+    };
+    uint8_t const type = rec->type[c];
+    uint32_t const size = itemSize(type);
+    if (!npyBegin(name, descr[type], size, rec->totRows)) {
+        return;
+    }
+    for (uint32_t k = 0U; k <= rec->nSpilled; ++k) {
+        if (k == rec->nSpilled) { // the current block
+            zipData(rec->buf[c], (size_t)rec->rows * size);
+            break;
+        }
+        NpyBlock const * const blk = &rec->spilled[k];
+        if (c < blk->cols) {
+            int64_t off = blk->offset;
+            for (uint32_t j = 0U; j < c; ++j) {
+                off += (int64_t)blk->rows * itemSize(blk->type[j]);
+            }
+            uint8_t const from = blk->type[c];
+            if ((FSEEK64(l_spill, off) != 0)
+                || (fread(l_ioBuf, itemSize(from), blk->rows, l_spill)
+                    != blk->rows))
+            {
+                padCells(l_ioBuf, type, blk->rows);
+            }
+            else if (from != type) { // the column was widened later?
+                widenCells(l_ioBuf, type, from, blk->rows);
+            }
+        }
+        else { // the field did not exist yet
+            padCells(l_ioBuf, type, blk->rows);
+        }
+        zipData(l_ioBuf, (size_t)blk->rows * size);
+    }
+    zipEnd();
+}
+//............................................................................
+static void putRecord(int recId) {
+    NpyRec * const rec = &l_rec[recId];
+    char recName[QS_DNAME_LEN_MAX];
+    char const *s = QSPY_getRecName(recId);
+    if (s != (char const *)0) {
+        SNPRINTF_S(recName, sizeof(recName), "%s", s);
+    }
+    else {
+        SNPRINTF_S(recName, sizeof(recName), "USER+%03d", recId - QS_USER);
+    }
+    char const *fields = QSPY_getRecFields(recId);
+    for (uint32_t c = 0U; c < rec->cols; ++c) {
+        char name[2*QS_DNAME_LEN_MAX];
+        char const *f = fields;
+        for (uint32_t j = 0U; (j < c) && (f != (char const *)0); ++j) {
+            f = strchr(f, ',');
+            if (f != (char const *)0) {
+                ++f;
+            }
+        }
+        if (f != (char const *)0) {
+            size_t const len = strcspn(f, ",");
+            SNPRINTF_S(name, sizeof(name), "%s/%.*s",
+                       recName, (int)len, f);
+        }
+        else { // unnamed field
+            SNPRINTF_S(name, sizeof(name), "%s/c%u", recName, (unsigned)c);
+        }
+        putColumn(rec, c, name);
+    }
+}
+//............................................................................
+static void QNPY_close(void) {
+    QNPY_endRow(); // finish the row possibly in progress
+
+    for (uint32_t k = 0U; k < 256U; ++k) {
+        uint32_t crc = k;
+        for (int j = 0; j < 8; ++j) {
+            crc = (crc & 1U) ? ((crc >> 1) ^ 0xEDB88320U) : (crc >> 1);
+        }
+        l_crcTable[k] = crc;
+    }
+    time_t now = time(NULL);
+    struct tm tm;
+    LOCALTIME_S(&tm, &now);
+    l_zipTime = (uint16_t)((tm.tm_hour << 11) | (tm.tm_min << 5)
+                           | (tm.tm_sec / 2));
+    l_zipDate = (uint16_t)(((tm.tm_year - 80) << 9)
+                           | ((tm.tm_mon + 1) << 5) | tm.tm_mday);
+    l_zipPos  = 0U;
+    l_zipFull = false;
+    l_wrErr   = false;
+
+    for (int r = 0; r < NPY_REC_MAX; ++r) {
+        NpyRec * const rec = &l_rec[r];
+        if (rec->totRows != 0U) {
+            putRecord(r);
+        }
+        for (uint32_t c = 0U; c < rec->cols; ++c) {
+            free(rec->buf[c]);
+        }
+        free(rec->spilled);
+        memset(rec, 0, sizeof(*rec));
+    }
+
+    // the dictionaries
+    Dictionary const * const dict[] = {
+        &QSPY_objDict, &QSPY_funDict, &QSPY_usrDict
+    };
+    static char const * const dictName[] = {
+        "obj_dict", "fun_dict", "usr_dict"
+    };
+    for (unsigned d = 0U; d < sizeof(dict)/sizeof(dict[0]); ++d) {
+        char name[32];
+        uint32_t const n = (uint32_t)dict[d]->entries;
+        char const **names = (char const **)malloc((n + 1U) * sizeof(char *));
+        if (names == (char const **)0) {
+            break;
+        }
+        for (uint32_t k = 0U; k < n; ++k) {
+            names[k] = dict[d]->sto[k].name;
+        }
+        SNPRINTF_S(name, sizeof(name), "%s/%s", dictName[d],
+                   (dict[d] == &QSPY_usrDict) ? "rec" : "key");
+        putKeys(name, "i8", sizeof(KeyType), dict[d]->sto, sizeof(DictEntry),
+                offsetof(DictEntry, key), n);
+        SNPRINTF_S(name, sizeof(name), "%s/name", dictName[d]);
+        putNames(name, names, n);
+        free((void *)names);
+    }
+    uint32_t const nSig = (uint32_t)QSPY_sigDict.entries;
+    char const **names = (char const **)malloc((nSig + 1U) * sizeof(char *));
+    if (names != (char const **)0) {
+        for (uint32_t k = 0U; k < nSig; ++k) {
+            names[k] = QSPY_sigDict.sto[k].name;
+        }
+        putKeys("sig_dict/sig", "u4", sizeof(SigType), QSPY_sigDict.sto,
+                sizeof(SigDictEntry), offsetof(SigDictEntry, sig), nSig);
+        putKeys("sig_dict/obj", "i8", sizeof(ObjType), QSPY_sigDict.sto,
+                sizeof(SigDictEntry), offsetof(SigDictEntry, obj), nSig);
+        putNames("sig_dict/name", names, nSig);
+        free((void *)names);
+    }
+
+    // the strings of the user records
+    putNames("strings", (char const * const *)l_str, l_nStr);
+    for (uint32_t k = 0U; k < l_nStr; ++k) {
+        free(l_str[k]);
+    }
+    l_nStr = 0U;
+    memset(l_strHash, 0, sizeof(l_strHash));
+
+    zipFinish();
+    if ((fclose(l_file) != 0) || l_wrErr) {
+        putError("Cannot write NumPy output (file truncated)");
+    }
+    fclose(l_spill);
+    l_file  = (FILE *)0;
+    l_spill = (FILE *)0;
+}
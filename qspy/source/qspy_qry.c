@@ -0,0 +1,921 @@
+//============================================================================
+// QSPY software tracing host-side utility
+//
+//                   Q u a n t u m  L e a P s
+//                   ------------------------
+//                   Modern Embedded Software
+//
+// Copyright(C) 2005 Quantum Leaps, LLC.All rights reserved.
+//
+// This software is licensed under the terms of the Quantum Leaps
+// QSPY SOFTWARE TRACING HOST UTILITY SOFTWARE END USER LICENSE.
+// Please see the file LICENSE-qspy.txt for the complete license text.
+//
+// Quantum Leaps contact information :
+// <www.state-machine.com/licensing>
+// <info@state-machine.com>
+//============================================================================
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // for fdopen()
+#define _DEFAULT_SOURCE         // for sysconf(_SC_NPROCESSORS_ONLN)
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <math.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+#define Q_SPY   1       // this is QS implementation
+#define QP_IMPL 1       // this is QP implementation
+typedef int      int_t;   // dummy definition for including "qpc_qs.h"
+typedef int      enum_t;  // dummy definition for including "qpc_qs.h"
+typedef uint16_t QSignal; // dummy definition for including "qpc_qs.h"
+typedef uint32_t QSFun;   // dummy definition for including "qpc_qs.h"
+typedef uint32_t QSObj;   // dummy definition for including "qpc_qs.h"
+typedef uint32_t QEvt;    // dummy definition for including "qpc_qs.h"
+typedef uint32_t QActive; // dummy definition for including "qpc_qs.h"
+typedef uint32_t QPSet;   // dummy definition for including "qpc_qs.h"
+#include "qpc_qs.h"       // QS target-resident interface
+
+#include "safe_std.h"   // "safe" <stdio.h> and <string.h> facilities
+#include "qspy.h"       // QSPY data parser
+
+// Queries over the capture container (see qspy_cap.c)
+//
+// The blocks of the container that overlap the time window and contain
+// any of the selected record types are decoded by QSPY_parse(), where the
+// frames of the other record types are skipped without parsing. The
+// records come to the query as the rows of values of the Matlab output
+// (the fields named by QSPY_getRecFields()), which are filtered by the
+// "obj" and "sig" fields and counted in groups labeled by the values of
+// the group-by fields. The optional value field is aggregated per group
+// (min, max, mean and percentiles).
+//
+// The percentiles come from a histogram with HIST_SUB buckets per power
+// of 2, which is exact for the integers below 2*HIST_SUB and within
+// 1/(2*HIST_SUB) relative error above, so the histograms of the parts of the
+// capture can be simply added. The QSPY parser is not reentrant, so the
+// parts of the capture are decoded by worker processes (POSIX), each
+// sending its groups to the main process through a pipe.
+
+enum {
+    QRY_COLS_MAX  = 64,  // max fields of a record row
+    QRY_BY_MAX    = 4,   // max group-by fields
+    QRY_PCT_MAX   = 16,  // max percentiles
+    QRY_LABEL_MAX = 512, // max length of the group label
+    HIST_SUB      = 64,  // histogram buckets per power of 2
+    HIST_HALF     = 65 * HIST_SUB, // buckets of the non-negative values
+    HIST_SIZE     = 2 * HIST_HALF,
+};
+
+enum { // the fields used by the query (indexes into QryRec.idx[])
+    FLD_OBJ,
+    FLD_SIG,
+    FLD_VAL,
+    FLD_BY,  // the first group-by field
+    FLD_NUM = FLD_BY + QRY_BY_MAX
+};
+
+typedef struct {
+    char     *label;
+    uint64_t  count;  // the selected records
+    uint64_t  n;      // the records with the value field
+    double    min;
+    double    max;
+    double    sum;
+    uint64_t *hist;   // histogram of the values (only for percentiles)
+} QryGroup;
+
+typedef struct {
+    bool   known;          // the fields of the record type resolved?
+    int8_t idx[FLD_NUM];   // indexes of the fields in the row (-1: none)
+} QryRec;
+
+static bool      l_active;
+static QSpyVal   l_row[1 + QRY_COLS_MAX]; // the row being composed
+static uint32_t  l_nVals;
+static QryRec    l_rec[256];
+
+// the query...
+static uint8_t     l_recMap[32];
+static uint64_t    l_tFrom;
+static uint64_t    l_tTo = UINT64_MAX;
+static char const *l_objName;
+static char const *l_sigName;
+static bool        l_hasObj;
+static KeyType     l_obj;
+static bool        l_hasSig;
+static SigType     l_sig;
+static char const *l_by[QRY_BY_MAX];
+static uint32_t    l_nBy;
+static char const *l_val;
+static double      l_pct[QRY_PCT_MAX];
+static uint32_t    l_nPct;
+static uint32_t    l_topN;
+
+// the results...
+static QryGroup   *l_groups;
+static uint32_t    l_nGroups;
+static uint32_t    l_capGroups;
+static uint32_t   *l_hash;     // indexes into l_groups[] + 1 (0: empty)
+static uint32_t    l_hashSize; // power of 2
+static uint64_t    l_nRecs;    // the decoded records
+
+//............................................................................
+static uint32_t hashStr(char const *s) {
+    uint32_t h = 2166136261U; // FNV-1a
+    for (; *s != '\0'; ++s) {
+        h = (h ^ (uint8_t)*s) * 16777619U;
+    }
+    return h;
+}
+//............................................................................
+static QryGroup *findGroup(char const *label) {
+    if (2U * (l_nGroups + 1U) > l_hashSize) { // grow the hash table?
+        uint32_t const size = (l_hashSize != 0U) ? 2U * l_hashSize : 1024U;
+        uint32_t *hash = (uint32_t *)calloc(size, sizeof(uint32_t));
+        if (hash == (uint32_t *)0) {
+            return (QryGroup *)0;
+        }
+        for (uint32_t g = 0U; g < l_nGroups; ++g) {
+            uint32_t i = hashStr(l_groups[g].label) & (size - 1U);
+            while (hash[i] != 0U) {
+                i = (i + 1U) & (size - 1U);
+            }
+            hash[i] = g + 1U;
+        }
+        free(l_hash);
+        l_hash = hash;
+        l_hashSize = size;
+    }
+
+    uint32_t i = hashStr(label) & (l_hashSize - 1U);
+    for (; l_hash[i] != 0U; i = (i + 1U) & (l_hashSize - 1U)) {
+        QryGroup * const grp = &l_groups[l_hash[i] - 1U];
+        if (strcmp(grp->label, label) == 0) {
+            return grp;
+        }
+    }
+
+    if (l_nGroups == l_capGroups) {
+        uint32_t const cap = (l_capGroups != 0U) ? 2U * l_capGroups : 256U;
+        QryGroup *groups = (QryGroup *)realloc(l_groups,
+                                               cap * sizeof(QryGroup));
+        if (groups == (QryGroup *)0) {
+            return (QryGroup *)0;
+        }
+        l_groups = groups;
+        l_capGroups = cap;
+    }
+    QryGroup * const grp = &l_groups[l_nGroups];
+    size_t const len = strlen(label) + 1U;
+    memset(grp, 0, sizeof(QryGroup));
+    grp->label = (char *)malloc(len);
+    if (grp->label == (char *)0) {
+        return (QryGroup *)0;
+    }
+    memcpy(grp->label, label, len);
+    grp->min = INFINITY;
+    grp->max = -INFINITY;
+    if (l_nPct > 0U) {
+        grp->hist = (uint64_t *)calloc(HIST_SIZE, sizeof(uint64_t));
+        if (grp->hist == (uint64_t *)0) {
+            free(grp->label);
+            return (QryGroup *)0;
+        }
+    }
+    ++l_nGroups;
+    l_hash[i] = l_nGroups;
+    return grp;
+}
+//............................................................................
+// histogram bucket of the value (the order of the buckets follows values)
+static uint32_t histIdx(double v) {
+    double const a = fabs(v);
+    uint32_t b = 0U; // |v| < 1
+    if (a >= 1.0) {
+        int e;
+        double const m = frexp(a, &e); // a = m * 2^e, m in [0.5, 1)
+        if (e > 64) {
+            e = 64;
+        }
+        b = (uint32_t)e * HIST_SUB + (uint32_t)((m - 0.5) * 2.0 * HIST_SUB);
+    }
+    return (v >= 0.0) ? (HIST_HALF + b) : (HIST_HALF - 1U - b);
+}
+//............................................................................
+// the value of the histogram bucket (the middle of the buckets wider than 1)
+static double histVal(uint32_t idx) {
+    uint32_t const b = (idx >= HIST_HALF) ? (idx - HIST_HALF)
+                                          : (HIST_HALF - 1U - idx);
+    double a = 0.0;
+    if (b >= HIST_SUB) {
+        int const e = (int)(b / HIST_SUB);
+        double const width = ldexp(1.0 / (2.0 * HIST_SUB), e);
+        a = ldexp(0.5 + (double)(b % HIST_SUB) / (2.0 * HIST_SUB), e)
+            + ((width > 1.0) ? (width / 2.0) : 0.0);
+    }
+    return (idx >= HIST_HALF) ? a : -a;
+}
+//............................................................................
+static double percentile(QryGroup const *grp, double pct) {
+    uint64_t rank = (uint64_t)ceil(pct / 100.0 * (double)grp->n);
+    if (rank == 0U) {
+        rank = 1U;
+    }
+    uint64_t sum = 0U;
+    for (uint32_t i = 0U; i < HIST_SIZE; ++i) {
+        sum += grp->hist[i];
+        if (sum >= rank) {
+            double const v = histVal(i);
+            return (v < grp->min) ? grp->min
+                   : ((v > grp->max) ? grp->max : v);
+        }
+    }
+    return grp->max;
+}
+
+//............................................................................
+// index of the named field in the row of the record (-1 when not found)
+static int findField(int recId, char const *name) {
+    if (strcmp(name, "rec") == 0) {
+        return 0;
+    }
+    size_t const nameLen = strlen(name);
+    char const *f = QSPY_getRecFields(recId);
+    for (int i = 1; (f != (char const *)0) && (*f != '\0'); ++i) {
+        size_t const len = strcspn(f, ",");
+        if ((len == nameLen) && (strncmp(f, name, len) == 0)) {
+            return i;
+        }
+        f += len;
+        f += (*f == ',') ? 1 : 0;
+    }
+    if ((name[0] == 'c') && (name[1] >= '0') && (name[1] <= '9')) {
+        int const c = atoi(&name[1]) + 1; // unnamed field "c<n>"
+        return (c < 1 + QRY_COLS_MAX) ? c : -1;
+    }
+    return -1;
+}
+//............................................................................
+static QryRec const *getRec(int recId) {
+    QryRec * const rec = &l_rec[recId];
+    if (!rec->known) {
+        rec->known = true;
+        rec->idx[FLD_OBJ] = (int8_t)findField(recId, "obj");
+        rec->idx[FLD_SIG] = (int8_t)findField(recId, "sig");
+        rec->idx[FLD_VAL] = (l_val != (char const *)0)
+                            ? (int8_t)findField(recId, l_val)
+                            : (int8_t)-1;
+        for (uint32_t i = 0U; i < l_nBy; ++i) {
+            rec->idx[FLD_BY + i] = (int8_t)findField(recId, l_by[i]);
+        }
+    }
+    return rec;
+}
+//............................................................................
+static QSpyVal const *getVal(QryRec const *rec, int fld, uint32_t n) {
+    int const i = rec->idx[fld];
+    return ((i >= 0) && ((uint32_t)i < n)) ? &l_row[i] : (QSpyVal *)0;
+}
+//............................................................................
+static bool isObjField(char const *name) {
+    return (strcmp(name, "obj") == 0) || (strcmp(name, "sender") == 0)
+           || (strcmp(name, "ao") == 0) || (strcmp(name, "queue") == 0);
+}
+//............................................................................
+static bool isFunField(char const *name) {
+    return (strcmp(name, "state") == 0) || (strcmp(name, "source") == 0)
+           || (strcmp(name, "target") == 0);
+}
+//............................................................................
+// append the group-by field as shown in the QSPY text output
+static void putLabel(char *label, size_t *len, QryRec const *rec,
+                     uint32_t by, uint32_t n)
+{
+    char buf[QS_DNAME_LEN_MAX];
+    char const *s = buf;
+    QSpyVal const *val = getVal(rec, FLD_BY + by, n);
+    if (rec->idx[FLD_BY + by] == 0) { // the record type?
+        int const recId = (int)l_row[0].u.i;
+        s = QSPY_getRecName(recId);
+        if (s == (char const *)0) {
+            SNPRINTF_S(buf, sizeof(buf), "USER+%03d", recId - QS_USER);
+            s = buf;
+        }
+    }
+    else if (val == (QSpyVal *)0) {
+        s = "-";
+    }
+    else if (val->type == QSPY_VAL_STR) {
+        s = val->u.s;
+    }
+    else if (val->type == QSPY_VAL_F64) {
+        SNPRINTF_S(buf, sizeof(buf), "%g", val->u.f);
+    }
+    else if (isObjField(l_by[by])) {
+        s = Dictionary_get(&QSPY_objDict, val->u.u, buf);
+    }
+    else if (isFunField(l_by[by])) {
+        s = Dictionary_get(&QSPY_funDict, val->u.u, buf);
+    }
+    else if (strcmp(l_by[by], "sig") == 0) {
+        QSpyVal const *obj = getVal(rec, FLD_OBJ, n);
+        s = SigDictionary_get(&QSPY_sigDict, (SigType)val->u.u,
+                (obj != (QSpyVal *)0) ? (ObjType)obj->u.u : (ObjType)0,
+                buf);
+    }
+    else if ((val->type == QSPY_VAL_I32) || (val->type == QSPY_VAL_I64)) {
+        SNPRINTF_S(buf, sizeof(buf), "%lld", (long long)val->u.i);
+    }
+    else {
+        SNPRINTF_S(buf, sizeof(buf), "%llu", (unsigned long long)val->u.u);
+    }
+    int const k = SNPRINTF_S(&label[*len], QRY_LABEL_MAX - *len, "%s%s",
+                             (by > 0U) ? "\t" : "", s);
+    if ((k > 0) && (*len + (size_t)k < QRY_LABEL_MAX)) {
+        *len += (size_t)k;
+    }
+}
+//............................................................................
+void QQRY_putVal(QSpyVal const *val) {
+    if (l_nVals < sizeof(l_row)/sizeof(l_row[0])) {
+        l_row[l_nVals] = *val;
+        ++l_nVals;
+    }
+}
+//............................................................................
+void QQRY_endRow(void) {
+    uint32_t const n = l_nVals;
+    l_nVals = 0U;
+    if ((n == 0U) || (l_row[0].type != QSPY_VAL_I32)
+        || (l_row[0].u.i < 0) || (l_row[0].u.i > 255))
+    {
+        return; // not a record row
+    }
+    int const recId = (int)l_row[0].u.i;
+    if ((l_recMap[recId >> 3] & (uint8_t)(1U << (recId & 7))) == 0U) {
+        return; // e.g., a dictionary row
+    }
+    QryRec const *rec = getRec(recId);
+    QSpyVal const *val;
+    if (l_hasObj) {
+        val = getVal(rec, FLD_OBJ, n);
+        if ((val == (QSpyVal *)0) || ((KeyType)val->u.u != l_obj)) {
+            return;
+        }
+    }
+    if (l_hasSig) {
+        val = getVal(rec, FLD_SIG, n);
+        if ((val == (QSpyVal *)0) || ((SigType)val->u.u != l_sig)) {
+            return;
+        }
+    }
+
+    char label[QRY_LABEL_MAX];
+    size_t len = 0U;
+    label[0] = '\0';
+    for (uint32_t i = 0U; i < l_nBy; ++i) {
+        putLabel(label, &len, rec, i, n);
+    }
+    QryGroup * const grp = findGroup(label);
+    if (grp == (QryGroup *)0) {
+        return; // out of memory
+    }
+    ++grp->count;
+
+    val = getVal(rec, FLD_VAL, n);
+    if ((val != (QSpyVal *)0) && (val->type != QSPY_VAL_STR)) {
+        double const v = (val->type == QSPY_VAL_F64) ? val->u.f
+            : (((val->type == QSPY_VAL_I32) || (val->type == QSPY_VAL_I64))
+               ? (double)val->u.i
+               : (double)val->u.u);
+        ++grp->n;
+        grp->sum += v;
+        if (v < grp->min) {
+            grp->min = v;
+        }
+        if (v > grp->max) {
+            grp->max = v;
+        }
+        if (grp->hist != (uint64_t *)0) {
+            ++grp->hist[histIdx(v)];
+        }
+    }
+}
+//............................................................................
+bool QQRY_isActive(void) {
+    return l_active;
+}
+
+//............................................................................
+static void decodeBlocks(uint32_t const *blocks, uint32_t nBlocks) {
+    l_active = true;
+    for (uint32_t i = 0U; i < nBlocks; ++i) {
+        l_nRecs += QCAP_decodeBlock(blocks[i], l_tFrom, l_tTo, l_recMap);
+    }
+    l_active = false;
+}
+
+#ifndef _WIN32
+//............................................................................
+static void putGroups(FILE *out) {
+    fwrite(&l_nRecs, sizeof(l_nRecs), 1U, out);
+    fwrite(&l_nGroups, sizeof(l_nGroups), 1U, out);
+    for (uint32_t g = 0U; g < l_nGroups; ++g) {
+        QryGroup const * const grp = &l_groups[g];
+        uint32_t const len = (uint32_t)strlen(grp->label);
+        fwrite(&len, sizeof(len), 1U, out);
+        fwrite(grp->label, 1U, len, out);
+        fwrite(&grp->count, sizeof(grp->count), 1U, out);
+        fwrite(&grp->n,     sizeof(grp->n),     1U, out);
+        fwrite(&grp->min,   sizeof(grp->min),   1U, out);
+        fwrite(&grp->max,   sizeof(grp->max),   1U, out);
+        fwrite(&grp->sum,   sizeof(grp->sum),   1U, out);
+        uint32_t nBins = 0U;
+        for (uint32_t i = 0U; (grp->hist != (uint64_t *)0)
+                              && (i < HIST_SIZE); ++i)
+        {
+            nBins += (grp->hist[i] != 0U) ? 1U : 0U;
+        }
+        fwrite(&nBins, sizeof(nBins), 1U, out);
+        for (uint32_t i = 0U; nBins != 0U; ++i) {
+            if (grp->hist[i] != 0U) {
+                fwrite(&i, sizeof(i), 1U, out);
+                fwrite(&grp->hist[i], sizeof(grp->hist[i]), 1U, out);
+                --nBins;
+            }
+        }
+    }
+}
+//............................................................................
+// merge the groups of a worker into the results
+static bool getGroups(FILE *in) {
+    uint64_t nRecs;
+    uint32_t nGroups;
+    if ((fread(&nRecs, sizeof(nRecs), 1U, in) != 1U)
+        || (fread(&nGroups, sizeof(nGroups), 1U, in) != 1U))
+    {
+        return false;
+    }
+    l_nRecs += nRecs;
+    for (; nGroups != 0U; --nGroups) {
+        char label[QRY_LABEL_MAX];
+        uint32_t len;
+        uint64_t count;
+        uint64_t n;
+        double   min;
+        double   max;
+        double   sum;
+        uint32_t nBins;
+        if ((fread(&len, sizeof(len), 1U, in) != 1U)
+            || (len >= sizeof(label))
+            || (fread(label, 1U, len, in) != len)
+            || (fread(&count, sizeof(count), 1U, in) != 1U)
+            || (fread(&n,     sizeof(n),     1U, in) != 1U)
+            || (fread(&min,   sizeof(min),   1U, in) != 1U)
+            || (fread(&max,   sizeof(max),   1U, in) != 1U)
+            || (fread(&sum,   sizeof(sum),   1U, in) != 1U)
+            || (fread(&nBins, sizeof(nBins), 1U, in) != 1U))
+        {
+            return false;
+        }
+        label[len] = '\0';
+        QryGroup * const grp = findGroup(label);
+        if (grp == (QryGroup *)0) {
+            return false;
+        }
+        grp->count += count;
+        grp->n     += n;
+        grp->sum   += sum;
+        if (min < grp->min) {
+            grp->min = min;
+        }
+        if (max > grp->max) {
+            grp->max = max;
+        }
+        for (; nBins != 0U; --nBins) {
+            uint32_t i;
+            uint64_t c;
+            if ((fread(&i, sizeof(i), 1U, in) != 1U)
+                || (fread(&c, sizeof(c), 1U, in) != 1U)
+                || (i >= HIST_SIZE) || (grp->hist == (uint64_t *)0))
+            {
+                return false;
+            }
+            grp->hist[i] += c;
+        }
+    }
+    return true;
+}
+//............................................................................
+// decode the blocks in the worker processes, each reading the container
+// through its own file and taking a part of the blocks of similar size
+static bool runWorkers(char const *fName, uint32_t const *blocks,
+                       uint32_t nBlocks, unsigned nJobs)
+{
+    FILE  **in   = (FILE **)calloc(nJobs, sizeof(FILE *));
+    pid_t  *pids = (pid_t *)calloc(nJobs, sizeof(pid_t));
+    if ((in == (FILE **)0) || (pids == (pid_t *)0)) {
+        free(in);
+        free(pids);
+        return false;
+    }
+
+    // the parts of similar size (the last block of every worker)
+    uint64_t total = 0U;
+    for (uint32_t i = 0U; i < nBlocks; ++i) {
+        total += QCAP_getBlock(blocks[i])->size;
+    }
+    uint32_t *ends = (uint32_t *)calloc(nJobs, sizeof(uint32_t));
+    if (ends == (uint32_t *)0) {
+        free(in);
+        free(pids);
+        return false;
+    }
+    uint64_t sum = 0U;
+    uint32_t last = 0U;
+    for (unsigned k = 0U; k < nJobs; ++k) {
+        uint64_t const part = total * (k + 1U) / nJobs;
+        while ((last < nBlocks) && ((sum < part) || (k + 1U == nJobs))) {
+            sum += QCAP_getBlock(blocks[last])->size;
+            ++last;
+        }
+        ends[k] = last;
+    }
+    QCAP_open((void *)0); // every worker opens the container again
+    fflush(stdout);
+
+    bool ok = true;
+    uint32_t first = 0U;
+    unsigned k = 0U;
+    for (; ok && (k < nJobs); ++k) {
+        last = ends[k];
+        int fd[2];
+        if (pipe(fd) != 0) {
+            ok = false;
+            break;
+        }
+        pids[k] = fork();
+        if (pids[k] == 0) { // the worker?
+            close(fd[0]);
+            FILE *f;
+            FOPEN_S(f, fName, "rb");
+            FILE *out = fdopen(fd[1], "wb");
+            bool const done = (out != (FILE *)0) && (f != (FILE *)0)
+                              && (QCAP_open(f) >= 0);
+            if (done) {
+                decodeBlocks(&blocks[first], last - first);
+                putGroups(out);
+            }
+            fflush(out);
+            fflush(stdout); // _exit() does not flush the stdio buffers
+            _exit(done ? 0 : 1);
+        }
+        close(fd[1]);
+        if (pids[k] < 0) {
+            close(fd[0]);
+            ok = false;
+            break;
+        }
+        in[k] = fdopen(fd[0], "rb");
+        first = last;
+    }
+
+    // the results of the workers, in order...
+    for (unsigned i = 0U; i < k; ++i) {
+        if (in[i] != (FILE *)0) {
+            ok = getGroups(in[i]) && ok;
+            fclose(in[i]);
+        }
+        else {
+            ok = false;
+        }
+        int status = 0;
+        if ((pids[i] > 0) && ((waitpid(pids[i], &status, 0) != pids[i])
+                              || !WIFEXITED(status)
+                              || (WEXITSTATUS(status) != 0)))
+        {
+            ok = false;
+        }
+    }
+    free(ends);
+    free(in);
+    free(pids);
+    return ok;
+}
+#endif // _WIN32
+
+//............................................................................
+static int groupComp(void const *arg1, void const *arg2) {
+    QryGroup const *g1 = (QryGroup const *)arg1;
+    QryGroup const *g2 = (QryGroup const *)arg2;
+    if (g1->count != g2->count) {
+        return (g1->count < g2->count) ? 1 : -1; // descending counts
+    }
+    return strcmp(g1->label, g2->label);
+}
+//............................................................................
+static void printResults(void) {
+    qsort(l_groups, l_nGroups, sizeof(QryGroup), &groupComp);
+
+    for (uint32_t i = 0U; i < l_nBy; ++i) {
+        PRINTF_S("%s\t", l_by[i]);
+    }
+    PRINTF_S("%s", "count");
+    if (l_val != (char const *)0) {
+        PRINTF_S("\t%s:n\tmin\tmax\tmean", l_val);
+        for (uint32_t p = 0U; p < l_nPct; ++p) {
+            PRINTF_S("\tp%g", l_pct[p]);
+        }
+    }
+    PRINTF_S("%s", "\n");
+
+    uint32_t const nGroups = ((l_topN != 0U) && (l_topN < l_nGroups))
+                             ? l_topN : l_nGroups;
+    for (uint32_t g = 0U; g < nGroups; ++g) {
+        QryGroup const * const grp = &l_groups[g];
+        PRINTF_S("%s%s%llu", grp->label, (l_nBy > 0U) ? "\t" : "",
+                 (unsigned long long)grp->count);
+        if (l_val == (char const *)0) {
+            // no value statistics
+        }
+        else if (grp->n == 0U) {
+            PRINTF_S("%s", "\t0\t-\t-\t-");
+            for (uint32_t p = 0U; p < l_nPct; ++p) {
+                PRINTF_S("%s", "\t-");
+            }
+        }
+        else {
+            PRINTF_S("\t%llu\t%.15g\t%.15g\t%.15g",
+                     (unsigned long long)grp->n, grp->min, grp->max,
+                     grp->sum / (double)grp->n);
+            for (uint32_t p = 0U; p < l_nPct; ++p) {
+                PRINTF_S("\t%.15g", percentile(grp, l_pct[p]));
+            }
+        }
+        PRINTF_S("%s", "\n");
+    }
+    if (nGroups < l_nGroups) {
+        PRINTF_S("... %u more groups\n", (unsigned)(l_nGroups - nGroups));
+    }
+}
+
+//............................................................................
+// split the comma-separated list in place
+static uint32_t splitList(char *list, char const **items, uint32_t max) {
+    uint32_t n = 0U;
+    for (char *s = list; (s != (char *)0) && (n < max); ++n) {
+        items[n] = s;
+        s = strchr(s, ',');
+        if (s != (char *)0) {
+            *s++ = '\0';
+        }
+    }
+    return n;
+}
+//............................................................................
+static int findRec(char const *name) {
+    char *end;
+    if (strncmp(name, "USER+", 5) == 0) {
+        long const n = strtol(&name[5], &end, 10);
+        return ((*end == '\0') && (n >= 0) && (QS_USER + n < 256))
+               ? (int)(QS_USER + n) : -1;
+    }
+    long const n = strtol(name, &end, 0);
+    if ((end != name) && (*end == '\0')) {
+        return ((n >= 0) && (n < 256)) ? (int)n : -1;
+    }
+    for (int r = 0; r < 256; ++r) {
+        char const *s = QSPY_getRecName(r);
+        if ((s != (char const *)0) && (strcmp(s, name) == 0)) {
+            return r;
+        }
+    }
+    return -1;
+}
+//............................................................................
+// resolve the names in the query with the dictionaries of the capture
+static bool resolveQuery(char *recs) {
+    if (recs != (char *)0) {
+        char const *names[256];
+        uint32_t const n = splitList(recs, names, 256U);
+        memset(l_recMap, 0, sizeof(l_recMap));
+        for (uint32_t i = 0U; i < n; ++i) {
+            int const r = findRec(names[i]);
+            if (r < 0) {
+                PRINTF_S("unknown record: %s\n", names[i]);
+                return false;
+            }
+            l_recMap[r >> 3] |= (uint8_t)(1U << (r & 7));
+        }
+    }
+    else { // all records, but not the dictionaries and the Target info
+        memset(l_recMap, 0xFF, sizeof(l_recMap));
+        for (int r = 0; r < QS_USER; ++r) {
+            int const grp = QSPY_getGroup(r);
+            if ((grp == QSPY_GRP_INF) || (grp == QSPY_GRP_DIC)) {
+                l_recMap[r >> 3] &= (uint8_t)~(1U << (r & 7));
+            }
+        }
+    }
+
+    char *end;
+    if (l_objName != (char const *)0) {
+        l_hasObj = true;
+        l_obj = QSPY_findObj(l_objName);
+        if (l_obj == KEY_NOT_FOUND) {
+            l_obj = (KeyType)strtoull(l_objName, &end, 0);
+            if ((end == l_objName) || (*end != '\0')) {
+                PRINTF_S("unknown object: %s\n", l_objName);
+                return false;
+            }
+        }
+    }
+    if (l_sigName != (char const *)0) {
+        l_hasSig = true;
+        l_sig = QSPY_findSig(l_sigName, l_hasObj ? (ObjType)l_obj : 0U);
+        if (l_sig == (SigType)0) { // not in the dictionary?
+            l_sig = (SigType)strtoul(l_sigName, &end, 0);
+            if ((end == l_sigName) || (*end != '\0')) {
+                PRINTF_S("unknown signal: %s\n", l_sigName);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//............................................................................
+static char const l_helpStr[] =
+    "\nUsage: qspy -Q <capture> [options]\n"
+    "\n"
+    "ARGUMENT      DEFAULT   COMMENT\n"
+    "---------------------------------------------------------------\n"
+    "<capture>               capture container (.qsc)\n"
+    "\n"
+    "OPTIONS:\n"
+    "-h                      help (show this message and exit)\n"
+    "-r <recs>     all       record types, e.g., QS_QF_ACTIVE_POST,USER+3\n"
+    "-o <obj>                object (name or address) in the obj field\n"
+    "-s <sig>                signal (name or number) in the sig field\n"
+    "-t <from:to>  all       time window [timestamp ticks from the start]\n"
+    "-g <fields>   rec       group-by fields, e.g., rec,obj,sig\n"
+    "-v <field>              value field for min/max/mean/percentiles\n"
+    "-p <pcts>     50,90,99  percentiles of the value field\n"
+    "-n <N>        all       top-N groups (by count)\n"
+    "-j[jobs]      CPUs      parallel decoding in [jobs] processes\n"
+    "                        (single process when -j absent)\n";
+
+//............................................................................
+int QQRY_main(int argc, char *argv[]) {
+    char const *fName = (char const *)0;
+    char *recs = (char *)0;
+    char *by   = (char *)0;
+    char *pcts = (char *)0;
+    unsigned nJobs = 1U;
+
+    for (int i = 1; i < argc; ++i) {
+        char *arg = argv[i];
+        if (arg[0] != '-') {
+            fName = arg;
+            continue;
+        }
+        char const opt = arg[1];
+        if ((opt == 'h') || (opt == 'j')) { // options without arguments?
+            if (opt == 'h') {
+                PRINTF_S("%s", l_helpStr);
+                return 0;
+            }
+            nJobs = (arg[2] != '\0')
+                    ? (unsigned)strtoul(&arg[2], NULL, 10)
+                    : 0U; // one process per CPU
+            continue;
+        }
+        char *optArg = (arg[2] != '\0') ? &arg[2]
+                       : ((i + 1 < argc) ? argv[++i] : (char *)0);
+        if ((opt == '\0') || (optArg == (char *)0)) {
+            PRINTF_S("missing argument of %s\n%s", arg, l_helpStr);
+            return -1;
+        }
+        switch (opt) {
+            case 'r': recs = optArg;      break;
+            case 'o': l_objName = optArg; break;
+            case 's': l_sigName = optArg; break;
+            case 'g': by = optArg;        break;
+            case 'v': l_val = optArg;     break;
+            case 'p': pcts = optArg;      break;
+            case 'n': {
+                l_topN = (uint32_t)strtoul(optArg, NULL, 10);
+                break;
+            }
+            case 't': {
+                char *end = strchr(optArg, ':');
+                if (end == (char *)0) {
+                    PRINTF_S("time window not from:to: %s\n", optArg);
+                    return -1;
+                }
+                *end++ = '\0';
+                l_tFrom = (*optArg != '\0') ? strtoull(optArg, NULL, 0)
+                                            : 0U;
+                l_tTo = (*end != '\0') ? strtoull(end, NULL, 0)
+                                       : UINT64_MAX;
+                break;
+            }
+            default: {
+                PRINTF_S("unknown option %s\n%s", arg, l_helpStr);
+                return -1;
+            }
+        }
+    }
+    if (fName == (char const *)0) {
+        PRINTF_S("%s", l_helpStr);
+        return -1;
+    }
+
+    if (by != (char *)0) {
+        l_nBy = splitList(by, l_by, QRY_BY_MAX);
+    }
+    else {
+        l_by[0] = "rec";
+        l_nBy = 1U;
+    }
+    if (l_val != (char const *)0) {
+        char const *items[QRY_PCT_MAX];
+        static char defPcts[] = "50,90,99";
+        l_nPct = splitList((pcts != (char *)0) ? pcts : defPcts,
+                           items, QRY_PCT_MAX);
+        for (uint32_t p = 0U; p < l_nPct; ++p) {
+            l_pct[p] = strtod(items[p], NULL);
+        }
+    }
+
+    FILE *f;
+    FOPEN_S(f, fName, "rb");
+    if (f == (FILE *)0) {
+        PRINTF_S("cannot open %s\n", fName);
+        return -1;
+    }
+    int const nBlocks = QCAP_open(f);
+    if ((nBlocks < 0) || !resolveQuery(recs)) {
+        QCAP_open((void *)0);
+        return -1;
+    }
+
+    // the blocks in the time window with any of the selected records
+    uint32_t *blocks = (uint32_t *)malloc(((size_t)nBlocks + 1U)
+                                          * sizeof(uint32_t));
+    uint32_t nSel = 0U;
+    for (uint32_t i = QCAP_findBlock(l_tFrom);
+         (blocks != (uint32_t *)0) && (i < (uint32_t)nBlocks)
+         && (QCAP_getBlock(i)->tFirst <= l_tTo);
+         ++i)
+    {
+        if (QCAP_hasRecs(i, l_recMap)) {
+            blocks[nSel] = i;
+            ++nSel;
+        }
+    }
+
+#ifndef _WIN32
+    if (nJobs == 0U) { // one process per CPU?
+        long const nCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+        nJobs = (nCPUs > 0) ? (unsigned)nCPUs : 1U;
+    }
+#else
+    nJobs = 1U; // the parallel decoding not supported
+#endif
+    if (nJobs > nSel) {
+        nJobs = (nSel > 0U) ? nSel : 1U;
+    }
+    PRINTF_S("# blocks:%u selected:%u jobs:%u\n",
+             (unsigned)nBlocks, (unsigned)nSel, nJobs);
+
+    bool ok = (blocks != (uint32_t *)0);
+    if (ok && (nJobs > 1U)) {
+#ifndef _WIN32
+        ok = runWorkers(fName, blocks, nSel, nJobs);
+#endif
+    }
+    else if (ok) {
+        decodeBlocks(blocks, nSel);
+    }
+    free(blocks);
+    QCAP_open((void *)0);
+    if (!ok) {
+        PRINTF_S("%s\n", "query failed");
+        return -1;
+    }
+
+    PRINTF_S("# records:%llu groups:%u\n",
+             (unsigned long long)l_nRecs, (unsigned)l_nGroups);
+    printResults();
+    return 0;
+}
@@ -0,0 +1,364 @@
+//============================================================================
+// QSPY software tracing host-side utility
+//
+//                   Q u a n t u m  L e a P s
+//                   ------------------------
+//                   Modern Embedded Software
+//
+// Copyright(C) 2005 Quantum Leaps, LLC.All rights reserved.
+//
+// This software is licensed under the terms of the Quantum Leaps
+// QSPY SOFTWARE TRACING HOST UTILITY SOFTWARE END USER LICENSE.
+// Please see the file LICENSE-qspy.txt for the complete license text.
+//
+// Quantum Leaps contact information :
+// <www.state-machine.com/licensing>
+// <info@state-machine.com>
+//============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <inttypes.h>
+
+#define Q_SPY   1       // this is QS implementation
+#define QP_IMPL 1       // this is QP implementation
+typedef int      int_t;   // dummy definition for including "qpc_qs.h"
+typedef int      enum_t;  // dummy definition for including "qpc_qs.h"
+typedef uint16_t QSignal; // dummy definition for including "qpc_qs.h"
+typedef uint32_t QSFun;   // dummy definition for including "qpc_qs.h"
+typedef uint32_t QSObj;   // dummy definition for including "qpc_qs.h"
+typedef uint32_t QEvt;    // dummy definition for including "qpc_qs.h"
+typedef uint32_t QActive; // dummy definition for including "qpc_qs.h"
+typedef uint32_t QPSet;   // dummy definition for including "qpc_qs.h"
+#include "qpc_qs.h"       // QS target-resident interface
+
+#include "safe_std.h"   // "safe" <stdio.h> and <string.h> facilities
+#include "qspy.h"       // QSPY data parser
+
+// Live model of the event queues
+//
+// The model is updated from the values of the Matlab output (see the field
+// names in QSPY_getRecFields()) of the queue records:
+//
+// - QS_QF_ACTIVE_POST/POST_LIFO and QS_QF_EQUEUE_POST/POST_LIFO report
+//   the free entries after the post and the all-time minimum of the
+//   free entries kept in the Target;
+// - QS_QF_ACTIVE_GET and QS_QF_EQUEUE_GET report the free entries after
+//   the get, while the ..._GET_LAST records mean that the queue is empty
+//   (all entries free, as far as seen so far);
+// - the ..._POST_ATTEMPT records are the posts that failed the margin.
+//
+// The time is divided into windows of the length given to QQUE_config()
+// (in the QS timestamp ticks, extended across the wrap-arounds). The
+// windowed low-water mark covers the current and the last complete window,
+// while the post/get counts and the trend (change of the free entries)
+// are from the last complete window. A queue is flagged when at this
+// trend it would run out of the free entries within the next two windows,
+// or when it ran out (or a post failed) in the windowed period.
+
+enum {
+    QUE_VALS_MAX   = 16,  // max values of a row used here
+    QUE_QUEUES_MAX = 256, // max queues in the model (hash table size)
+};
+
+typedef struct {
+    QQueStat stat;      // the statistics reported
+    uint64_t winStart;  // the start of the current window
+    uint32_t curMin;    // low-water mark in the current window
+    uint32_t prevMin;   // low-water mark in the last complete window
+    uint32_t curPosts;  // posts in the current window
+    uint32_t curGets;   // gets in the current window
+    uint32_t winFree;   // free entries at the start of the current window
+    bool     curFail;   // failed post in the current window?
+    bool     prevFail;  // failed post in the last complete window?
+    bool     isNew;     // no free entries known yet?
+    bool     inUse;     // is this hash-table slot used?
+} QueEntry;
+
+//............................................................................
+static uint32_t l_window;  // length of the window (0: inactive)
+static QSpyVal  l_row[1 + QUE_VALS_MAX];
+static uint32_t l_nVals;   // values of the row being composed
+static uint32_t l_nRow;    // values of the row being processed
+
+static QueEntry l_que[QUE_QUEUES_MAX]; // hash table by the object
+static uint16_t l_order[QUE_QUEUES_MAX]; // entries in the order of arrival
+static uint16_t l_nQueues;
+static bool     l_isFull;  // table full reported?
+static uint64_t l_tHigh;   // the high part of the extended timestamp
+static uint32_t l_tLast;   // the last timestamp
+
+//............................................................................
+void QQUE_config(uint32_t window) {
+    l_window  = window;
+    l_nVals   = 0U;
+    l_nRow    = 0U;
+    memset(l_que, 0, sizeof(l_que));
+    l_nQueues = 0U;
+    l_isFull  = false;
+    l_tHigh   = 0U;
+    l_tLast   = 0U;
+}
+//............................................................................
+bool QQUE_isActive(void) {
+    return l_window != 0U;
+}
+//............................................................................
+void QQUE_putVal(QSpyVal const *val) {
+    if (l_nVals < sizeof(l_row)/sizeof(l_row[0])) {
+        l_row[l_nVals] = *val;
+        ++l_nVals;
+    }
+}
+//............................................................................
+static uint64_t val(uint32_t i) {
+    return (i < l_nRow) ? l_row[i].u.u : 0U;
+}
+//............................................................................
+static uint32_t hashIdx(KeyType obj) {
+    return (uint32_t)((obj ^ (obj >> 7) ^ (obj >> 17)) % QUE_QUEUES_MAX);
+}
+//............................................................................
+static QueEntry *getQueue(KeyType obj, bool isAO, uint64_t t) {
+    uint32_t i = hashIdx(obj);
+    for (uint32_t n = 0U; n < QUE_QUEUES_MAX;
+         ++n, i = (i + 1U) % QUE_QUEUES_MAX)
+    {
+        QueEntry * const q = &l_que[i];
+        if (!q->inUse) { // free slot?
+            q->inUse     = true;
+            q->stat.obj  = obj;
+            q->stat.isAO = isAO;
+            q->winStart  = t;
+            q->isNew     = true;
+            l_order[l_nQueues] = (uint16_t)i;
+            ++l_nQueues;
+            return q;
+        }
+        if (q->stat.obj == obj) {
+            return q;
+        }
+    }
+    if (!l_isFull) {
+        l_isFull = true;
+        SNPRINTF_LINE("   <QSPY-> ERROR    %s",
+                      "Too many queues (the new ones not modeled)");
+        QSPY_printError();
+    }
+    return (QueEntry *)0;
+}
+//............................................................................
+// is the queue trending toward an overflow?
+static bool isWarn(QueEntry const * const q) {
+    QQueStat const * const s = &q->stat;
+    return (s->minWin == 0U) || q->curFail || q->prevFail
+        || ((s->trend < 0) && ((int64_t)s->nFree + 2*(int64_t)s->trend <= 0));
+}
+//............................................................................
+// update the warning flag of the queue at the time t, with the note
+// printed when the queue starts trending toward an overflow
+static void setWarn(QueEntry * const q, uint64_t t) {
+    QQueStat * const s = &q->stat;
+    bool const warn = isWarn(q);
+    if (warn && !s->warn) {
+        SNPRINTF_LINE("   <QSPY-> Queue Obj=%s trending to overflow "
+                      "(Free=%u,Trend=%d,Time=%" PRIu64 ")",
+                      Dictionary_get(&QSPY_objDict, s->obj, (char *)0),
+                      (unsigned)s->nFree, (int)s->trend, t);
+        QSPY_printInfo();
+    }
+    s->warn = warn;
+}
+//............................................................................
+// close the window(s) elapsed until the time t
+static void rollWindow(QueEntry * const q, uint64_t t) {
+    if (t - q->winStart < l_window) {
+        return; // still in the current window
+    }
+    QQueStat * const s = &q->stat;
+    if (t - q->winStart < 2U*(uint64_t)l_window) { // the next window?
+        s->posts   = q->curPosts;
+        s->gets    = q->curGets;
+        s->trend   = (int32_t)s->nFree - (int32_t)q->winFree;
+        q->prevMin = q->curMin;
+        q->prevFail = q->curFail;
+    }
+    else { // no records in the last complete window
+        s->posts   = 0U;
+        s->gets    = 0U;
+        s->trend   = 0;
+        q->prevMin = s->nFree;
+        q->prevFail = false;
+    }
+    q->winStart += ((t - q->winStart) / l_window) * l_window;
+    q->curPosts = 0U;
+    q->curGets  = 0U;
+    q->curMin   = s->nFree;
+    q->winFree  = s->nFree;
+    q->curFail  = false;
+    s->minWin   = (q->prevMin < q->curMin) ? q->prevMin : q->curMin;
+    setWarn(q, t);
+}
+//............................................................................
+static void update(QueEntry * const q, uint32_t nFree, uint64_t t) {
+    QQueStat * const s = &q->stat;
+    if (q->isNew) { // the first record of the queue?
+        q->isNew   = false;
+        s->minAll  = nFree;
+        q->curMin  = nFree;
+        q->prevMin = nFree;
+        q->winFree = nFree;
+    }
+    s->nFree = nFree;
+    if (s->maxFree < nFree) {
+        s->maxFree = nFree;
+    }
+    if (s->minAll > nFree) {
+        s->minAll = nFree;
+    }
+    if (q->curMin > nFree) {
+        q->curMin = nFree;
+    }
+    s->minWin = (q->prevMin < q->curMin) ? q->prevMin : q->curMin;
+    setWarn(q, t);
+}
+
+//............................................................................
+void QQUE_endRow(void) {
+    uint32_t const n = l_nVals;
+    l_nVals = 0U;
+    l_nRow  = n;
+    if ((n < 2U) || (l_row[0].type != QSPY_VAL_I32)) {
+        return; // not a record row
+    }
+    int const rec = (int)l_row[0].u.i;
+
+    if (QSPY_hasTstamp(rec)) { // keep track of the time
+        uint32_t const t = (uint32_t)val(1U);
+        if (t < l_tLast) { // wrap-around?
+            l_tHigh += (QSPY_conf.tstampSize >= 4U)
+                       ? 0x100000000U
+                       : ((uint64_t)1U << (8U*QSPY_conf.tstampSize));
+        }
+        l_tLast = t;
+    }
+
+    uint32_t objIdx  = 3U; // index of the "obj" field (after "t,sig")
+    uint32_t freeIdx = 6U; // index of the "free" field
+    bool isAO = true;
+    switch (rec) {
+        case QS_QF_ACTIVE_POST:         // t,sender,sig,obj,pool,ref,free,min
+        case QS_QF_ACTIVE_POST_ATTEMPT: // t,sender,sig,obj,pool,ref,free,...
+            objIdx  = 4U;
+            freeIdx = 7U;
+            break;
+        case QS_QF_ACTIVE_POST_LIFO:    // t,sig,obj,pool,ref,free,min
+        case QS_QF_ACTIVE_GET:          // t,sig,obj,pool,ref,free
+        case QS_QF_ACTIVE_GET_LAST:     // t,sig,obj,pool,ref
+            break;
+        case QS_QF_EQUEUE_POST:         // t,sig,obj,pool,ref,free,min
+        case QS_QF_EQUEUE_POST_ATTEMPT: // t,sig,obj,pool,ref,free,margin
+        case QS_QF_EQUEUE_POST_LIFO:    // t,sig,obj,pool,ref,free,min
+        case QS_QF_EQUEUE_GET:          // t,sig,obj,pool,ref,free
+        case QS_QF_EQUEUE_GET_LAST:     // t,sig,obj,pool,ref
+            isAO = false;
+            break;
+        default:
+            return; // not a queue record
+    }
+    if (n <= objIdx) {
+        return; // row incomplete
+    }
+    uint64_t const t = l_tHigh + l_tLast;
+
+    QueEntry * const q = getQueue((KeyType)val(objIdx), isAO, t);
+    if (q == (QueEntry *)0) {
+        return;
+    }
+    rollWindow(q, t);
+
+    QQueStat * const s = &q->stat;
+    switch (rec) {
+        case QS_QF_ACTIVE_POST:
+        case QS_QF_ACTIVE_POST_LIFO:
+        case QS_QF_EQUEUE_POST:
+        case QS_QF_EQUEUE_POST_LIFO: {
+            ++s->nPost;
+            ++q->curPosts;
+            update(q, (uint32_t)val(freeIdx), t);
+            uint32_t const min = (uint32_t)val(freeIdx + 1U);
+            if (s->minAll > min) { // the Target's all-time minimum
+                s->minAll = min;
+            }
+            break;
+        }
+        case QS_QF_ACTIVE_POST_ATTEMPT:
+        case QS_QF_EQUEUE_POST_ATTEMPT:
+            ++s->nAttempt;
+            q->curFail = true;
+            update(q, (uint32_t)val(freeIdx), t);
+            break;
+        case QS_QF_ACTIVE_GET:
+        case QS_QF_EQUEUE_GET:
+            ++s->nGet;
+            ++q->curGets;
+            update(q, (uint32_t)val(freeIdx), t);
+            break;
+        default: // ..._GET_LAST (the queue is empty now)
+            ++s->nGet;
+            ++q->curGets;
+            update(q, s->maxFree, t);
+            break;
+    }
+}
+
+//............................................................................
+uint32_t QQUE_getCount(void) {
+    return l_nQueues;
+}
+//............................................................................
+QQueStat const *QQUE_getAt(uint32_t idx) {
+    if (idx < l_nQueues) {
+        QueEntry * const q = &l_que[l_order[idx]];
+        rollWindow(q, l_tHigh + l_tLast); // up to the last record
+        return &q->stat;
+    }
+    return (QQueStat const *)0;
+}
+//............................................................................
+QQueStat const *QQUE_find(KeyType obj) {
+    uint32_t i = hashIdx(obj);
+    for (uint32_t n = 0U; n < QUE_QUEUES_MAX;
+         ++n, i = (i + 1U) % QUE_QUEUES_MAX)
+    {
+        if (!l_que[i].inUse) {
+            break;
+        }
+        if (l_que[i].stat.obj == obj) {
+            rollWindow(&l_que[i], l_tHigh + l_tLast); // up to the last record
+            return &l_que[i].stat;
+        }
+    }
+    return (QQueStat const *)0;
+}
+//............................................................................
+void QQUE_report(void) {
+    if (!QQUE_isActive()) {
+        SNPRINTF_LINE("   <QSPY-> ERROR    %s",
+                      "Queue model not active");
+        QSPY_printError();
+        return;
+    }
+    for (uint32_t i = 0U; i < l_nQueues; ++i) {
+        QQueStat const * const s = QQUE_getAt(i);
+        SNPRINTF_LINE("   <QSPY-> Queue%s Obj=%s,Free=%u,Max=%u,Min=%u,"
+            "WinMin=%u,Posts=%u,Gets=%u,Trend=%d,Fail=%" PRIu64 "%s",
+            s->isAO ? "-AO" : "-EQ",
+            Dictionary_get(&QSPY_objDict, s->obj, (char *)0),
+            (unsigned)s->nFree, (unsigned)s->maxFree, (unsigned)s->minAll,
+            (unsigned)s->minWin, (unsigned)s->posts, (unsigned)s->gets,
+            (int)s->trend, s->nAttempt, s->warn ? ",OVERFLOW-TREND" : "");
+        QSPY_printInfo();
+    }
+}
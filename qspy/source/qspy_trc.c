@@ -0,0 +1,467 @@
+//============================================================================
+// QSPY software tracing host-side utility
+//
+//                   Q u a n t u m  L e a P s
+//                   ------------------------
+//                   Modern Embedded Software
+//
+// Copyright(C) 2005 Quantum Leaps, LLC.All rights reserved.
+//
+// This software is licensed under the terms of the Quantum Leaps
+// QSPY SOFTWARE TRACING HOST UTILITY SOFTWARE END USER LICENSE.
+// Please see the file LICENSE-qspy.txt for the complete license text.
+//
+// Quantum Leaps contact information :
+// <www.state-machine.com/licensing>
+// <info@state-machine.com>
+//============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#define Q_SPY   1       // this is QS implementation
+#define QP_IMPL 1       // this is QP implementation
+typedef int      int_t;   // dummy definition for including "qpc_qs.h"
+typedef int      enum_t;  // dummy definition for including "qpc_qs.h"
+typedef uint16_t QSignal; // dummy definition for including "qpc_qs.h"
+typedef uint32_t QSFun;   // dummy definition for including "qpc_qs.h"
+typedef uint32_t QSObj;   // dummy definition for including "qpc_qs.h"
+typedef uint32_t QEvt;    // dummy definition for including "qpc_qs.h"
+typedef uint32_t QActive; // dummy definition for including "qpc_qs.h"
+typedef uint32_t QPSet;   // dummy definition for including "qpc_qs.h"
+#include "qpc_qs.h"       // QS target-resident interface
+
+#include "safe_std.h"   // "safe" <stdio.h> and <string.h> facilities
+#include "qspy.h"       // QSPY data parser
+
+// Trace-event output for the Chrome and Perfetto trace viewers
+//
+// The output is the JSON array of trace events, which is written while the
+// records arrive, so the memory stays constant for captures of any length
+// (and the file opens in the viewers even when the closing ']' is missing).
+// The records are taken from the values of the Matlab output (see the field
+// names in qspy_npy.c) and mapped to the events as follows:
+//
+// - every object (active object, time event, ISR, ...) gets its own track,
+//   named after the object dictionary and sorted by the priority of the AO;
+// - QS_QEP_DISPATCH begins the RTC step slice of the AO (named after the
+//   signal), which ends with the next RTC step at the same or lower
+//   priority, or when the scheduler reports the end of the RTC step
+//   (QS_SCHED_NEXT, QS_SCHED_RESTORE, QS_SCHED_IDLE);
+// - QS_QF_ISR_ENTRY/EXIT are the (nested) slices of the "ISR" track;
+// - QS_QF_ACTIVE_POST/POST_LIFO are marked on the track of the sender and
+//   connected by flow arrows (bind_id) with the RTC step that processes
+//   the event;
+// - the free entries of the event queues and memory pools are counters,
+//   and so is the priority of the running AO.
+//
+// Until the first QS_SCHED_PREEMPT/RESTORE, the scheduler is assumed to be
+// non-preemptive (QV), where every new RTC step ends the previous one.
+// The QS timestamps are extended to 64 bits across the wrap-arounds and
+// scaled to microseconds by the tick duration given to QTRC_configFile().
+
+enum {
+    TRC_VALS_MAX  = 16,  // max values of a row used here
+    TRC_TRACK_MAX = 256, // max tracks (objects), the rest share a track
+    TRC_FLOW_MAX  = 64,  // max events in flight to an AO shown as flows
+    TRC_PID       = 1,   // the "process" of all tracks
+    TRC_TID_ISR   = 1,   // the track of the ISRs
+};
+
+typedef struct {
+    KeyType  obj;      // the object of the track
+    uint16_t tid;      // the track ID
+    bool     used;     // is this hash-table slot used?
+    bool     inStep;   // the RTC step is in progress?
+    uint16_t stepIdx;  // index in l_inStep[] (while in the RTC step)
+    uint8_t  prio;     // priority of the AO (0: not known)
+    uint32_t maxFree;  // max free entries seen (empty queue)
+    uint64_t flow[TRC_FLOW_MAX]; // the flows of the events in the queue
+    uint8_t  flowHead;
+    uint8_t  nFlow;
+    uint64_t recvFlow; // flow of the event retrieved for the next step
+} TrcTrack;
+
+#define TRC_TID_OTHER (TRC_TID_ISR + TRC_TRACK_MAX)
+
+//............................................................................
+static FILE    *l_file;
+static double   l_tickUs;  // duration of the timestamp tick [us]
+static QSpyVal  l_row[1 + TRC_VALS_MAX];
+static uint32_t l_nVals;   // values of the row being composed
+static uint32_t l_nRow;    // values of the row being processed
+
+static TrcTrack l_track[TRC_TRACK_MAX]; // hash table by the object
+static TrcTrack l_other;   // the track shared when the table is full
+static uint16_t l_nTracks;
+static TrcTrack *l_inStep[TRC_TRACK_MAX + 1]; // tracks in the RTC step
+static uint16_t l_nInStep;
+static uint64_t l_tHigh;   // the high part of the extended timestamp
+static uint32_t l_tLast;   // the last timestamp
+static double   l_ts;      // the time of the current record [us]
+static uint8_t  l_prio;    // priority of the running AO (0: idle)
+static bool     l_preemptive;
+static uint32_t l_isrNest; // nesting of the open ISR slices
+static uint64_t l_flowId;
+
+static void QTRC_close(void);
+
+//............................................................................
+void QTRC_configFile(void *traceFile, double tickUs) {
+    if (l_file != (FILE *)0) {
+        QTRC_close();
+    }
+    l_file   = (FILE *)traceFile;
+    l_tickUs = (tickUs > 0.0) ? tickUs : 1.0;
+    l_nVals  = 0U;
+    memset(l_track, 0, sizeof(l_track));
+    memset(&l_other, 0, sizeof(l_other));
+    l_other.tid = TRC_TID_OTHER;
+    l_nTracks = 0U;
+    l_nInStep = 0U;
+    l_tHigh   = 0U;
+    l_tLast   = 0U;
+    l_ts      = 0.0;
+    l_prio    = 0U;
+    l_preemptive = false;
+    l_isrNest = 0U;
+    l_flowId  = 0U;
+    if (l_file != (FILE *)0) {
+        FPRINTF_S(l_file, "[{\"ph\":\"M\",\"pid\":%d,\"name\":"
+                  "\"process_name\",\"args\":{\"name\":\"QSPY %s\"}},\n",
+                  TRC_PID, QSPY_VER);
+        FPRINTF_S(l_file, "{\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"name\":"
+                  "\"thread_name\",\"args\":{\"name\":\"ISR\"}},\n",
+                  TRC_PID, TRC_TID_ISR);
+        FPRINTF_S(l_file, "{\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"name\":"
+                  "\"thread_sort_index\",\"args\":{\"sort_index\":-256}},\n",
+                  TRC_PID, TRC_TID_ISR);
+        FPRINTF_S(l_file, "{\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"name\":"
+                  "\"thread_name\",\"args\":{\"name\":\"(other)\"}},\n",
+                  TRC_PID, TRC_TID_OTHER);
+    }
+}
+//............................................................................
+bool QTRC_isActive(void) {
+    return l_file != (FILE *)0;
+}
+//............................................................................
+void QTRC_putVal(QSpyVal const *val) {
+    if (l_nVals < sizeof(l_row)/sizeof(l_row[0])) {
+        l_row[l_nVals] = *val;
+        ++l_nVals;
+    }
+}
+
+//............................................................................
+// the name from the dictionary, escaped for the JSON string
+static char const *jsonName(char const *name) {
+    static char buf[2*QS_DNAME_LEN_MAX];
+    char *d = buf;
+    for (char const *s = name;
+         (*s != '\0') && (d < &buf[sizeof(buf) - 2]); ++s)
+    {
+        if ((*s == '"') || (*s == '\\')) {
+            *d++ = '\\';
+        }
+        *d++ = ((uint8_t)*s < 0x20U) ? ' ' : *s;
+    }
+    *d = '\0';
+    return buf;
+}
+//............................................................................
+static char const *objName(KeyType obj) {
+    return jsonName(Dictionary_get(&QSPY_objDict, obj, (char *)0));
+}
+//............................................................................
+static char const *sigName(SigType sig, KeyType obj) {
+    return jsonName(SigDictionary_get(&QSPY_sigDict, sig, obj, (char *)0));
+}
+//............................................................................
+// the track of the object (added when not there yet)
+static TrcTrack *getTrack(KeyType obj) {
+    uint32_t i = (uint32_t)((obj ^ (obj >> 7) ^ (obj >> 17))
+                            % TRC_TRACK_MAX);
+    for (uint32_t n = 0U; n < TRC_TRACK_MAX;
+         ++n, i = (i + 1U) % TRC_TRACK_MAX)
+    {
+        TrcTrack * const tr = &l_track[i];
+        if (!tr->used) { // free slot?
+            if (l_nTracks == TRC_TRACK_MAX - 1U) {
+                break; // keep the last slot for the shared track
+            }
+            ++l_nTracks;
+            tr->used = true;
+            tr->obj  = obj;
+            tr->tid = (uint16_t)(TRC_TID_ISR + l_nTracks);
+            FPRINTF_S(l_file, "{\"ph\":\"M\",\"pid\":%d,\"tid\":%u,"
+                      "\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}},\n",
+                      TRC_PID, (unsigned)tr->tid, objName(obj));
+            return tr;
+        }
+        if (tr->obj == obj) {
+            return tr;
+        }
+    }
+    return &l_other; // the table is full
+}
+//............................................................................
+static void beginStep(TrcTrack * const tr) {
+    if (!tr->inStep) {
+        tr->inStep  = true;
+        tr->stepIdx = l_nInStep;
+        l_inStep[l_nInStep] = tr;
+        ++l_nInStep;
+    }
+}
+//............................................................................
+static void endStep(TrcTrack * const tr) {
+    if (tr->inStep) {
+        tr->inStep = false;
+        --l_nInStep; // move the last track in the step to the freed index
+        l_inStep[tr->stepIdx] = l_inStep[l_nInStep];
+        l_inStep[tr->stepIdx]->stepIdx = tr->stepIdx;
+        FPRINTF_S(l_file, "{\"ph\":\"E\",\"pid\":%d,\"tid\":%u,"
+                  "\"ts\":%.3f},\n", TRC_PID, (unsigned)tr->tid, l_ts);
+    }
+}
+//............................................................................
+// end the RTC steps at the priority 'prio' and above (all for prio 0)
+static void endSteps(uint8_t prio) {
+    for (uint32_t i = l_nInStep; i != 0U; --i) { // endStep() removes [i-1]
+        TrcTrack * const tr = l_inStep[i - 1U];
+        if ((!l_preemptive) || (prio == 0U) || (tr->prio >= prio)
+            || (tr == &l_other))
+        {
+            endStep(tr);
+        }
+    }
+}
+//............................................................................
+static void setPrio(uint8_t prio) {
+    l_prio = prio;
+    FPRINTF_S(l_file, "{\"ph\":\"C\",\"pid\":%d,\"ts\":%.3f,"
+              "\"name\":\"prio\",\"args\":{\"prio\":%u}},\n",
+              TRC_PID, l_ts, (unsigned)prio);
+}
+//............................................................................
+static void putFree(KeyType obj, char const *kind, uint32_t nFree) {
+    FPRINTF_S(l_file, "{\"ph\":\"C\",\"pid\":%d,\"ts\":%.3f,"
+              "\"name\":\"%s %s\",\"args\":{\"free\":%u}},\n",
+              TRC_PID, l_ts, objName(obj), kind, (unsigned)nFree);
+}
+//............................................................................
+static void postEvt(KeyType sender, SigType sig, KeyType obj,
+                    uint32_t nFree, bool lifo, bool attempt)
+{
+    TrcTrack * const dst = getTrack(obj);
+    if (dst->maxFree < nFree + 1U) {
+        dst->maxFree = nFree + 1U;
+    }
+    TrcTrack * const src = (sender != 0U) ? getTrack(sender) : (TrcTrack *)0;
+    char const *fmt = attempt ? "PostA %s" : (lifo ? "LIFO %s" : "Post %s");
+    char name[2*QS_DNAME_LEN_MAX + 8];
+    SNPRINTF_S(name, sizeof(name), fmt, sigName(sig, obj));
+    FPRINTF_S(l_file, "{\"ph\":\"X\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,"
+              "\"dur\":0,\"cat\":\"post\",\"name\":\"%s\",",
+              TRC_PID, (src != (TrcTrack *)0)
+                  ? (unsigned)src->tid : (unsigned)TRC_TID_ISR,
+              l_ts, name);
+    if (!attempt && (dst->nFlow < TRC_FLOW_MAX)) {
+        // the flow to the RTC step that will process the event
+        ++l_flowId;
+        if (lifo) { // at the front of the queue
+            dst->flowHead = (uint8_t)((dst->flowHead + TRC_FLOW_MAX - 1U)
+                                      % TRC_FLOW_MAX);
+            dst->flow[dst->flowHead] = l_flowId;
+        }
+        else {
+            dst->flow[(dst->flowHead + dst->nFlow) % TRC_FLOW_MAX]
+                = l_flowId;
+        }
+        ++dst->nFlow;
+        FPRINTF_S(l_file, "\"bind_id\":\"0x%llx\",\"flow_out\":true,",
+                  (unsigned long long)l_flowId);
+    }
+    FPRINTF_S(l_file, "\"args\":{\"to\":\"%s\"}},\n", objName(obj));
+}
+//............................................................................
+// the event retrieved from the queue of the AO is processed in the next
+// RTC step of the AO
+static void getEvt(TrcTrack * const tr) {
+    if (tr->nFlow != 0U) {
+        tr->recvFlow = tr->flow[tr->flowHead];
+        tr->flowHead = (uint8_t)((tr->flowHead + 1U) % TRC_FLOW_MAX);
+        --tr->nFlow;
+    }
+    else {
+        tr->recvFlow = 0U;
+    }
+}
+//............................................................................
+static uint64_t val(uint32_t i) {
+    return (i < l_nRow) ? l_row[i].u.u : 0U;
+}
+//............................................................................
+void QTRC_endRow(void) {
+    uint32_t const n = l_nVals;
+    l_nVals = 0U;
+    l_nRow  = n;
+    if ((n == 0U) || (l_row[0].type != QSPY_VAL_I32)) {
+        return; // not a record row
+    }
+    int const rec = (int)l_row[0].u.i;
+
+    if (QSPY_hasTstamp(rec) && (n > 1U)) {
+        uint32_t const t = (uint32_t)val(1U);
+        if (t < l_tLast) { // wrap-around?
+            l_tHigh += (QSPY_conf.tstampSize >= 4U)
+                       ? 0x100000000U
+                       : ((uint64_t)1U << (8U * QSPY_conf.tstampSize));
+        }
+        l_tLast = t;
+        l_ts = (double)(l_tHigh + t) * l_tickUs;
+    }
+
+    switch (rec) {
+        case QS_QEP_DISPATCH: { // t, sig, obj, state
+            KeyType const obj = val(3U);
+            TrcTrack * const tr = getTrack(obj);
+            endStep(tr);
+            endSteps(l_prio); // steps at the same or lower priority
+            if ((l_prio != 0U) && (tr->prio != l_prio)) {
+                tr->prio = l_prio;
+                FPRINTF_S(l_file, "{\"ph\":\"M\",\"pid\":%d,\"tid\":%u,"
+                          "\"name\":\"thread_sort_index\","
+                          "\"args\":{\"sort_index\":%d}},\n",
+                          TRC_PID, (unsigned)tr->tid, -(int)l_prio);
+            }
+            beginStep(tr);
+            FPRINTF_S(l_file, "{\"ph\":\"B\",\"pid\":%d,\"tid\":%u,"
+                      "\"ts\":%.3f,\"cat\":\"rtc\",\"name\":\"%s\",",
+                      TRC_PID, (unsigned)tr->tid, l_ts,
+                      sigName((SigType)val(2U), obj));
+            if (tr->recvFlow != 0U) {
+                FPRINTF_S(l_file, "\"bind_id\":\"0x%llx\",\"flow_in\":true,",
+                          (unsigned long long)tr->recvFlow);
+                tr->recvFlow = 0U;
+            }
+            FPRINTF_S(l_file, "\"args\":{\"state\":\"%s\"}},\n",
+                jsonName(Dictionary_get(&QSPY_funDict, val(4U), (char *)0)));
+            break;
+        }
+        case QS_QF_ACTIVE_POST: // t, sender, sig, obj, pool, ref, free, min
+        case QS_QF_ACTIVE_POST_ATTEMPT:
+            postEvt(val(2U), (SigType)val(3U), val(4U), (uint32_t)val(7U),
+                    false, (rec == QS_QF_ACTIVE_POST_ATTEMPT));
+            putFree(val(4U), "queue", (uint32_t)val(7U));
+            break;
+        case QS_QF_ACTIVE_POST_LIFO: // t, sig, obj, pool, ref, free, min
+            // self-posting (e.g., recalling), so the sender is the AO
+            postEvt(val(3U), (SigType)val(2U), val(3U), (uint32_t)val(6U),
+                    true, false);
+            putFree(val(3U), "queue", (uint32_t)val(6U));
+            break;
+        case QS_QF_ACTIVE_GET:  // t, sig, obj, pool, ref, free
+        case QS_QF_EQUEUE_GET: {
+            TrcTrack * const tr = getTrack(val(3U));
+            if (tr->maxFree < (uint32_t)val(6U)) {
+                tr->maxFree = (uint32_t)val(6U);
+            }
+            if (rec == QS_QF_ACTIVE_GET) {
+                getEvt(tr);
+            }
+            putFree(val(3U), "queue", (uint32_t)val(6U));
+            break;
+        }
+        case QS_QF_ACTIVE_GET_LAST: // t, sig, obj, pool, ref
+        case QS_QF_EQUEUE_GET_LAST: {
+            TrcTrack * const tr = getTrack(val(3U));
+            if (rec == QS_QF_ACTIVE_GET_LAST) {
+                getEvt(tr);
+            }
+            putFree(val(3U), "queue", tr->maxFree); // the queue is empty
+            break;
+        }
+        case QS_QF_EQUEUE_POST: // t, sig, obj, pool, ref, free, min
+        case QS_QF_EQUEUE_POST_LIFO: {
+            TrcTrack * const tr = getTrack(val(3U));
+            if (tr->maxFree < (uint32_t)val(6U) + 1U) {
+                tr->maxFree = (uint32_t)val(6U) + 1U; // +1 for the posted
+            }
+            putFree(val(3U), "queue", (uint32_t)val(6U));
+            break;
+        }
+        case QS_QF_MPOOL_GET: // t, obj, free, min
+        case QS_QF_MPOOL_PUT: // t, obj, free
+            putFree(val(2U), "pool", (uint32_t)val(3U));
+            break;
+        case QS_QF_PUBLISH: { // t, sender, sig, pool
+            TrcTrack * const tr = (val(2U) != 0U) ? getTrack(val(2U))
+                                                  : (TrcTrack *)0;
+            FPRINTF_S(l_file, "{\"ph\":\"i\",\"s\":\"t\",\"pid\":%d,"
+                      "\"tid\":%u,\"ts\":%.3f,\"cat\":\"post\","
+                      "\"name\":\"Publish %s\"},\n",
+                      TRC_PID, (tr != (TrcTrack *)0)
+                          ? (unsigned)tr->tid : (unsigned)TRC_TID_ISR,
+                      l_ts, sigName((SigType)val(3U), 0U));
+            break;
+        }
+        case QS_QF_ISR_ENTRY: // t, nest, prio
+            ++l_isrNest;
+            FPRINTF_S(l_file, "{\"ph\":\"B\",\"pid\":%d,\"tid\":%d,"
+                      "\"ts\":%.3f,\"cat\":\"isr\",\"name\":\"ISR\","
+                      "\"args\":{\"nest\":%u,\"prio\":%u}},\n",
+                      TRC_PID, TRC_TID_ISR, l_ts,
+                      (unsigned)val(2U), (unsigned)val(3U));
+            break;
+        case QS_QF_ISR_EXIT:
+            if (l_isrNest != 0U) {
+                --l_isrNest;
+                FPRINTF_S(l_file, "{\"ph\":\"E\",\"pid\":%d,\"tid\":%d,"
+                          "\"ts\":%.3f},\n", TRC_PID, TRC_TID_ISR, l_ts);
+            }
+            break;
+        case QS_SCHED_NEXT: // t, prio, prev
+            endSteps((uint8_t)val(2U));
+            setPrio((uint8_t)val(2U));
+            break;
+        case QS_SCHED_IDLE: // t, prev
+            endSteps(0U);
+            setPrio(0U);
+            break;
+        case QS_SCHED_PREEMPT: // t, prev, prio
+            if (QSPY_conf.qpVersion >= 710U) {
+                l_preemptive = true;
+                setPrio((uint8_t)val(3U));
+            }
+            break;
+        case QS_SCHED_RESTORE: // t, prev, prio
+            if (QSPY_conf.qpVersion >= 710U) {
+                l_preemptive = true;
+                endSteps((uint8_t)(val(3U) + 1U)); // above the restored
+                setPrio((uint8_t)val(3U));
+            }
+            break;
+        default:
+            break;
+    }
+}
+//............................................................................
+static void QTRC_close(void) {
+    QTRC_endRow(); // finish the row possibly in progress
+
+    while (l_nInStep != 0U) {
+        endStep(l_inStep[l_nInStep - 1U]);
+    }
+    for (; l_isrNest != 0U; --l_isrNest) {
+        FPRINTF_S(l_file, "{\"ph\":\"E\",\"pid\":%d,\"tid\":%d,"
+                  "\"ts\":%.3f},\n", TRC_PID, TRC_TID_ISR, l_ts);
+    }
+    // the last event without the trailing comma
+    FPRINTF_S(l_file, "{\"ph\":\"C\",\"pid\":%d,\"ts\":%.3f,"
+              "\"name\":\"prio\",\"args\":{\"prio\":%u}}]\n",
+              TRC_PID, l_ts, (unsigned)l_prio);
+    fclose(l_file);
+    l_file = (FILE *)0;
+}
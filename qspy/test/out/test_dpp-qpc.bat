@@ -0,0 +1,3 @@
+@cls
+@echo round-trip test of the binary QSPY outputs...
+test_out ../seq/dpp-qpc.bin
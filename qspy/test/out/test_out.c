@@ -0,0 +1,328 @@
+//============================================================================
+// QSPY software tracing host-side utility
+//
+//                   Q u a n t u m  L e a P s
+//                   ------------------------
+//                   Modern Embedded Software
+//
+// Copyright(C) 2005 Quantum Leaps, LLC.All rights reserved.
+//
+// This software is licensed under the terms of the Quantum Leaps
+// QSPY SOFTWARE TRACING HOST UTILITY SOFTWARE END USER LICENSE.
+// Please see the file LICENSE-qspy.txt for the complete license text.
+//
+// Quantum Leaps contact information :
+// <www.state-machine.com/licensing>
+// <info@state-machine.com>
+//============================================================================
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "safe_std.h"   // "safe" <stdio.h> and <string.h> facilities
+#include "qspy.h"       // QSPY data parser
+#include "pal.h"        // Platform Abstraction Layer
+
+// Round-trip test of the binary QSPY outputs
+//
+// The QS records of the given capture (e.g., ../seq/dpp-qpc.bin) are parsed
+// with the binary MAT-file output (QMAT), the NumPy output (QNPY) and the
+// capture container (QCAP) active. The written files are then read back
+// and their headers checked: the MAT-file header and the tags of all its
+// variables, the ZIP headers and the .npy headers of all members of the
+// .npz archive, and the index of the capture container. Please see the
+// README.txt file in this directory.
+
+static int l_nFail;
+
+#define CHECK(cond_, what_) do { \
+    if (!(cond_)) { \
+        PRINTF_S("FAILED: %s\n", (what_)); \
+        ++l_nFail; \
+    } \
+} while (0)
+
+// the parts of the QSPY application not needed by the test ..................
+void QSPY_onPrintLn(void) { // only the errors (e.g., from the writers)
+    if (strstr(QSPY_line, "<QSPY-> ERROR") != (char *)0) {
+        PRINTF_S("%s\n", QSPY_line);
+        ++l_nFail;
+    }
+}
+char const *QSPY_getMatDict(char const *s) {
+    static char buf[QS_DNAME_LEN_MAX];
+    size_t n = 0U;
+    for (; (*s != '\0') && (n < sizeof(buf) - 1U); ++s, ++n) {
+        buf[n] = (((*s >= 'a') && (*s <= 'z')) || ((*s >= 'A') && (*s <= 'Z'))
+                  || ((*s >= '0') && (*s <= '9'))) ? *s : '_';
+    }
+    buf[n] = '\0';
+    return buf;
+}
+PAL_VtblType PAL_vtbl; // no Target connection
+uint32_t QSPY_encode(uint8_t *dstBuf, uint32_t dstSize,
+                     uint8_t const *srcBuf, uint32_t srcBytes)
+{
+    (void)dstBuf; (void)dstSize; (void)srcBuf; (void)srcBytes;
+    return 0U; // nothing is sent to the Target
+}
+bool QDIC_isActive(void) { return false; }
+QSpyStatus QSPY_writeDict(void) { return QSPY_SUCCESS; }
+QSpyStatus QSPY_readDict(void) { return QSPY_SUCCESS; }
+void QSPY_configChanged(void) {}
+bool QSEQ_isActive(void) { return false; }
+void QSEQ_updateDictionary(char const *n, KeyType k) { (void)n; (void)k; }
+void QSEQ_genPost(uint32_t t, int s, int d, char const *sig, bool a) {
+    (void)t; (void)s; (void)d; (void)sig; (void)a;
+}
+void QSEQ_genPostLIFO(uint32_t t, int s, char const *sig) {
+    (void)t; (void)s; (void)sig;
+}
+void QSEQ_genTran(uint32_t t, int o, char const *s) {
+    (void)t; (void)o; (void)s;
+}
+void QSEQ_genPublish(uint32_t t, int o, char const *s) {
+    (void)t; (void)o; (void)s;
+}
+void QSEQ_genAnnotation(uint32_t t, int o, char const *s) {
+    (void)t; (void)o; (void)s;
+}
+void QSEQ_genTick(uint32_t r, uint32_t n) { (void)r; (void)n; }
+void QSEQ_dictionaryReset(void) {}
+int  QSEQ_find(KeyType key) { (void)key; return -1; }
+void Q_onError(char const * const module, int const id) {
+    PRINTF_S("ERROR in %s:%d\n", module, id);
+    exit(-1);
+}
+
+// helpers ...................................................................
+static uint8_t *readFile(char const *name, size_t *size) {
+    FILE *f;
+    FOPEN_S(f, name, "rb");
+    if (f == (FILE *)0) {
+        return (uint8_t *)0;
+    }
+    fseek(f, 0L, SEEK_END);
+    long const len = ftell(f);
+    fseek(f, 0L, SEEK_SET);
+    uint8_t *buf = (uint8_t *)malloc((len > 0) ? (size_t)len : 1U);
+    if ((buf != (uint8_t *)0)
+        && (fread(buf, 1U, (size_t)len, f) != (size_t)len))
+    {
+        free(buf);
+        buf = (uint8_t *)0;
+    }
+    fclose(f);
+    *size = (size_t)len;
+    return buf;
+}
+//............................................................................
+static uint32_t get16(uint8_t const *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+//............................................................................
+static uint32_t get32(uint8_t const *p) {
+    return get16(p) | (get16(&p[2]) << 16);
+}
+
+// MAT-file (Level 5) ........................................................
+static void checkMat(char const *name) {
+    size_t size;
+    uint8_t *buf = readFile(name, &size);
+    CHECK(buf != (uint8_t *)0, "MAT-file written");
+    if (buf == (uint8_t *)0) {
+        return;
+    }
+    CHECK((size >= 128U)
+          && (memcmp(buf, "MATLAB 5.0 MAT-file", 19U) == 0),
+          "MAT-file header text");
+    CHECK((size >= 128U) && (get16(&buf[124]) == 0x0100U)
+          && (buf[126] == 'I') && (buf[127] == 'M'),
+          "MAT-file version and endian indicator");
+
+    // walk the variables: miMATRIX tag, array flags, dims, name, data
+    size_t pos = 128U;
+    int nVars = 0;
+    bool haveTot = false;
+    while (pos + 8U <= size) {
+        uint8_t const *p = &buf[pos];
+        uint32_t const len = get32(&p[4]);
+        if ((get32(p) != 14U) || (pos + 8U + len > size) || (len < 40U)) {
+            CHECK(false, "MAT-file miMATRIX element");
+            break;
+        }
+        uint32_t const rows = get32(&p[32]);
+        uint32_t const cols = get32(&p[36]);
+        uint32_t const nameLen = get32(&p[44]);
+        uint32_t const namePad = (nameLen + 7U) & ~7U;
+        uint8_t const *data = &p[48U + namePad];
+        CHECK((get32(&p[8]) == 6U) && (get32(&p[24]) == 5U)
+              && (get32(&p[40]) == 1U), "MAT-file matrix subelements");
+        CHECK((48U + namePad + 8U <= 8U + len) && (get32(data) == 9U)
+              && ((uint64_t)get32(&data[4]) == 8U*(uint64_t)rows*cols)
+              && (56U + namePad + 8U*(uint64_t)rows*cols == 8U + len),
+              "MAT-file matrix size");
+        if ((nameLen == 5U) && (memcmp(&p[48], "Q_TOT", 5U) == 0)) {
+            haveTot = true;
+        }
+        ++nVars;
+        pos += 8U + len;
+    }
+    CHECK(pos == size, "MAT-file ends after the last variable");
+    CHECK(haveTot && (nVars > 1), "MAT-file variables");
+    PRINTF_S("%s: %d variables\n", name, nVars);
+    free(buf);
+}
+
+// NumPy .npz archive ........................................................
+static void checkNpz(char const *name) {
+    size_t size;
+    uint8_t *buf = readFile(name, &size);
+    CHECK(buf != (uint8_t *)0, "NumPy output written");
+    if (buf == (uint8_t *)0) {
+        return;
+    }
+    size_t pos = 0U;
+    uint32_t nMembers = 0U;
+    while ((pos + 30U <= size) && (get32(&buf[pos]) == 0x04034B50U)) {
+        uint8_t const *p = &buf[pos];
+        uint32_t const dataSize = get32(&p[18]);
+        uint32_t const nameLen  = get16(&p[26]);
+        uint8_t const *npy = &p[30U + nameLen + get16(&p[28])];
+        if ((size_t)(npy - buf) + dataSize > size) {
+            CHECK(false, "NumPy member within the archive");
+            break;
+        }
+        CHECK((get16(&p[8]) == 0U) && (get32(&p[22]) == dataSize),
+              "NumPy member stored uncompressed");
+        CHECK((nameLen > 4U)
+              && (memcmp(&p[30U + nameLen - 4U], ".npy", 4U) == 0),
+              "NumPy member name");
+
+        // the .npy header: magic, version, header length, header dict
+        uint32_t const hdrLen = get16(&npy[8]);
+        CHECK((dataSize >= 10U + hdrLen)
+              && (memcmp(npy, "\x93NUMPY\x01\x00", 8U) == 0)
+              && (((10U + hdrLen) % 64U) == 0U)
+              && (npy[10U + hdrLen - 1U] == '\n'),
+              "NumPy array header");
+        char hdr[256];
+        size_t const n = (hdrLen < sizeof(hdr)) ? hdrLen : sizeof(hdr) - 1U;
+        memcpy(hdr, &npy[10], n);
+        hdr[n] = '\0';
+        char const *descr = strstr(hdr, "'descr': '");
+        char const *shape = strstr(hdr, "'shape': (");
+        CHECK((descr != (char const *)0) && (shape != (char const *)0),
+              "NumPy array header dict");
+        if ((descr != (char const *)0) && (shape != (char const *)0)) {
+            unsigned long long const items = strtoull(&shape[10], NULL, 10);
+            // descr: byte order, kind and item size, e.g., '<u4' or '|S8'
+            unsigned long const itemSize = strtoul(&descr[12], NULL, 10);
+            CHECK((uint64_t)dataSize
+                  == 10U + hdrLen + items * (uint64_t)itemSize,
+                  "NumPy array data size");
+        }
+        ++nMembers;
+        pos = (size_t)(npy - buf) + dataSize;
+    }
+
+    // the central directory and its end record
+    uint32_t nDir = 0U;
+    size_t const dirPos = pos;
+    while ((pos + 46U <= size) && (get32(&buf[pos]) == 0x02014B50U)) {
+        pos += 46U + get16(&buf[pos + 28U]) + get16(&buf[pos + 30U])
+               + get16(&buf[pos + 32U]);
+        ++nDir;
+    }
+    CHECK((pos + 22U == size) && (get32(&buf[pos]) == 0x06054B50U)
+          && (get16(&buf[pos + 10U]) == nMembers)
+          && (get32(&buf[pos + 16U]) == (uint32_t)dirPos),
+          "ZIP end of central directory");
+    CHECK((nDir == nMembers) && (nMembers > 0U), "ZIP central directory");
+    PRINTF_S("%s: %u arrays\n", name, (unsigned)nMembers);
+    free(buf);
+}
+
+// capture container .........................................................
+static void checkCap(char const *name) {
+    FILE *f;
+    FOPEN_S(f, name, "rb");
+    CHECK(f != (FILE *)0, "capture container written");
+    if (f == (FILE *)0) {
+        return;
+    }
+    int const nBlocks = QCAP_open(f); // takes over the file
+    CHECK(nBlocks > 0, "capture container index");
+    uint32_t n = 0U;
+    uint64_t end = 0U;
+    for (int i = 0; i < nBlocks; ++i) {
+        QCapBlock const * const blk = QCAP_getBlock((uint32_t)i);
+        CHECK((blk->offset >= end) && (blk->size != 0U)
+              && (blk->seqFirst <= blk->seqLast)
+              && (blk->tFirst <= blk->tLast),
+              "capture container block");
+        end = blk->offset + blk->size;
+        n += blk->nRecs;
+    }
+    CHECK((n != 0U)
+          && (QCAP_decode(0U, UINT64_MAX, (uint8_t const *)0) == n),
+          "capture container records");
+    PRINTF_S("%s: %d blocks, %u records\n", name, nBlocks, (unsigned)n);
+    QCAP_open((void *)0);
+}
+
+//............................................................................
+int main(int argc, char *argv[]) {
+    static uint8_t buf[64*1024];
+
+    if (argc < 2) {
+        PRINTF_S("%s\n", "usage: test_out <capture.bin>");
+        return -1;
+    }
+    FILE *in;
+    FOPEN_S(in, argv[1], "rb");
+    if (in == (FILE *)0) {
+        PRINTF_S("File %s could not be opened.\n", argv[1]);
+        return -1;
+    }
+
+    QSpyConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.qpVersion    = 732U;
+    cfg.objPtrSize   = 4U;
+    cfg.funPtrSize   = 4U;
+    cfg.tstampSize   = 4U;
+    cfg.sigSize      = 2U;
+    cfg.evtSize      = 2U;
+    cfg.queueCtrSize = 1U;
+    cfg.poolCtrSize  = 2U;
+    cfg.poolBlkSize  = 2U;
+    cfg.tevtCtrSize  = 2U;
+    QSPY_config(&cfg, (QSPY_CustParseFun)0);
+    QSPY_resetAllDictionaries();
+
+    FILE *f;
+    FOPEN_S(f, "test_out.mat", "wb");
+    QMAT_configFile(f);
+    FOPEN_S(f, "test_out.npz", "wb");
+    QNPY_configFile(f);
+    FOPEN_S(f, "test_out.qsc", "wb");
+    QCAP_configFile(f);
+
+    size_t n;
+    while ((n = fread(buf, 1U, sizeof(buf), in)) > 0U) {
+        QSPY_parse(buf, (uint32_t)n);
+    }
+    fclose(in);
+
+    QMAT_configFile((void *)0);
+    QNPY_configFile((void *)0);
+    QCAP_configFile((void *)0);
+
+    checkMat("test_out.mat");
+    checkNpz("test_out.npz");
+    checkCap("test_out.qsc");
+
+    PRINTF_S("%s\n", (l_nFail == 0) ? "PASSED" : "FAILED");
+    return (l_nFail == 0) ? 0 : 1;
+}
@@ -41,8 +41,10 @@ from tkinter import *
 from tkinter.ttk import * # override the basic Tk widgets with Ttk widgets
 from tkinter.simpledialog import *
 from struct import pack
+from collections import deque
 
 import socket
+import threading
 import time
 import sys
 import struct
@@ -77,6 +79,9 @@ class QView:
     _err  = 0
     _glb_filter = 0x00000000000000000000000000000000
     _loc_filter = 0xFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF
+    _render_pending = False
+    _render_period  = 1.0/25 # see QView.render_rate()
+    _render_time    = 0.0
 
     _dtypes = ("8-bit", "16-bit", "32-bit")
     _dsizes = (1, 2, 4)
@@ -185,6 +190,10 @@ class QView:
     def on_run(self):
         pass
 
+    # on_render() callback, see QView.request_render()
+    def on_render(self):
+        pass
+
     ## @brief Send the RESET packet to the Target
     @staticmethod
     def reset_target():
@@ -230,14 +239,49 @@ class QView:
     # @sa qutest_dsl.glb_filter()
     @staticmethod
     def glb_filter(*args):
-        # internal helper function
-        def _apply(mask, is_neg):
-            if is_neg:
-                QView._glb_filter &= ~mask
-            else:
-                QView._glb_filter |= mask
+        QView._glb_filter = QView._recMask(args, "glb_filter")
+        QSpy._sendTo(pack("<BBQQ", QSpy._TRGT_GLB_FILTER, 16,
+                          QView._glb_filter & 0xFFFFFFFFFFFFFFFF,
+                          QView._glb_filter >> 64))
+        QView._updateMenus()
 
-        QView._glb_filter = 0
+    ## @brief Set the host-side filter in QSPY.
+    # The records filtered out in QSPY are not decoded nor output,
+    # but the Target still produces them (see glb_filter()).
+    # The record arguments are as in glb_filter() (no arguments
+    # means all records), and the optional obj/sig arguments (names or
+    # numbers) filter the records by the "obj" field ("sender" for
+    # QS_QF_PUBLISH) and by the "sig" field. The records without
+    # such fields pass the obj/sig filters (exclude them by the records).
+    @staticmethod
+    def host_filter(*args, obj=None, sig=None):
+        if args:
+            mask = QView._recMask(args, "host_filter")
+        else:
+            mask = QSpy._GLB_FLT_MASK_ALL
+        flags = 0
+        names = b""
+        if obj is not None:
+            flags |= 1
+            names += bytes(str(obj), "utf-8") + b"\0"
+        if sig is not None:
+            flags |= 2
+            names += bytes(str(sig), "utf-8") + b"\0"
+        QSpy._sendTo(pack("<BQQB", QSpy._QSPY_HOST_FILTER,
+                          mask & 0xFFFFFFFFFFFFFFFF, mask >> 64,
+                          flags) + names)
+
+    ## @brief Query the model of the event queues in QSPY.
+    # QSPY prints one line of text per queue in its output (free entries,
+    # low-water marks, post/get counts, trend and the overflow warning).
+    @staticmethod
+    def query_queues():
+        QSpy._sendTo(pack("<B", QSpy._QSPY_QUERY_QUEUES))
+
+    # internal helper function for glb_filter() and host_filter()
+    @staticmethod
+    def _recMask(args, fun_name):
+        mask = 0
         for arg in args:
             # NOTE: positive filter argument means 'add' (allow),
             # negative filter argument meand 'remove' (disallow)
@@ -249,7 +293,7 @@ class QView:
                 try:
                     arg = QSpy._QS.index(arg)
                 except Exception:
-                    QView._MessageDialog("Error in glb_filter()",
+                    QView._MessageDialog(f"Error in {fun_name}()",
                                          f'arg="{arg}"\n' +
                                          traceback.format_exc(3))
                     sys.exit(-5) # return: event-loop might not be running yet
@@ -259,46 +303,47 @@ class QView:
                     arg = -arg
 
             if arg < 0x7F:
-                _apply(1 << arg, is_neg)
+                bits = 1 << arg
             elif arg == QView.GRP_ON:
-                _apply(QSpy._GLB_FLT_MASK_ALL, is_neg)
+                bits = QSpy._GLB_FLT_MASK_ALL
             elif arg == QView.GRP_SM:
-                _apply(QSpy._GLB_FLT_MASK_SM, is_neg)
+                bits = QSpy._GLB_FLT_MASK_SM
             elif arg == QView.GRP_AO:
-                _apply(QSpy._GLB_FLT_MASK_AO, is_neg)
+                bits = QSpy._GLB_FLT_MASK_AO
             elif arg == QView.GRP_MP:
-                _apply(QSpy._GLB_FLT_MASK_MP, is_neg)
+                bits = QSpy._GLB_FLT_MASK_MP
             elif arg == QView.GRP_EQ:
-                _apply(QSpy._GLB_FLT_MASK_EQ, is_neg)
+                bits = QSpy._GLB_FLT_MASK_EQ
             elif arg == QView.GRP_TE:
-                _apply(QSpy._GLB_FLT_MASK_TE, is_neg)
+                bits = QSpy._GLB_FLT_MASK_TE
             elif arg == QView.GRP_QF:
-                _apply(QSpy._GLB_FLT_MASK_QF, is_neg)
+                bits = QSpy._GLB_FLT_MASK_QF
             elif arg == QView.GRP_SC:
-                _apply(QSpy._GLB_FLT_MASK_SC, is_neg)
+                bits = QSpy._GLB_FLT_MASK_SC
             elif arg == QView.GRP_SEM:
-                _apply(QSpy._GLB_FLT_MASK_SEM, is_neg)
+                bits = QSpy._GLB_FLT_MASK_SEM
             elif arg == QView.GRP_MTX:
-                _apply(QSpy._GLB_FLT_MASK_MTX, is_neg)
+                bits = QSpy._GLB_FLT_MASK_MTX
             elif arg == QView.GRP_U0:
-                _apply(QSpy._GLB_FLT_MASK_U0, is_neg)
+                bits = QSpy._GLB_FLT_MASK_U0
             elif arg == QView.GRP_U1:
-                _apply(QSpy._GLB_FLT_MASK_U1, is_neg)
+                bits = QSpy._GLB_FLT_MASK_U1
             elif arg == QView.GRP_U2:
-                _apply(QSpy._GLB_FLT_MASK_U2, is_neg)
+                bits = QSpy._GLB_FLT_MASK_U2
             elif arg == QView.GRP_U3:
-                _apply(QSpy._GLB_FLT_MASK_U3, is_neg)
+                bits = QSpy._GLB_FLT_MASK_U3
             elif arg == QView.GRP_U4:
-                _apply(QSpy._GLB_FLT_MASK_U4, is_neg)
+                bits = QSpy._GLB_FLT_MASK_U4
             elif arg == QView.GRP_UA:
-                _apply(QSpy._GLB_FLT_MASK_UA, is_neg)
+                bits = QSpy._GLB_FLT_MASK_UA
             else:
-                assert 0, f"invalid global filter arg=0x{arg:02x}"
+                assert 0, f"invalid {fun_name} arg=0x{arg:02x}"
 
-        QSpy._sendTo(pack("<BBQQ", QSpy._TRGT_GLB_FILTER, 16,
-                          QView._glb_filter & 0xFFFFFFFFFFFFFFFF,
-                          QView._glb_filter >> 64))
-        QView._updateMenus()
+            if is_neg:
+                mask &= ~bits
+            else:
+                mask |= bits
+        return mask
 
     ## @brief Set/clear the Local-Filter in the Target.
     # @sa qutest_dsl.loc_filter()
@@ -493,6 +538,95 @@ class QView:
             n += 1
         return tuple(data)
 
+    ## @brief Min/max decimation of a high-rate data series
+    #
+    # @description
+    # Splits the @p data series into @p num bins of (almost) equal length
+    # and returns the list of (min, max) tuples, one for each bin. Plotting
+    # the min/max envelope preserves the spikes in the data, which simple
+    # sub-sampling would miss. If the data has fewer samples than @p num,
+    # each sample becomes its own bin.
+    #
+    # @param[in] data sequence of numbers (e.g., QView.RingBuf.data())
+    # @param[in] num  number of bins (typically the plot width in pixels)
+    #
+    @staticmethod
+    def decimate(data, num):
+        n = len(data)
+        if n <= num:
+            return [(d, d) for d in data]
+        result = []
+        start = 0
+        for i in range(1, num + 1):
+            end = (i * n) // num
+            chunk = data[start:end]
+            result.append((min(chunk), max(chunk)))
+            start = end
+        return result
+
+    ## @brief Canvas coordinates of the decimated data series
+    #
+    # @description
+    # Applies QView.decimate() to the @p data with one bin per pixel of
+    # the @p width and scales the result to the rectangle (x0, y0, width,
+    # height) for the values between @p ymin (bottom) and @p ymax (top).
+    # The returned flat list of coordinates can be passed directly to
+    # Canvas.create_line() or Canvas.coords() and never contains more
+    # than 4*width numbers, regardless of the length of the data.
+    #
+    @staticmethod
+    def decimate_coords(data, x0, y0, width, height, ymin, ymax):
+        bins = QView.decimate(data, width)
+        if not bins:
+            return []
+        scale = height / (ymax - ymin) if ymax != ymin else 0.0
+        ybase = y0 + height
+        coords = []
+        for x, (lo, hi) in enumerate(bins, x0):
+            coords.extend((x, ybase - (hi - ymin)*scale,
+                           x, ybase - (lo - ymin)*scale))
+        if len(coords) == 4: # single point? (Tk needs at least 2 points)
+            coords.extend(coords)
+        return coords
+
+    ## @brief Fixed-size ring buffer for high-rate data series
+    #
+    # @description
+    # The QS-record callbacks should only append to ring buffers (and call
+    # QView.request_render()), while the canvas is redrawn from the
+    # buffered data in the on_render() callback.
+    #
+    class RingBuf:
+        def __init__(self, size, fill=0):
+            if size < 1:
+                raise ValueError(f"RingBuf: size must be positive, got {size}")
+            self._buf  = [fill] * size
+            self._head = 0 # index of the next sample to be overwritten
+            self._len  = 0 # number of valid samples
+
+        def __len__(self):
+            return self._len
+
+        def append(self, value):
+            buf = self._buf
+            buf[self._head] = value
+            self._head += 1
+            if self._head == len(buf):
+                self._head = 0
+            if self._len < len(buf):
+                self._len += 1
+
+        def clear(self):
+            self._head = 0
+            self._len  = 0
+
+        ## returns the list of valid samples from the oldest to the newest
+        def data(self):
+            buf = self._buf
+            if self._len < len(buf):
+                return buf[:self._len]
+            return buf[self._head:] + buf[:self._head]
+
 
     @staticmethod
     def _init_gui(root):
@@ -748,6 +882,27 @@ class QView:
     def show_frame(view=1):
         QView._view_frame.set(view)
 
+    ## @brief Request redrawing of the customized canvas and/or frame
+    #
+    # @description
+    # At high rates of QS records (e.g., QS_USER+n records at kHz rates),
+    # redrawing the canvas in every record callback overwhelms Tk. Instead,
+    # the record callbacks should only update the in-memory state (e.g.,
+    # QView.RingBuf) and call request_render(). QView then calls the
+    # on_render() callback at most once per frame, and no more often than
+    # the rate set by QView.render_rate().
+    @staticmethod
+    def request_render():
+        QView._render_pending = True
+
+    ## Set the maximum rate [frames per second] of on_render() callbacks
+    # (the effective rate is further limited by the QView GUI frame rate)
+    @staticmethod
+    def render_rate(fps):
+        if not fps > 0:
+            raise ValueError(f"render_rate: fps must be positive, got {fps}")
+        QView._render_period = 1.0/fps
+
     # private static functions...
     @staticmethod
     def _quit(err=0):
@@ -758,6 +913,23 @@ class QView:
     def _onExit():
         QView._quit()
 
+    # called once per GUI frame, see QView.request_render()
+    @staticmethod
+    def _render():
+        if not QView._render_pending:
+            return
+        now = time.perf_counter()
+        if now - QView._render_time < QView._render_period:
+            return # keep the request pending until the next frame
+        QView._render_pending = False
+        QView._render_time = now
+        try:
+            QView._inst.on_render()
+        except Exception:
+            QView._showerror("Runtime Error",
+                             traceback.format_exc(3))
+            QView._quit(-3)
+
     @staticmethod
     def _onReset():
         QView._glb_filter = 0
@@ -1556,7 +1728,8 @@ class QView:
 
 #=============================================================================
 ## Helper class for UDP-communication with the QSpy front-end
-# (non-blocking UDP-socket version for QView)
+# (UDP-socket serviced by a dedicated receiver thread, which hands
+# the received packets to the GUI in batches once per GUI frame)
 #
 class QSpy:
     # private class variables...
@@ -1567,6 +1740,9 @@ class QSpy:
     _host_addr = ["localhost", 7701] # list, to be converted to a tuple
     _local_port = 0 # let the OS decide the best local port
     _after_id = None
+    _rx_thread = None
+    _rx_dropped = 0 # packets dropped because the receive queue was full
+    _rx_dropped_shown = 0
 
     # formats of various packet elements from the Target
     _fmt_target    = "UNKNOWN"
@@ -1583,10 +1759,27 @@ class QSpy:
     _size_tevtCtr  = 2
     _fmt = "xBHxLxxxQ"
 
-    # QSPY UDP socket poll interval [ms]
-    # NOTE: the chosen value actually sleeps for one system clock tick,
-    # which is typically 10ms
-    _POLLI = 10
+    # GUI frame interval [ms] for handing the received packets to the GUI
+    _FRAMEI = 20
+
+    # max time [s] the GUI spends handling packets in one frame
+    # NOTE: packets not handled within the budget are handled in the
+    # next frame, so the GUI stays responsive even under heavy traffic
+    _FRAME_BUDGET = 0.015
+
+    # receive timeout [s] of the receiver thread
+    # NOTE: the timeout allows the receiver thread to notice
+    # that the socket has been closed in QSpy._detach()
+    _RX_TIMEOUT = 0.1
+
+    # requested size [bytes] of the socket receive buffer
+    # (absorbs bursts of packets while the receiver thread is not running)
+    _RX_BUFSIZE = 1024*1024
+
+    # max number of packets waiting in the receive queue for the GUI
+    # (the oldest packets are dropped when the GUI can't keep up)
+    _RX_QUEUE_MAX = 100000
+    _rx_queue = deque(maxlen=_RX_QUEUE_MAX) # from receiver thread to GUI
 
     # tuple of QS records from the Target.
     # !!! NOTE: Must match qpc/include/qs.h !!!
@@ -1761,6 +1954,8 @@ class QSpy:
     _QSPY_SEQUENCE_OUT    = 134
     _QSPY_CLEAR_SCREEN    = 140
     _QSPY_SHOW_NOTE       = 141
+    _QSPY_HOST_FILTER     = 142
+    _QSPY_QUERY_QUEUES    = 143
 
     # packets to QSpy to be "massaged" and forwarded to the Target...
     _QSPY_SEND_EVENT      = 135
@@ -1779,7 +1974,12 @@ class QSpy:
     def _init():
         # Create socket
         QSpy._sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
-        QSpy._sock.setblocking(0) # NON-BLOCKING socket
+        QSpy._sock.settimeout(QSpy._RX_TIMEOUT) # see QSpy._receive()
+        try:
+            QSpy._sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF,
+                                  QSpy._RX_BUFSIZE)
+        except OSError:
+            pass # keep the default size of the receive buffer
         try:
             QSpy._sock.bind(("0.0.0.0", QSpy._local_port))
             #print("bind: ", ("0.0.0.0", QSpy._local_port))
@@ -1797,12 +1997,16 @@ class QSpy:
     def _attach():
         QSpy._is_attached = False
         QView._have_info  = False
+        if QSpy._rx_thread is None:
+            QSpy._rx_thread = threading.Thread(target=QSpy._receive,
+                                               name="qspy-rx", daemon=True)
+            QSpy._rx_thread.start()
         if QView._echo_text.get():
             channels = 0x3
         else:
             channels = 0x1
         QSpy._sendTo(pack("<BB", QSpy._QSPY_ATTACH, channels))
-        QSpy._attach_ctr = 50
+        QSpy._attach_ctr = 25 # 25 * QSpy._FRAMEI = 0.5s attach timeout
         QSpy._after_id = QView._gui.after(1, QSpy._poll0) # start poll0
 
     @staticmethod
@@ -1814,6 +2018,9 @@ class QSpy:
         #QSpy._sock.shutdown(socket.SHUT_RDWR)
         QSpy._sock.close()
         QSpy._sock = None
+        if QSpy._rx_thread is not None:
+            QSpy._rx_thread.join(2*QSpy._RX_TIMEOUT)
+            QSpy._rx_thread = None
 
     @staticmethod
     def _reattach():
@@ -1824,7 +2031,31 @@ class QSpy:
             channels = 0x1
         QSpy._sendTo(pack("<BB", QSpy._QSPY_ATTACH, channels))
 
-    # poll the UDP socket until the QSpy confirms ATTACH
+    # receiver thread: blocks on the UDP socket and queues the packets
+    # NOTE: the receiver thread must NOT call any Tk functions. All
+    # packets (and errors) are handled in the GUI thread in QSpy._poll()
+    @staticmethod
+    def _receive():
+        sock = QSpy._sock
+        rx_queue = QSpy._rx_queue
+        while QSpy._sock is sock:
+            try:
+                packet = sock.recv(4096)
+            except socket.timeout:
+                continue # check if the socket is still open
+            except OSError:
+                if sock.fileno() >= 0: # socket still open?
+                    # transient error, e.g., ConnectionResetError caused
+                    # by ICMP port-unreachable when QSpy is not running
+                    continue
+                if QSpy._sock is sock: # socket still supposed to be open?
+                    rx_queue.append(None) # report the error to the GUI
+                return
+            if len(rx_queue) == rx_queue.maxlen:
+                QSpy._rx_dropped += 1 # the oldest packet is dropped
+            rx_queue.append(packet)
+
+    # poll the receive queue until the QSpy confirms ATTACH
     @staticmethod
     def _poll0():
         #print("poll0 ", QSpy._attach_ctr)
@@ -1834,72 +2065,65 @@ class QSpy:
                 QView._AttachDialog() # launch the AttachDialog
             return
 
-        try:
-            packet = QSpy._sock.recv(4096)
+        rx_queue = QSpy._rx_queue
+        while rx_queue:
+            packet = rx_queue.popleft()
             if not packet:
                 QView._showerror("UDP Socket Error",
                    "Connection closed by QSpy")
                 QView._quit(-1)
                 return
-        except OSError: # non-blocking socket...
-            QSpy._after_id = QView._gui.after(QSpy._POLLI, QSpy._poll0)
-            return # <======== most frequent return (no packet)
-        except Exception:
-            QView._showerror("UDP Socket Error",
-               "Uknown UDP socket error")
-            QView._quit(-1)
-            return
 
-        # parse the packet...
-        dlen = len(packet)
-        if dlen < 2:
-            QView._showerror("Communication Error",
-               "UDP packet from QSpy too short")
-            QView._quit(-2)
-            return
-
-        recID = packet[1]
-        if recID == QSpy._PKT_ATTACH_CONF:
-            QSpy._is_attached = True
-            if QView._attach_dialog is not None:
-                QView._attach_dialog.close()
-
-            # send either reset or target-info request
-            # (keep the poll0 loop running)
-            if QView._reset_request:
-                QView._reset_request = False
-                QSpy._sendTo(pack("<B", QSpy._TRGT_RESET))
-            else:
-                QSpy._sendTo(pack("<B", QSpy._TRGT_INFO))
-
-            # switch to the regular polling...
-            QSpy._after_id = QView._gui.after(QSpy._POLLI, QSpy._poll)
+            # parse the packet...
+            dlen = len(packet)
+            if dlen < 2:
+                QView._showerror("Communication Error",
+                   "UDP packet from QSpy too short")
+                QView._quit(-2)
+                return
 
-            # only show the canvas, if visible
-            QView._onCanvasView()
+            recID = packet[1]
+            if recID == QSpy._PKT_ATTACH_CONF:
+                QSpy._is_attached = True
+                if QView._attach_dialog is not None:
+                    QView._attach_dialog.close()
+
+                # send either reset or target-info request
+                # (keep the poll0 loop running)
+                if QView._reset_request:
+                    QView._reset_request = False
+                    QSpy._sendTo(pack("<B", QSpy._TRGT_RESET))
+                else:
+                    QSpy._sendTo(pack("<B", QSpy._TRGT_INFO))
+
+                # switch to the regular polling...
+                QSpy._after_id = QView._gui.after(QSpy._FRAMEI, QSpy._poll)
+
+                # only show the canvas, if visible
+                QView._onCanvasView()
+
+                # only show the frame, if visible
+                QView._onFrameView()
+                return
+            if recID == QSpy._PKT_DETACH:
+                QView._quit()
+                return
 
-            # only show the frame, if visible
-            QView._onFrameView()
-        elif recID == QSpy._PKT_DETACH:
-            QView._quit()
+        QSpy._after_id = QView._gui.after(QSpy._FRAMEI, QSpy._poll0)
 
-    # regullar poll of the UDP socket after it has attached.
+    # regular poll of the receive queue after QSpy has attached,
+    # which handles the batch of packets received since the last frame
     @staticmethod
     def _poll():
-        while True:
-            try:
-                packet = QSpy._sock.recv(4096)
-                if not packet:
-                    QView._showerror("UDP Socket Error",
-                                     "Connection closed by QSpy")
-                    QView._quit(-1)
-                    return
-            except OSError: # non-blocking socket...
-                QSpy._after_id = QView._gui.after(QSpy._POLLI, QSpy._poll)
-                return # <============= no packet at this time
-            except Exception:
+        rx_queue = QSpy._rx_queue
+        deadline = time.perf_counter() + QSpy._FRAME_BUDGET
+        while rx_queue:
+            if time.perf_counter() > deadline:
+                break # out of budget, yield to Tk for this frame
+            packet = rx_queue.popleft()
+            if not packet:
                 QView._showerror("UDP Socket Error",
-                                 "Uknown UDP socket error")
+                                 "Connection closed by QSpy")
                 QView._quit(-1)
                 return
 
@@ -1989,7 +2213,16 @@ class QSpy:
                         QView._quit(-3)
                         return
             QSpy._rx_seq += 1
-            QView._rx.configure(text=f"{QSpy._rx_seq}")
+
+        # update the Rx counter only once per frame
+        QView._rx.configure(text=f"{QSpy._rx_seq}")
+        dropped = QSpy._rx_dropped
+        if dropped != QSpy._rx_dropped_shown:
+            QSpy._rx_dropped_shown = dropped
+            QView.print_text(f"QView: {dropped} packets dropped so far "
+                             "(the GUI can't keep up with the Target)")
+        QSpy._after_id = QView._gui.after(QSpy._FRAMEI, QSpy._poll)
+        QView._render()
 
 
     @staticmethod
@@ -0,0 +1,617 @@
+/*****************************************************************************
+* Product: BSP for QWIN GUI demo (POSIX)
+* Last updated for version: 6.9.3
+* Date of the Last Update:  2021-03-03
+*
+*                    Q u a n t u m  L e a P s
+*                    ------------------------
+*                    Modern Embedded Software
+*
+* Copyright (C) 2005-2021 Quantum Leaps, LLC. All rights reserved.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the following MIT License (MIT).
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*
+* Contact information:
+* <www.state-machine.com/licensing>
+* <info@state-machine.com>
+*****************************************************************************/
+#define _POSIX_C_SOURCE 200809L /* for nanosleep() */
+
+#include <stdint.h>
+#include <string.h>  /* for memcpy() */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bsp.h"  /* BSP interface */
+
+#include "qwin_gui.h"  /* QWIN GUI */
+#include "resource.h"  /* GUI resource IDs generated by resource editior */
+
+/* NOTE: on POSIX the application runs in the main thread and the GUI input
+* is dispatched in BSP_sleep(), so a headless run is fully deterministic.
+* The command-line options control the simulation:
+*
+* -w         show the front panel in a window (needs the QWIN_X11 build),
+*            otherwise the simulation runs headless at full speed
+* -x <speed> run the virtual clock at the given multiple of the real time,
+*            or as fast as possible for 0 (default: 1 with -w, otherwise 0)
+* -f <n>     present only every n-th tick (default 1)
+* -n <ticks> terminate after the given number of clock ticks
+* -d <n>     save every n-th frame to <prefix><tick>.ppm
+* -o <prefix> the file-name prefix of the saved frames (default "frame")
+* -k <tick>  press the SPACE key at the given tick (can be repeated)
+*/
+#undef main /* the real main() is defined in this BSP */
+
+#define RES_DIR  "Res/"  /* directory of the bitmaps (see Resource.rc) */
+#define MAX_KEYS 16U
+
+/* the dialog layout from Resource.rc (dialog units converted to pixels) */
+#define DLG_ITEM(id_, kind_, x_, y_, w_, h_, bmp_, txt_) \
+    { (id_), (kind_), DLG_X(x_), DLG_Y(y_), DLG_X(w_), DLG_Y(h_), \
+      (bmp_), (txt_) }
+
+static QWinItemTemplate const l_dlgItems[] = {
+    DLG_ITEM(IDB_BACKGROUND, QWIN_STATIC, 7, 7, 533, 181,
+             RES_DIR "EK-LM3S811.bmp", NULL),
+    DLG_ITEM(IDC_USER, QWIN_OWNERDRAW, 374, 132, 28, 27, NULL, NULL),
+    DLG_ITEM(IDC_LCD, QWIN_STATIC, 287, 85, 128, 20, RES_DIR "LCD.bmp", NULL),
+    DLG_ITEM(IDC_STATIC, QWIN_STATIC, 7, 169, 97, 54, RES_DIR "seg.bmp", NULL),
+    DLG_ITEM(IDC_SEG3, QWIN_STATIC, 16, 177, 19, 36, RES_DIR "seg8.bmp", NULL),
+    DLG_ITEM(IDC_SEG2, QWIN_STATIC, 36, 177, 19, 36, RES_DIR "seg8.bmp", NULL),
+    DLG_ITEM(IDC_SEG1, QWIN_STATIC, 56, 177, 19, 36, RES_DIR "seg8.bmp", NULL),
+    DLG_ITEM(IDC_SEG0, QWIN_STATIC, 76, 177, 19, 36, RES_DIR "seg8.bmp", NULL),
+    DLG_ITEM(IDC_LED, QWIN_STATIC, 417, 36, 19, 18,
+             RES_DIR "led_off.bmp", NULL),
+    DLG_ITEM(IDC_PAUSED, QWIN_TEXT, 254, 193, 65, 8, NULL, "RUNNING"),
+    DLG_ITEM(IDC_STATIC, QWIN_TEXT, 153, 214, 232, 10,
+             NULL, "https://www.state-machine.com")
+};
+static QWinDlgTemplate const l_dlgTemplate = {
+    "Fly 'n' Shoot game",
+    DLG_X(571), DLG_Y(230),
+    { 240U, 240U, 240U },
+    l_dlgItems,
+    (UINT)(sizeof(l_dlgItems) / sizeof(l_dlgItems[0]))
+};
+
+/* local variables ---------------------------------------------------------*/
+static HWND      l_hWnd;    /* main window handle */
+
+static GraphicDisplay   l_oled; /* the OLED display of the EK-LM3S811 board */
+static SegmentDisplay   l_userLED;    /* USER LED of the EK-LM3S811 board */
+static SegmentDisplay   l_scoreBoard; /* segment display for the score */
+static OwnerDrawnButton l_userBtn;   /* USER button of the EK-LM3S811 board */
+
+/* (R,G,B) colors for the OLED display */
+static BYTE const c_onColor [3] = { 255U, 255U,   0U }; /* yellow */
+static BYTE const c_offColor[3] = {  15U,  15U,  15U }; /* very dark gray */
+
+static int l_paused;
+
+/* the bitmap currently shown on the OLED display, to redraw only changes */
+static uint8_t l_oledShown[BSP_SCREEN_WIDTH * BSP_SCREEN_HEIGHT/8U];
+static int     l_oledShownValid; /* the OLED was not drawn otherwise */
+
+/* virtual clock: the ticks advance as fast as the application runs,
+* optionally paced to the speed factor times the real time
+*/
+static uint32_t l_tick;         /* the virtual time in clock ticks */
+static uint32_t l_speed = 1U;   /* speed factor (0 as fast as possible) */
+static uint32_t l_presentEvery = 1U; /* present every n-th tick */
+
+/* the drawing deferred until the next presentation */
+static uint8_t  l_pendingBitmap[BSP_SCREEN_WIDTH * BSP_SCREEN_HEIGHT/8U];
+static int      l_bitmapPending;
+static uint32_t l_pendingCount;
+static int      l_countPending;
+
+/* simulation control (see the command-line options above) */
+static int         l_showWnd;
+static int         l_speedSet;  /* speed factor given on the command line */
+static struct timespec l_startTime; /* the real time of the tick 0 */
+static uint32_t    l_tickLimit;
+static uint32_t    l_dumpEvery;
+static char const *l_dumpPrefix = "frame";
+static uint32_t    l_keyTick[MAX_KEYS];
+static UINT        l_nKeys;
+
+/* Local functions ---------------------------------------------------------*/
+static LRESULT CALLBACK WndProc(HWND hWnd, UINT iMsg,
+                                WPARAM wParam, LPARAM lParam);
+static void presentPending(void);
+static void drawOled(uint8_t const *bitmap);
+static void drawCount(uint32_t n);
+
+/*..........................................................................*/
+static int usage(char const *prog) {
+    fprintf(stderr, "usage: %s [-w] [-x speed] [-f n] [-n ticks] [-d n]"
+                    " [-o prefix] [-k tick]...\n", prog);
+    return -1;
+}
+/*..........................................................................*/
+int main(int argc, char *argv[]) {
+    HWND hWnd;
+    int i;
+
+    for (i = 1; i < argc; ++i) {
+        char const *opt = argv[i];
+        if ((opt[0] != '-') || (opt[1] == '\0') || (opt[2] != '\0')) {
+            return usage(argv[0]);
+        }
+        if (opt[1] == 'w') {
+            l_showWnd = 1;
+        }
+        else if (i + 1 == argc) { /* the other options take a value */
+            return usage(argv[0]);
+        }
+        else if (opt[1] == 'x') {
+            l_speed = (uint32_t)strtoul(argv[++i], NULL, 10);
+            l_speedSet = 1;
+        }
+        else if (opt[1] == 'f') {
+            l_presentEvery = (uint32_t)strtoul(argv[++i], NULL, 10);
+            if (l_presentEvery == 0U) {
+                l_presentEvery = 1U;
+            }
+        }
+        else if (opt[1] == 'n') {
+            l_tickLimit = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (opt[1] == 'd') {
+            l_dumpEvery = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (opt[1] == 'o') {
+            l_dumpPrefix = argv[++i];
+        }
+        else if ((opt[1] == 'k') && (l_nKeys < MAX_KEYS)) {
+            l_keyTick[l_nKeys++] = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else {
+            return usage(argv[0]);
+        }
+    }
+
+    /* create the main custom dialog window */
+    hWnd = CreateCustDialog(&l_dlgTemplate, IDD_APPLICATION, NULL,
+                            &WndProc, "MY_CLASS");
+    if ((hWnd == NULL) || (l_oled.bits == (BYTE *)0)) {
+        fprintf(stderr, "%s: cannot create the dialog\n", argv[0]);
+        return -1;
+    }
+    if (l_showWnd && !ShowWindow(hWnd, SW_SHOW)) { /* show the window */
+        fprintf(stderr, "%s: no display, running headless\n", argv[0]);
+        l_showWnd = 0;
+    }
+    if (!l_speedSet) { /* real time in the window, otherwise full speed */
+        l_speed = l_showWnd ? 1U : 0U;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &l_startTime);
+    return main_gui(); /* run the application */
+}
+/*..........................................................................*/
+static LRESULT CALLBACK WndProc(HWND hWnd, UINT iMsg,
+                                WPARAM wParam, LPARAM lParam)
+{
+    switch (iMsg) {
+
+        /* Perform initialization upon cration of the main dialog window */
+        case WM_CREATE: {
+            l_hWnd = hWnd; /* save the window handle */
+
+            /* initialize the owner-drawn buttons...
+            * NOTE: must be done *before* the first drawing of the buttons,
+            * so WM_INITDIALOG is too late.
+            */
+            OwnerDrawnButton_init(&l_userBtn, IDC_USER,
+                       LoadBitmapFile(RES_DIR "BTN_UP.bmp"),
+                       LoadBitmapFile(RES_DIR "BTN_DWN.bmp"),
+                       NULL);
+            return 0;
+        }
+
+        /* Perform initialization after all child windows have been created */
+        case WM_INITDIALOG: {
+            static char const * const segFile[10] = {
+                RES_DIR "seg0.bmp", RES_DIR "seg1.bmp", RES_DIR "seg2.bmp",
+                RES_DIR "seg3.bmp", RES_DIR "seg4.bmp", RES_DIR "seg5.bmp",
+                RES_DIR "seg6.bmp", RES_DIR "seg7.bmp", RES_DIR "seg8.bmp",
+                RES_DIR "seg9.bmp"
+            };
+            UINT n;
+
+            if (!GraphicDisplay_init(&l_oled,
+                       BSP_SCREEN_WIDTH,  BSP_SCREEN_HEIGHT,
+                       IDC_LCD, c_offColor))
+            {
+                return 0; /* no display memory (checked in main()) */
+            }
+
+            SegmentDisplay_init(&l_userLED,
+                                1U,   /* 1 "segment" (the LED itself) */
+                                2U);  /* 2 bitmaps (for LED OFF/ON states) */
+            SegmentDisplay_initSegment(&l_userLED, 0U, IDC_LED);
+            SegmentDisplay_initBitmap(&l_userLED,
+                0U, LoadBitmapFile(RES_DIR "led_off.bmp"));
+            SegmentDisplay_initBitmap(&l_userLED,
+                1U, LoadBitmapFile(RES_DIR "led_on.bmp"));
+
+            SegmentDisplay_init(&l_scoreBoard,
+                                4U,   /* 4 "segments" (digits 0-3) */
+                                10U); /* 10 bitmaps (for 0-9 states) */
+            SegmentDisplay_initSegment(&l_scoreBoard, 0U, IDC_SEG0);
+            SegmentDisplay_initSegment(&l_scoreBoard, 1U, IDC_SEG1);
+            SegmentDisplay_initSegment(&l_scoreBoard, 2U, IDC_SEG2);
+            SegmentDisplay_initSegment(&l_scoreBoard, 3U, IDC_SEG3);
+            for (n = 0U; n < 10U; ++n) {
+                SegmentDisplay_initBitmap(&l_scoreBoard,
+                                          n, LoadBitmapFile(segFile[n]));
+            }
+
+            BSP_setPaused(0);
+
+            /* NOTE: the application main_gui() is called from main() */
+            return 0;
+        }
+
+        case WM_DESTROY: {
+            PostQuitMessage(0);
+            return 0;
+        }
+
+        /* commands from child controls and menus... */
+        case WM_COMMAND: {
+            switch (wParam) {
+                case IDOK:
+                case IDCANCEL: {
+                    PostQuitMessage(0);
+                    break;
+                }
+                case IDC_USER: { /* owner-drawn button(s) */
+                    break;
+                }
+            }
+            return 0;
+        }
+
+        /* drawing of owner-drawn buttons... */
+        case WM_DRAWITEM: {
+            LPDRAWITEMSTRUCT pdis = (LPDRAWITEMSTRUCT)lParam;
+            switch (pdis->CtlID) {
+                case IDC_USER: { /* USER owner-drawn button */
+                    switch (OwnerDrawnButton_draw(&l_userBtn, pdis)) {
+                        case BTN_DEPRESSED: {
+                            BSP_setPaused(1);
+                            SegmentDisplay_setSegment(&l_userLED, 0U, 1U);
+                            break;
+                        }
+                        case BTN_RELEASED: {
+                            BSP_setPaused(0);
+                            SegmentDisplay_setSegment(&l_userLED, 0U, 0U);
+                            break;
+                        }
+                        default: {
+                            break;
+                        }
+                    }
+                    break;
+                }
+            }
+            return 0;
+        }
+
+        /* mouse input... */
+        case WM_MOUSEWHEEL: {
+            /* wheel turned forward? */
+            if ((HIWORD(wParam) & 0x8000U) == 0U) {
+                BSP_setPaused(1);
+            }
+            else { /* the wheel was turned backwards */
+                BSP_setPaused(0);
+            }
+            return 0;
+        }
+
+        /* keyboard input... */
+        case WM_KEYDOWN: {
+            switch (wParam) {
+                case VK_SPACE:
+                    BSP_setPaused(!l_paused);
+                    break;
+            }
+            return 0;
+        }
+
+    }
+    return 0;
+}
+/*..........................................................................*/
+void BSP_init(void) {
+}
+/*..........................................................................*/
+void BSP_terminate(int result) {
+    exit(result); /* the application runs in the main thread */
+}
+/*..........................................................................*/
+void BSP_sleep(uint32_t ticks) {
+    int const present = ((l_tick + ticks) / l_presentEvery)
+                        != (l_tick / l_presentEvery);
+    uint32_t n;
+    UINT k;
+
+    if (present) {
+        presentPending();
+        if (!DispatchMessages()) { /* the window closed? */
+            BSP_terminate(0);
+        }
+    }
+    for (n = ticks; n != 0U; --n) {
+        ++l_tick;
+        if ((l_dumpEvery != 0U) && ((l_tick % l_dumpEvery) == 0U)) {
+            char fileName[256];
+            presentPending(); /* the saved frames are never skipped */
+            snprintf(fileName, sizeof(fileName), "%s%06u.ppm",
+                     l_dumpPrefix, (unsigned)l_tick);
+            if (!SaveFrame(fileName)) {
+                fprintf(stderr, "%s: cannot save the frame\n", fileName);
+                BSP_terminate(-1);
+            }
+        }
+        for (k = 0U; k < l_nKeys; ++k) { /* scripted key presses */
+            if (l_keyTick[k] == l_tick) {
+                SendMessage(l_hWnd, WM_KEYDOWN, (WPARAM)VK_SPACE, (LPARAM)0);
+            }
+        }
+        if (l_tick == l_tickLimit) {
+            BSP_terminate(0);
+        }
+    }
+
+    if (l_speed != 0U) { /* pace the virtual clock to the real time? */
+        /* the real time of the current tick, so that no errors accumulate */
+        uint64_t const due = (uint64_t)l_tick * 1000000000U
+                             / ((uint64_t)BSP_TICKS_PER_SEC * l_speed);
+        struct timespec now;
+        uint64_t elapsed;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        elapsed = (uint64_t)(now.tv_sec - l_startTime.tv_sec) * 1000000000U
+                  + (uint64_t)now.tv_nsec - (uint64_t)l_startTime.tv_nsec;
+        if (due > elapsed) {
+            struct timespec ts;
+            ts.tv_sec  = (time_t)((due - elapsed) / 1000000000U);
+            ts.tv_nsec = (long)((due - elapsed) % 1000000000U);
+            nanosleep(&ts, NULL);
+        }
+    }
+}
+/*..........................................................................*/
+void BSP_setPaused(int paused) {
+    l_paused = paused;
+    if (l_paused) {
+        l_bitmapPending = 0; /* discard the OLED drawing not shown yet */
+        GraphicDisplay_clear(&l_oled);
+        l_oledShownValid = 0; /* the OLED no longer shows l_oledShown[] */
+        BSP_drawNString(35U, 0U, "PAUSED");
+        GraphicDisplay_redraw(&l_oled);
+
+        SetDlgItemText(l_hWnd, IDC_PAUSED, "PAUSED");
+    }
+    else {
+        SetDlgItemText(l_hWnd, IDC_PAUSED, "RUNNING");
+    }
+}
+/*..........................................................................*/
+int BSP_isPaused(void) {
+    return l_paused;
+}
+
+/*..........................................................................*/
+/* NOTE: the drawing is deferred to the end of the presentation ticks
+* (see presentPending()), so the frames between them are skipped.
+*/
+void BSP_drawBitmap(uint8_t const *bitmap) {
+    memcpy(l_pendingBitmap, bitmap, sizeof(l_pendingBitmap));
+    l_bitmapPending = 1;
+}
+/*..........................................................................*/
+void BSP_drawCount(uint32_t n) {
+    l_pendingCount = n;
+    l_countPending = 1;
+}
+/*..........................................................................*/
+static void presentPending(void) {
+    if (l_bitmapPending) {
+        l_bitmapPending = 0;
+        drawOled(l_pendingBitmap);
+    }
+    if (l_countPending) {
+        l_countPending = 0;
+        drawCount(l_pendingCount);
+    }
+}
+/*..........................................................................*/
+static void drawOled(uint8_t const *bitmap) {
+    UINT page;
+
+    /* the EK-LM3S811 OLED bitmap is organized in pages of 8 pixel rows,
+    * which are converted to the GraphicDisplay pixels 8 at a time. Only
+    * the range of columns that changed since the last call is converted.
+    */
+    for (page = 0U; page < BSP_SCREEN_HEIGHT/8U; ++page) {
+        uint8_t const *row = &bitmap[page*BSP_SCREEN_WIDTH];
+        uint8_t *shown = &l_oledShown[page*BSP_SCREEN_WIDTH];
+        UINT x0 = 0U;
+        UINT x1 = BSP_SCREEN_WIDTH;
+        if (l_oledShownValid) {
+            while ((x0 < x1) && (row[x0] == shown[x0])) {
+                ++x0;
+            }
+            while ((x1 > x0) && (row[x1 - 1U] == shown[x1 - 1U])) {
+                --x1;
+            }
+        }
+        if (x0 < x1) {
+            GraphicDisplay_blit(&l_oled, x0, page, x1 - x0, 1U,
+                                &row[x0], BSP_SCREEN_WIDTH, c_onColor);
+            memcpy(&shown[x0], &row[x0], x1 - x0);
+        }
+    }
+    l_oledShownValid = 1;
+
+    /* draw the updated part of the GraphicDisplay on the screen */
+    GraphicDisplay_redraw(&l_oled);
+}
+/*..........................................................................*/
+static void drawCount(uint32_t n) {
+    /* update the score in the l_scoreBoard SegmentDisplay */
+    SegmentDisplay_setSegment(&l_scoreBoard, 0U, (UINT)(n % 10U));
+    n /= 10U;
+    SegmentDisplay_setSegment(&l_scoreBoard, 1U, (UINT)(n % 10U));
+    n /= 10U;
+    SegmentDisplay_setSegment(&l_scoreBoard, 2U, (UINT)(n % 10U));
+    n /= 10U;
+    SegmentDisplay_setSegment(&l_scoreBoard, 3U, (UINT)(n % 10U));
+}
+/*..........................................................................*/
+void BSP_drawNString(uint8_t x, uint8_t y, char const *str) {
+    static uint8_t const font5x7[95][5] = {
+        { 0x00, 0x00, 0x00, 0x00, 0x00 },  /* ' ' */
+        { 0x00, 0x00, 0x4F, 0x00, 0x00 },  /* ! */
+        { 0x00, 0x07, 0x00, 0x07, 0x00 },  /* " */
+        { 0x14, 0x7F, 0x14, 0x7F, 0x14 },  /* # */
+        { 0x24, 0x2A, 0x7F, 0x2A, 0x12 },  /* $ */
+        { 0x23, 0x13, 0x08, 0x64, 0x62 },  /* % */
+        { 0x36, 0x49, 0x55, 0x22, 0x50 },  /* & */
+        { 0x00, 0x05, 0x03, 0x00, 0x00 },  /* ' */
+        { 0x00, 0x1C, 0x22, 0x41, 0x00 },  /* ( */
+        { 0x00, 0x41, 0x22, 0x1C, 0x00 },  /* ) */
+        { 0x14, 0x08, 0x3E, 0x08, 0x14 },  /* * */
+        { 0x08, 0x08, 0x3E, 0x08, 0x08 },  /* + */
+        { 0x00, 0x50, 0x30, 0x00, 0x00 },  /* , */
+        { 0x08, 0x08, 0x08, 0x08, 0x08 },  /* - */
+        { 0x00, 0x60, 0x60, 0x00, 0x00 },  /* . */
+        { 0x20, 0x10, 0x08, 0x04, 0x02 },  /* / */
+        { 0x3E, 0x51, 0x49, 0x45, 0x3E },  /* 0 */
+        { 0x00, 0x42, 0x7F, 0x40, 0x00 },  /* 1 */
+        { 0x42, 0x61, 0x51, 0x49, 0x46 },  /* 2 */
+        { 0x21, 0x41, 0x45, 0x4B, 0x31 },  /* 3 */
+        { 0x18, 0x14, 0x12, 0x7F, 0x10 },  /* 4 */
+        { 0x27, 0x45, 0x45, 0x45, 0x39 },  /* 5 */
+        { 0x3C, 0x4A, 0x49, 0x49, 0x30 },  /* 6 */
+        { 0x01, 0x71, 0x09, 0x05, 0x03 },  /* 7 */
+        { 0x36, 0x49, 0x49, 0x49, 0x36 },  /* 8 */
+        { 0x06, 0x49, 0x49, 0x29, 0x1E },  /* 9 */
+        { 0x00, 0x36, 0x36, 0x00, 0x00 },  /* : */
+        { 0x00, 0x56, 0x36, 0x00, 0x00 },  /* ; */
+        { 0x08, 0x14, 0x22, 0x41, 0x00 },  /* < */
+        { 0x14, 0x14, 0x14, 0x14, 0x14 },  /* = */
+        { 0x00, 0x41, 0x22, 0x14, 0x08 },  /* > */
+        { 0x02, 0x01, 0x51, 0x09, 0x06 },  /* ? */
+        { 0x32, 0x49, 0x79, 0x41, 0x3E },  /* @ */
+        { 0x7E, 0x11, 0x11, 0x11, 0x7E },  /* A */
+        { 0x7F, 0x49, 0x49, 0x49, 0x36 },  /* B */
+        { 0x3E, 0x41, 0x41, 0x41, 0x22 },  /* C */
+        { 0x7F, 0x41, 0x41, 0x22, 0x1C },  /* D */
+        { 0x7F, 0x49, 0x49, 0x49, 0x41 },  /* E */
+        { 0x7F, 0x09, 0x09, 0x09, 0x01 },  /* F */
+        { 0x3E, 0x41, 0x49, 0x49, 0x7A },  /* G */
+        { 0x7F, 0x08, 0x08, 0x08, 0x7F },  /* H */
+        { 0x00, 0x41, 0x7F, 0x41, 0x00 },  /* I */
+        { 0x20, 0x40, 0x41, 0x3F, 0x01 },  /* J */
+        { 0x7F, 0x08, 0x14, 0x22, 0x41 },  /* K */
+        { 0x7F, 0x40, 0x40, 0x40, 0x40 },  /* L */
+        { 0x7F, 0x02, 0x0C, 0x02, 0x7F },  /* M */
+        { 0x7F, 0x04, 0x08, 0x10, 0x7F },  /* N */
+        { 0x3E, 0x41, 0x41, 0x41, 0x3E },  /* O */
+        { 0x7F, 0x09, 0x09, 0x09, 0x06 },  /* P */
+        { 0x3E, 0x41, 0x51, 0x21, 0x5E },  /* Q */
+        { 0x7F, 0x09, 0x19, 0x29, 0x46 },  /* R */
+        { 0x46, 0x49, 0x49, 0x49, 0x31 },  /* S */
+        { 0x01, 0x01, 0x7F, 0x01, 0x01 },  /* T */
+        { 0x3F, 0x40, 0x40, 0x40, 0x3F },  /* U */
+        { 0x1F, 0x20, 0x40, 0x20, 0x1F },  /* V */
+        { 0x3F, 0x40, 0x38, 0x40, 0x3F },  /* W */
+        { 0x63, 0x14, 0x08, 0x14, 0x63 },  /* X */
+        { 0x07, 0x08, 0x70, 0x08, 0x07 },  /* Y */
+        { 0x61, 0x51, 0x49, 0x45, 0x43 },  /* Z */
+        { 0x00, 0x7F, 0x41, 0x41, 0x00 },  /* [ */
+        { 0x02, 0x04, 0x08, 0x10, 0x20 },  /* \ */
+        { 0x00, 0x41, 0x41, 0x7F, 0x00 },  /* ] */
+        { 0x04, 0x02, 0x01, 0x02, 0x04 },  /* ^ */
+        { 0x40, 0x40, 0x40, 0x40, 0x40 },  /* _ */
+        { 0x00, 0x01, 0x02, 0x04, 0x00 },  /* ` */
+        { 0x20, 0x54, 0x54, 0x54, 0x78 },  /* a */
+        { 0x7F, 0x48, 0x44, 0x44, 0x38 },  /* b */
+        { 0x38, 0x44, 0x44, 0x44, 0x20 },  /* c */
+        { 0x38, 0x44, 0x44, 0x48, 0x7F },  /* d */
+        { 0x38, 0x54, 0x54, 0x54, 0x18 },  /* e */
+        { 0x08, 0x7E, 0x09, 0x01, 0x02 },  /* f */
+        { 0x0C, 0x52, 0x52, 0x52, 0x3E },  /* g */
+        { 0x7F, 0x08, 0x04, 0x04, 0x78 },  /* h */
+        { 0x00, 0x44, 0x7D, 0x40, 0x00 },  /* i */
+        { 0x20, 0x40, 0x44, 0x3D, 0x00 },  /* j */
+        { 0x7F, 0x10, 0x28, 0x44, 0x00 },  /* k */
+        { 0x00, 0x41, 0x7F, 0x40, 0x00 },  /* l */
+        { 0x7C, 0x04, 0x18, 0x04, 0x78 },  /* m */
+        { 0x7C, 0x08, 0x04, 0x04, 0x78 },  /* n */
+        { 0x38, 0x44, 0x44, 0x44, 0x38 },  /* o */
+        { 0x7C, 0x14, 0x14, 0x14, 0x08 },  /* p */
+        { 0x08, 0x14, 0x14, 0x18, 0x7C },  /* q */
+        { 0x7C, 0x08, 0x04, 0x04, 0x08 },  /* r */
+        { 0x48, 0x54, 0x54, 0x54, 0x20 },  /* s */
+        { 0x04, 0x3F, 0x44, 0x40, 0x20 },  /* t */
+        { 0x3C, 0x40, 0x40, 0x20, 0x7C },  /* u */
+        { 0x1C, 0x20, 0x40, 0x20, 0x1C },  /* v */
+        { 0x3C, 0x40, 0x30, 0x40, 0x3C },  /* w */
+        { 0x44, 0x28, 0x10, 0x28, 0x44 },  /* x */
+        { 0x0C, 0x50, 0x50, 0x50, 0x3C },  /* y */
+        { 0x44, 0x64, 0x54, 0x4C, 0x44 },  /* z */
+        { 0x00, 0x08, 0x36, 0x41, 0x00 },  /* { */
+        { 0x00, 0x00, 0x7F, 0x00, 0x00 },  /* | */
+        { 0x00, 0x41, 0x36, 0x08, 0x00 },  /* } */
+        { 0x02, 0x01, 0x02, 0x04, 0x02 },  /* ~ */
+    };
+    UINT dx, dy;
+
+    l_oledShownValid = 0; /* the OLED no longer shows l_oledShown[] */
+    while (*str != '\0') {
+        uint8_t const *ch = &font5x7[*str - ' '][0];
+        for (dx = 0U; dx < 5U; ++dx) {
+            for (dy = 0U; dy < 8U; ++dy) {
+                if ((ch[dx] & (1U << dy)) != 0U) {
+                    GraphicDisplay_setPixel(&l_oled, (UINT)(x + dx),
+                                         (UINT)(y*8U + dy), c_onColor);
+                }
+                else {
+                    GraphicDisplay_clearPixel(&l_oled, (UINT)(x + dx),
+                                           (UINT)(y*8U + dy));
+                }
+            }
+        }
+        ++str;
+        x += 6;
+    }
+    /* draw the updated GraphicDisplay on the screen */
+    GraphicDisplay_redraw(&l_oled);
+}
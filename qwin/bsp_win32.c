@@ -35,6 +35,8 @@
 * <info@state-machine.com>
 *****************************************************************************/
 #include <stdint.h>
+#include <stdlib.h>  /* for strtoul() */
+#include <string.h>  /* for memcpy() */
 
 #include "bsp.h"  /* BSP interface */
 
@@ -57,10 +59,81 @@ static BYTE const c_offColor[3] = {  15U,  15U,  15U }; /* very dark gray */
 
 static int l_paused;
 
+/* the bitmap currently shown on the OLED display, to redraw only changes */
+static uint8_t l_oledShown[BSP_SCREEN_WIDTH * BSP_SCREEN_HEIGHT/8U];
+static int     l_oledShownValid; /* the OLED was not drawn otherwise */
+
+/* virtual clock: the ticks advance as fast as the application runs,
+* optionally paced to the speed factor times the real time
+*/
+static uint32_t l_tick;         /* the virtual time in clock ticks */
+static uint32_t l_speed = 1U;   /* speed factor (0 as fast as possible) */
+static uint32_t l_presentEvery = 1U; /* present every n-th tick */
+static DWORD    l_startTime;    /* the real time of the tick 0 [ms] */
+
+/* the drawing deferred until the next presentation */
+static uint8_t  l_pendingBitmap[BSP_SCREEN_WIDTH * BSP_SCREEN_HEIGHT/8U];
+static int      l_bitmapPending;
+static uint32_t l_pendingCount;
+static int      l_countPending;
+
 /* Local functions ---------------------------------------------------------*/
 static LRESULT CALLBACK WndProc(HWND hWnd, UINT iMsg,
                                 WPARAM wParam, LPARAM lParam);
+static void presentPending(void);
+static void drawOled(uint8_t const *bitmap);
+static void drawCount(uint32_t n);
 
+/*..........................................................................*/
+/* copy the next whitespace-separated (or double-quoted) argument of the
+* command line to tok[] and return the position after it
+*/
+static char const *nextArg(char const *p, char *tok, size_t size) {
+    size_t n = 0U;
+    int quoted = 0;
+    while ((*p == ' ') || (*p == '\t')) {
+        ++p;
+    }
+    for (; *p != '\0'; ++p) {
+        if (*p == '"') {
+            quoted = !quoted;
+        }
+        else if (!quoted && ((*p == ' ') || (*p == '\t'))) {
+            break;
+        }
+        else if (n + 1U < size) {
+            tok[n++] = *p;
+        }
+    }
+    tok[n] = '\0';
+    return p;
+}
+/*..........................................................................*/
+/* the command-line options of the virtual clock:
+* -x <speed> run at the given multiple of the real time (0: full speed)
+* -f <n>     present only every n-th tick
+*/
+static void parseCmdLine(char const *cmdLine) {
+    char opt[256];
+    char val[256];
+    char const *p = cmdLine;
+    while (*p != '\0') {
+        p = nextArg(p, opt, sizeof(opt));
+        if ((opt[0] == '-') && ((opt[1] == 'x') || (opt[1] == 'f'))
+            && (opt[2] == '\0'))
+        {
+            uint32_t n;
+            p = nextArg(p, val, sizeof(val));
+            n = (uint32_t)strtoul(val, NULL, 10);
+            if (opt[1] == 'x') {
+                l_speed = n;
+            }
+            else {
+                l_presentEvery = (n != 0U) ? n : 1U;
+            }
+        }
+    }
+}
 /*..........................................................................*/
 int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrevInst,
                    LPSTR cmdLine, int iCmdShow)
@@ -72,6 +145,7 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrevInst,
 
     l_hInst   = hInst;   /* save the application instance */
     l_cmdLine = cmdLine; /* save the command line string */
+    parseCmdLine(l_cmdLine);
 
     /* create the main custom dialog window */
     hWnd = CreateCustDialog(hInst, IDD_APPLICATION, NULL,
@@ -117,9 +191,13 @@ static LRESULT CALLBACK WndProc(HWND hWnd, UINT iMsg,
 
         /* Perform initialization after all child windows have been created */
         case WM_INITDIALOG: {
-            GraphicDisplay_init(&l_oled,
+            if (!GraphicDisplay_init(&l_oled,
                        BSP_SCREEN_WIDTH,  BSP_SCREEN_HEIGHT,
-                       IDC_LCD, c_offColor);
+                       IDC_LCD, c_offColor))
+            {
+                PostQuitMessage(-1); /* no application thread to run */
+                return 0;
+            }
 
             SegmentDisplay_init(&l_userLED,
                                 1U,   /* 1 "segment" (the LED itself) */
@@ -161,6 +239,7 @@ static LRESULT CALLBACK WndProc(HWND hWnd, UINT iMsg,
             BSP_setPaused(0);
 
             /* --> Spawn the application thread to run main_gui() */
+            l_startTime = GetTickCount();
             CreateThread(NULL, 0, &appThread, NULL, 0, NULL);
 
             return 0;
@@ -171,6 +250,20 @@ static LRESULT CALLBACK WndProc(HWND hWnd, UINT iMsg,
             return 0;
         }
 
+        /* repaint the whole OLED after the window has been uncovered,
+        * as GraphicDisplay_redraw() only draws the changed pixels
+        */
+        case WM_PAINT: {
+            PAINTSTRUCT ps;
+            BeginPaint(hWnd, &ps);
+            EndPaint(hWnd, &ps);
+            if (l_oled.bits != (BYTE *)0) { /* OLED initialized? */
+                UpdateWindow(l_oled.hItem); /* the control paints first */
+                GraphicDisplay_redrawAll(&l_oled);
+            }
+            return 0;
+        }
+
         /* commands from child controls and menus... */
         case WM_COMMAND: {
             switch (wParam) {
@@ -247,13 +340,30 @@ void BSP_terminate(int result) {
 }
 /*..........................................................................*/
 void BSP_sleep(uint32_t ticks) {
-    Sleep(1000U * ticks  / BSP_TICKS_PER_SEC);
+    if (((l_tick + ticks) / l_presentEvery) != (l_tick / l_presentEvery)) {
+        presentPending();
+    }
+    l_tick += ticks;
+    if (l_speed != 0U) { /* pace the virtual clock to the real time? */
+        /* the real time of the current tick, so that no errors accumulate */
+        DWORD const due = (DWORD)((uint64_t)l_tick * 1000U
+                                  / ((uint64_t)BSP_TICKS_PER_SEC * l_speed));
+        DWORD const elapsed = GetTickCount() - l_startTime;
+        if ((LONG)(due - elapsed) > 0) {
+            Sleep(due - elapsed);
+        }
+    }
+    else {
+        Sleep(0); /* yield to the GUI thread */
+    }
 }
 /*..........................................................................*/
 void BSP_setPaused(int paused) {
     l_paused = paused;
     if (l_paused) {
+        l_bitmapPending = 0; /* discard the OLED drawing not shown yet */
         GraphicDisplay_clear(&l_oled);
+        l_oledShownValid = 0; /* the OLED no longer shows l_oledShown[] */
         BSP_drawNString(35U, 0U, "PAUSED");
         GraphicDisplay_redraw(&l_oled);
 
@@ -269,26 +379,63 @@ int BSP_isPaused(void) {
 }
 
 /*..........................................................................*/
+/* NOTE: the drawing is deferred to the end of the presentation ticks
+* (see presentPending()), so the frames between them are skipped.
+*/
 void BSP_drawBitmap(uint8_t const *bitmap) {
-    UINT x, y;
-    /* map the EK-LM3S811 OLED pixels to the GraphicDisplay pixels... */
-    for (y = 0; y < BSP_SCREEN_HEIGHT; ++y) {
-        for (x = 0; x < BSP_SCREEN_WIDTH; ++x) {
-            uint8_t bits = bitmap[x + (y/8U)*BSP_SCREEN_WIDTH];
-            if ((bits & (1U << (y & 0x07U))) != 0U) {
-                GraphicDisplay_setPixel(&l_oled, x, y, c_onColor);
+    memcpy(l_pendingBitmap, bitmap, sizeof(l_pendingBitmap));
+    l_bitmapPending = 1;
+}
+/*..........................................................................*/
+void BSP_drawCount(uint32_t n) {
+    l_pendingCount = n;
+    l_countPending = 1;
+}
+/*..........................................................................*/
+static void presentPending(void) {
+    if (l_bitmapPending) {
+        l_bitmapPending = 0;
+        drawOled(l_pendingBitmap);
+    }
+    if (l_countPending) {
+        l_countPending = 0;
+        drawCount(l_pendingCount);
+    }
+}
+/*..........................................................................*/
+static void drawOled(uint8_t const *bitmap) {
+    UINT page;
+
+    /* the EK-LM3S811 OLED bitmap is organized in pages of 8 pixel rows,
+    * which are converted to the GraphicDisplay pixels 8 at a time. Only
+    * the range of columns that changed since the last call is converted.
+    */
+    for (page = 0U; page < BSP_SCREEN_HEIGHT/8U; ++page) {
+        uint8_t const *row = &bitmap[page*BSP_SCREEN_WIDTH];
+        uint8_t *shown = &l_oledShown[page*BSP_SCREEN_WIDTH];
+        UINT x0 = 0U;
+        UINT x1 = BSP_SCREEN_WIDTH;
+        if (l_oledShownValid) {
+            while ((x0 < x1) && (row[x0] == shown[x0])) {
+                ++x0;
             }
-            else {
-                GraphicDisplay_clearPixel(&l_oled, x, y);
+            while ((x1 > x0) && (row[x1 - 1U] == shown[x1 - 1U])) {
+                --x1;
             }
         }
+        if (x0 < x1) {
+            GraphicDisplay_blit(&l_oled, x0, page, x1 - x0, 1U,
+                                &row[x0], BSP_SCREEN_WIDTH, c_onColor);
+            memcpy(&shown[x0], &row[x0], x1 - x0);
+        }
     }
+    l_oledShownValid = 1;
 
-    /* draw the updated GraphicDisplay on the screen */
+    /* draw the updated part of the GraphicDisplay on the screen */
     GraphicDisplay_redraw(&l_oled);
 }
 /*..........................................................................*/
-void BSP_drawCount(uint32_t n) {
+static void drawCount(uint32_t n) {
     /* update the score in the l_scoreBoard SegmentDisplay */
     SegmentDisplay_setSegment(&l_scoreBoard, 0U, (UINT)(n % 10U));
     n /= 10U;
@@ -399,6 +546,7 @@ void BSP_drawNString(uint8_t x, uint8_t y, char const *str) {
     };
     UINT dx, dy;
 
+    l_oledShownValid = 0; /* the OLED no longer shows l_oledShown[] */
     while (*str != '\0') {
         uint8_t const *ch = &font5x7[*str - ' '][0];
         for (dx = 0U; dx < 5U; ++dx) {
@@ -34,6 +34,7 @@
 * mailto:info@state-machine.com
 *****************************************************************************/
 #include <stdint.h>
+#include <string.h>         /* for memcpy() */
 //#include <intrinsics.h>
 
 #include "bsp.h"            /* BSP interface */
@@ -46,6 +47,8 @@
 /* Local-scope objects -----------------------------------------------------*/
 static int volatile l_tickCtr;
 static int l_paused;
+static uint8_t l_oledShown[BSP_SCREEN_WIDTH * BSP_SCREEN_HEIGHT/8U];
+static int     l_oledShownValid; /* the OLED was not drawn otherwise */
 
 /*..........................................................................*/
 void Q_onError(char const *module, int id); /* prototype */
@@ -173,8 +176,19 @@ int BSP_isPaused(void) {
 
 /*..........................................................................*/
 void BSP_drawBitmap(uint8_t const *bitmap) {
-    Display96x16x1ImageDraw(bitmap, 0, 0,
-                            BSP_SCREEN_WIDTH, (BSP_SCREEN_HEIGHT >> 3));
+    /* send over the I2C bus only the columns that have changed since
+    * the last frame, which is typically a small fraction of the screen
+    */
+    if (l_oledShownValid) {
+        Display96x16x1ImageUpdate(bitmap, l_oledShown, 0, 0,
+                                  BSP_SCREEN_WIDTH, (BSP_SCREEN_HEIGHT >> 3));
+    }
+    else {
+        Display96x16x1ImageDraw(bitmap, 0, 0,
+                                BSP_SCREEN_WIDTH, (BSP_SCREEN_HEIGHT >> 3));
+        memcpy(l_oledShown, bitmap, sizeof(l_oledShown));
+        l_oledShownValid = 1;
+    }
 }
 /*..........................................................................*/
 void BSP_drawCount(uint32_t n) {
@@ -182,4 +196,5 @@ void BSP_drawCount(uint32_t n) {
 /*..........................................................................*/
 void BSP_drawNString(uint8_t x, uint8_t y, char const *str) {
     Display96x16x1StringDraw(str, x, y);
+    l_oledShownValid = 0; /* the OLED no longer shows l_oledShown[] */
 }
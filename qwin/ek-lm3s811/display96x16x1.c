@@ -35,7 +35,11 @@
 //
 //*****************************************************************************
 
+#ifdef SSD_EMU
+#include "ssd_emu.h"   // host-side emulation of the I2C master and the panel
+#else
 #include "LM3S811.h"
+#endif
 #include "display96x16x1.h"
 
 //*****************************************************************************
@@ -422,6 +426,16 @@ static uint8_t const g_pucRITRow2[] =
 //*****************************************************************************
 #define SIZE_CURSOR_ROW_COMMAND 6
 
+//*****************************************************************************
+//
+// The number of bus bytes needed to start a new transfer at a given column:
+// the slave address, the first command prefix, and the cursor row command.
+// Unchanged runs of columns shorter than this are cheaper to re-send than to
+// skip with a new transfer.
+//
+//*****************************************************************************
+#define SIZE_SPAN_OVERHEAD (SIZE_CURSOR_ROW_COMMAND + 2)
+
 //*****************************************************************************
 //
 // Macros used to select the appropriate cursor row setting commands.
@@ -475,7 +489,9 @@ static uint8_t g_ucColumnAdjust;
 static unsigned long g_ulDelay;
 
 //*****************************************************************************
-#if defined ( __CC_ARM )
+#if defined ( SSD_EMU )
+#define SysCtlDelay(ulCount) SSDEmu_delay(ulCount)
+#elif defined ( __CC_ARM )
 static void __asm SysCtlDelay(unsigned long ulCount) {
 SysCtlDelay_loop
     SUBS r0,#1
@@ -683,6 +699,53 @@ Display96x16x1WriteFinal(uint8_t ucChar)
     SysCtlDelay(g_ulDelay);
 }
 
+//*****************************************************************************
+//
+//! \internal
+//!
+//! Write a run of columns of one row to the SSD0303 or SSD1300 controller.
+//!
+//! \param pucData is a pointer to the column data.
+//! \param ulX is the column of the first byte, from the left edge of the
+//! display.
+//! \param ulY is the row (0 or 1).
+//! \param ulCount is the number of columns to write (at least one).
+//!
+//! This function sets the cursor of the display controller and writes the
+//! column data in a single I2C transfer.
+//!
+//! \return None.
+//
+//*****************************************************************************
+static void
+Display96x16x1RowWrite(uint8_t const *pucData, uint32_t ulX, uint32_t ulY,
+                       uint32_t ulCount)
+{
+    //
+    // The first few columns of the LCD buffer are not displayed, so increment
+    // the X coorddinate by this amount to account for the non-displayed frame
+    // buffer memory.
+    //
+    ulX += g_ucColumnAdjust;
+
+    //
+    // Write the starting address within this row.
+    //
+    Display96x16x1WriteFirst(0x80);
+    Display96x16x1WriteByte((ulY == 0) ? 0xb0 : 0xb1);
+    Display96x16x1WriteByte(0x80);
+    Display96x16x1WriteByte(ulX & 0x0f);
+    Display96x16x1WriteByte(0x80);
+    Display96x16x1WriteByte(0x10 | ((ulX >> 4) & 0x0f));
+    Display96x16x1WriteByte(0x40);
+
+    //
+    // Write the column data.
+    //
+    Display96x16x1WriteArray(pucData, ulCount - 1);
+    Display96x16x1WriteFinal(pucData[ulCount - 1]);
+}
+
 //*****************************************************************************
 //
 //! Clears the OLED display.
@@ -899,38 +962,174 @@ Display96x16x1ImageDraw(const uint8_t *pucImage, uint32_t ulX,
                       uint32_t ulHeight)
 {
     //
-    // The first few columns of the LCD buffer are not displayed, so increment
-    // the X coorddinate by this amount to account for the non-displayed frame
-    // buffer memory.
+    // Loop while there are more rows to display.
     //
-    ulX += g_ucColumnAdjust;
+    while(ulHeight--)
+    {
+        //
+        // Write this row of image data.
+        //
+        Display96x16x1RowWrite(pucImage, ulX, ulY, ulWidth);
+
+        //
+        // Advance to the next row of the image.
+        //
+        pucImage += ulWidth;
+        ulY++;
+    }
+}
+
+//*****************************************************************************
+//
+//! Displays a range of columns of an image on the OLED display.
+//!
+//! \param pucImage is a pointer to the image data.
+//! \param ulX is the horizontal position of the image, specified in columns
+//! from the left edge of the display.
+//! \param ulY is the vertical position of the image, specified in eight scan
+//! line blocks from the top of the display (that is, only 0 and 1 are valid).
+//! \param ulWidth is the width of the image, specified in columns.
+//! \param ulHeight is the height of the image, specified in eight row blocks
+//! (that is, only 1 and 2 are valid).
+//! \param ulStart is the first column of the image to be displayed.
+//! \param ulCount is the number of columns of the image to be displayed.
+//!
+//! This function will display only the columns \e ulStart through
+//! \e ulStart + \e ulCount - 1 of the image, which is organized as for
+//! Display96x16x1ImageDraw().  The remaining columns on the display are left
+//! unchanged, so an application which knows which part of the image has
+//! changed can update the display in a fraction of the bus time.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+Display96x16x1ImageColumnsDraw(const uint8_t *pucImage, uint32_t ulX,
+                               uint32_t ulY, uint32_t ulWidth,
+                               uint32_t ulHeight, uint32_t ulStart,
+                               uint32_t ulCount)
+{
+    //
+    // Clip the column range to the image.
+    //
+    if(ulStart >= ulWidth)
+    {
+        return;
+    }
+    if(ulCount > (ulWidth - ulStart))
+    {
+        ulCount = ulWidth - ulStart;
+    }
 
     //
     // Loop while there are more rows to display.
     //
-    while(ulHeight--)
+    while(ulCount && ulHeight--)
     {
         //
-        // Write the starting address within this row.
+        // Write the column range of this row of image data.
         //
-        Display96x16x1WriteFirst(0x80);
-        Display96x16x1WriteByte((ulY == 0) ? 0xb0 : 0xb1);
-        Display96x16x1WriteByte(0x80);
-        Display96x16x1WriteByte(ulX & 0x0f);
-        Display96x16x1WriteByte(0x80);
-        Display96x16x1WriteByte(0x10 | ((ulX >> 4) & 0x0f));
-        Display96x16x1WriteByte(0x40);
+        Display96x16x1RowWrite(pucImage + ulStart, ulX + ulStart, ulY,
+                               ulCount);
 
         //
-        // Write this row of image data.
+        // Advance to the next row of the image.
         //
-        Display96x16x1WriteArray(pucImage, ulWidth - 1);
-        Display96x16x1WriteFinal(pucImage[ulWidth - 1]);
+        pucImage += ulWidth;
+        ulY++;
+    }
+}
+
+//*****************************************************************************
+//
+//! Updates an image on the OLED display, sending only the changed columns.
+//!
+//! \param pucImage is a pointer to the new image data.
+//! \param pucShown is a pointer to the image data currently shown on the
+//! display, which is updated to the new image data.
+//! \param ulX is the horizontal position of the image, specified in columns
+//! from the left edge of the display.
+//! \param ulY is the vertical position of the image, specified in eight scan
+//! line blocks from the top of the display (that is, only 0 and 1 are valid).
+//! \param ulWidth is the width of the image, specified in columns.
+//! \param ulHeight is the height of the image, specified in eight row blocks
+//! (that is, only 1 and 2 are valid).
+//!
+//! This function compares the new image with the image currently shown,
+//! both organized as for Display96x16x1ImageDraw(), and sends only the
+//! columns which differ.  The changed columns of each row are sent as spans
+//! of consecutive columns, where runs of unchanged columns shorter than the
+//! cost of addressing a new span are sent along with the changed ones.  Rows
+//! without changes are not sent at all.
+//!
+//! The caller must make sure that \e pucShown really matches the display,
+//! for example by drawing the image once with Display96x16x1ImageDraw() and
+//! copying it to \e pucShown, and again after the display has been changed
+//! by any other function of this driver.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+Display96x16x1ImageUpdate(const uint8_t *pucImage, uint8_t *pucShown,
+                          uint32_t ulX, uint32_t ulY, uint32_t ulWidth,
+                          uint32_t ulHeight)
+{
+    uint32_t ulCol, ulStart, ulEnd;
+
+    //
+    // Loop while there are more rows to update.
+    //
+    while(ulHeight--)
+    {
+        //
+        // Find the spans of the changed columns in this row.
+        //
+        for(ulCol = 0; ulCol < ulWidth; )
+        {
+            //
+            // Skip the unchanged columns.
+            //
+            if(pucImage[ulCol] == pucShown[ulCol])
+            {
+                ulCol++;
+                continue;
+            }
+
+            //
+            // Extend the span while the next change is closer than the cost
+            // of starting a new span.
+            //
+            ulStart = ulCol;
+            ulEnd = ulCol + 1;
+            for(ulCol = ulEnd; ulCol < ulWidth; ulCol++)
+            {
+                if(pucImage[ulCol] != pucShown[ulCol])
+                {
+                    ulEnd = ulCol + 1;
+                }
+                else if((ulCol - ulEnd) >= SIZE_SPAN_OVERHEAD)
+                {
+                    break;
+                }
+            }
+
+            //
+            // Send the span and remember it as shown.
+            //
+            Display96x16x1RowWrite(pucImage + ulStart, ulX + ulStart, ulY,
+                                   ulEnd - ulStart);
+            for(ulCol = ulStart; ulCol < ulEnd; ulCol++)
+            {
+                pucShown[ulCol] = pucImage[ulCol];
+            }
+        }
 
         //
         // Advance to the next row of the image.
         //
         pucImage += ulWidth;
+        pucShown += ulWidth;
         ulY++;
     }
 }
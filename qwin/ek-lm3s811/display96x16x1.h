@@ -42,6 +42,17 @@ extern void Display96x16x1ImageDraw(uint8_t const *pucImage,
                                   uint32_t ulX, uint32_t ulY,
                                   uint32_t ulWidth,
                                   uint32_t ulHeight);
+extern void Display96x16x1ImageColumnsDraw(uint8_t const *pucImage,
+                                           uint32_t ulX, uint32_t ulY,
+                                           uint32_t ulWidth,
+                                           uint32_t ulHeight,
+                                           uint32_t ulStart,
+                                           uint32_t ulCount);
+extern void Display96x16x1ImageUpdate(uint8_t const *pucImage,
+                                      uint8_t *pucShown,
+                                      uint32_t ulX, uint32_t ulY,
+                                      uint32_t ulWidth,
+                                      uint32_t ulHeight);
 extern void Display96x16x1Init(uint8_t bFast);
 extern void Display96x16x1DisplayOn(void);
 extern void Display96x16x1DisplayOff(void);
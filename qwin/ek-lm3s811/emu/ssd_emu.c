@@ -0,0 +1,479 @@
+/**
+* @file
+* @brief Host-side emulation of the EK-LM3S811 OLED display (SSD0303/SSD1300)
+* @cond
+******************************************************************************
+* Last updated for version 6.9.3
+* Last updated on  2021-03-03
+*
+*                    Q u a n t u m  L e a P s
+*                    ------------------------
+*                    Modern Embedded Software
+*
+* Copyright (C) 2021 Quantum Leaps, LLC. All rights reserved.
+*
+* MIT License:
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* Contact information:
+* <www.state-machine.com>
+* <info@state-machine.com>
+******************************************************************************
+* @endcond
+*/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "ssd_emu.h"
+#include "display96x16x1.h"  /* the OLED display driver (TI) under test */
+
+/* The emulator drives the unmodified TI display driver with a few
+* animations and checks the display RAM of the emulated controller
+* against the animation frame after every frame. Each animation is drawn
+* with the whole image (Display96x16x1ImageDraw()), with the column range
+* known to the application (Display96x16x1ImageColumnsDraw()) and with the
+* changed columns only (Display96x16x1ImageUpdate()), so that the bus
+* traffic of the three methods can be compared.
+*
+* Build and run (in the ek-lm3s811 directory):
+* gcc -DSSD_EMU -I. -Iemu emu/ssd_emu.c display96x16x1.c -lm -o ssd_emu
+* ./ssd_emu [-n frames] [-o | -r]
+*
+* The exit status is non-zero when any frame on the display differs from
+* the animation or the command stream violates the controller protocol.
+*/
+
+#define SSD_ADDR      0x3DU     /* the I2C slave address of the controller */
+#define SSD_COLUMNS   132U      /* columns of the display RAM */
+#define SSD_PAGES     8U        /* pages (8 scan lines) of the display RAM */
+
+#define MCS_RUN       (1U << 0) /* bits of the I2C master control register */
+#define MCS_START     (1U << 1)
+#define MCS_STOP      (1U << 2)
+
+#define FRAME_SIZE    (SSD_EMU_WIDTH * SSD_EMU_PAGES)
+
+/* Emulated registers ------------------------------------------------------*/
+SSDEmu_SysCtl SSDEmu_sysctl;
+SSDEmu_Gpio   SSDEmu_gpiob;
+SSDEmu_Gpio   SSDEmu_gpiod;
+uint32_t      SystemCoreClock = 20000000U; /* see system_LM3S811.c */
+SSDEmuStats   SSDEmu_stats;
+
+static SSDEmu_I2CMaster l_i2c;
+
+/* Emulated controller -----------------------------------------------------*/
+enum SSDState {
+    SSD_IDLE,       /* no transfer in progress */
+    SSD_CTRL,       /* expecting the control byte */
+    SSD_CMD_ONE,    /* one command byte follows (Co = 1, D/C# = 0) */
+    SSD_DATA_ONE,   /* one data byte follows (Co = 1, D/C# = 1) */
+    SSD_CMD_ALL,    /* only command bytes follow (Co = 0, D/C# = 0) */
+    SSD_DATA_ALL    /* only data bytes follow (Co = 0, D/C# = 1) */
+};
+
+static struct {
+    uint8_t  ram[SSD_PAGES][SSD_COLUMNS];
+    unsigned state;     /* enum SSDState */
+    unsigned page;      /* the page address */
+    unsigned col;       /* the column address */
+    unsigned args;      /* argument bytes of the current command to skip */
+    unsigned colAdjust; /* the first column shown on the panel */
+} l_ssd;
+
+/* Local functions ---------------------------------------------------------*/
+static void ssdCommand(uint8_t b);
+static void ssdData(uint8_t b);
+static void ssdByte(uint8_t b);
+
+/*..........................................................................*/
+static void ssdCommand(uint8_t b) {
+    if (l_ssd.args != 0U) { /* argument of the previous command? */
+        --l_ssd.args;
+    }
+    else if (b <= 0x0FU) {  /* set lower column address */
+        l_ssd.col = (l_ssd.col & 0xF0U) | (b & 0x0FU);
+    }
+    else if (b <= 0x1FU) {  /* set higher column address */
+        l_ssd.col = (l_ssd.col & 0x0FU) | ((unsigned)(b & 0x0FU) << 4);
+    }
+    else if ((b & 0xF8U) == 0xB0U) { /* set page address */
+        l_ssd.page = (b & 0x07U);
+    }
+    else {
+        switch (b) {
+            case 0x81U: /* contrast */
+            case 0x82U: /* brightness */
+            case 0xA8U: /* multiplex ratio */
+            case 0xADU: /* DC-DC converter */
+            case 0xD3U: /* display offset */
+            case 0xD5U: /* clock divide ratio */
+            case 0xD8U: /* area color/mono mode */
+            case 0xD9U: /* pre-charge period */
+            case 0xDAU: /* COM pins configuration */
+            case 0xDBU: /* VCOM deselect level */
+                l_ssd.args = 1U;
+                break;
+            case 0x91U: /* look-up table */
+                l_ssd.args = 4U;
+                break;
+            default:    /* other commands don't affect the display RAM */
+                break;
+        }
+    }
+}
+/*..........................................................................*/
+static void ssdData(uint8_t b) {
+    if ((l_ssd.page >= SSD_EMU_PAGES)
+        || (l_ssd.col < l_ssd.colAdjust)
+        || (l_ssd.col >= l_ssd.colAdjust + SSD_EMU_WIDTH))
+    {
+        ++SSDEmu_stats.errors; /* not visible, the driver wastes the bus */
+    }
+    if (l_ssd.col < SSD_COLUMNS) {
+        l_ssd.ram[l_ssd.page][l_ssd.col] = b;
+        ++l_ssd.col;
+    }
+}
+/*..........................................................................*/
+static void ssdByte(uint8_t b) {
+    switch (l_ssd.state) {
+        case SSD_CTRL:
+            if ((b & 0x3FU) != 0U) { /* reserved bits must be 0 */
+                ++SSDEmu_stats.errors;
+            }
+            if ((b & 0x80U) != 0U) { /* Co: one byte follows? */
+                l_ssd.state = ((b & 0x40U) != 0U) ? SSD_DATA_ONE : SSD_CMD_ONE;
+            }
+            else {
+                l_ssd.state = ((b & 0x40U) != 0U) ? SSD_DATA_ALL : SSD_CMD_ALL;
+            }
+            break;
+        case SSD_CMD_ONE:
+            ssdCommand(b);
+            l_ssd.state = SSD_CTRL;
+            break;
+        case SSD_DATA_ONE:
+            ssdData(b);
+            l_ssd.state = SSD_CTRL;
+            break;
+        case SSD_CMD_ALL:
+            ssdCommand(b);
+            break;
+        case SSD_DATA_ALL:
+            ssdData(b);
+            break;
+        default: /* byte outside of a transfer */
+            ++SSDEmu_stats.errors;
+            break;
+    }
+}
+/*..........................................................................*/
+SSDEmu_I2CMaster *SSDEmu_i2c(void) {
+    uint32_t const cmd = l_i2c.MCS;
+    if (cmd != 0U) { /* a byte to deliver? */
+        l_i2c.MCS = 0U;
+        if ((cmd & MCS_START) != 0U) {
+            if (l_i2c.MSA != (SSD_ADDR << 1)) { /* not our address? */
+                ++SSDEmu_stats.errors;
+            }
+            l_ssd.state = SSD_CTRL;
+            ++SSDEmu_stats.bytes; /* the slave address */
+        }
+        else if (l_ssd.state == SSD_IDLE) { /* no transfer started? */
+            ++SSDEmu_stats.errors;
+        }
+        if ((cmd & MCS_RUN) != 0U) {
+            ++SSDEmu_stats.bytes;
+            ssdByte((uint8_t)l_i2c.MDR);
+        }
+        if ((cmd & MCS_STOP) != 0U) {
+            if (l_ssd.state != SSD_CTRL) { /* controller expects more? */
+                if ((l_ssd.state == SSD_CMD_ONE)
+                    || (l_ssd.state == SSD_DATA_ONE))
+                {
+                    ++SSDEmu_stats.errors;
+                }
+            }
+            l_ssd.state = SSD_IDLE;
+            ++SSDEmu_stats.transfers;
+        }
+    }
+    l_i2c.MRIS = 1U; /* the transfer of every byte completes immediately */
+    return &l_i2c;
+}
+/*..........................................................................*/
+void SSDEmu_delay(uint32_t ulCount) {
+    SSDEmu_stats.delayLoops += ulCount;
+}
+/*..........................................................................*/
+void SSDEmu_reset(int isRIT) {
+    memset(&SSDEmu_sysctl, 0, sizeof(SSDEmu_sysctl));
+    memset(&SSDEmu_gpiob,  0, sizeof(SSDEmu_gpiob));
+    memset(&SSDEmu_gpiod,  0, sizeof(SSDEmu_gpiod));
+    memset(&l_i2c, 0, sizeof(l_i2c));
+    memset(&l_ssd, 0, sizeof(l_ssd));
+
+    /* the later kits with the RIT display have the bit 12 of DID1 set */
+    SSDEmu_sysctl.DID1 = (isRIT != 0) ? (1U << 12) : 0U;
+
+    /* fill the RAM with garbage, which the driver must clear */
+    memset(l_ssd.ram, 0xA5, sizeof(l_ssd.ram));
+    l_ssd.colAdjust = (isRIT != 0) ? 4U : 36U;
+    l_ssd.state = SSD_IDLE;
+    SSDEmu_clearStats();
+}
+/*..........................................................................*/
+void SSDEmu_clearStats(void) {
+    memset(&SSDEmu_stats, 0, sizeof(SSDEmu_stats));
+}
+/*..........................................................................*/
+uint32_t SSDEmu_check(uint8_t const *image) {
+    uint32_t n = 0U;
+    unsigned page;
+    unsigned x;
+    for (page = 0U; page < SSD_EMU_PAGES; ++page) {
+        for (x = 0U; x < SSD_EMU_WIDTH; ++x) {
+            if (l_ssd.ram[page][l_ssd.colAdjust + x]
+                != image[page*SSD_EMU_WIDTH + x])
+            {
+                ++n;
+            }
+        }
+    }
+    return n;
+}
+/*..........................................................................*/
+double SSDEmu_busTime(void) {
+    /* the I2C clock set by the driver in the MTPR register */
+    double const fI2C = (double)SystemCoreClock / (20.0 * (l_i2c.MTPR + 1U));
+
+    /* 9 clocks per byte (with ACK), START and STOP conditions,
+    * and the inter-byte delay loop of the driver
+    */
+    return (9.0 * SSDEmu_stats.bytes + 2.0 * SSDEmu_stats.transfers)
+               * 1e6 / fI2C
+           + 3.0 * SSDEmu_stats.delayLoops * 1e6 / (double)SystemCoreClock;
+}
+
+/* Animations ==============================================================*/
+/* produce the frame n from the previous frame in frame[] and return
+* the range of columns [*x0, *x1) that might have changed
+*/
+typedef void (*Animation)(uint8_t *frame, uint32_t n,
+                          uint32_t *x0, uint32_t *x1);
+
+/*..........................................................................*/
+/* the scrolling waveform of the QWIN demo (see main.c) */
+static void animWave(uint8_t *frame, uint32_t n,
+                     uint32_t *x0, uint32_t *x1)
+{
+    double const x = 3.1415926536/10.0 * n;
+    double const y = 0.5*(sin(x)*cos(0.1*x) + 1.0);
+    uint32_t const pixCol = (1U << (int)(y*(8U*SSD_EMU_PAGES - 1U) + 0.5));
+
+    memmove(frame, frame + 1U, FRAME_SIZE - 1U);
+    frame[SSD_EMU_WIDTH - 1U] = (uint8_t)pixCol;
+    frame[2U*SSD_EMU_WIDTH - 1U] = (uint8_t)(pixCol >> 8);
+    *x0 = 0U;
+    *x1 = SSD_EMU_WIDTH;
+}
+/*..........................................................................*/
+/* an 8x8 sprite bouncing over a static background */
+static void animSprite(uint8_t *frame, uint32_t n,
+                       uint32_t *x0, uint32_t *x1)
+{
+    static uint8_t const sprite[8] = {
+        0x3CU, 0x42U, 0xA5U, 0x81U, 0xA5U, 0x99U, 0x42U, 0x3CU
+    };
+    uint32_t const range = SSD_EMU_WIDTH - 8U;
+    uint32_t const x = ((n / range) & 1U) ? (range - n % range) : n % range;
+    uint32_t const y = (n / 3U) % 9U; /* scan line of the top of the sprite */
+    uint32_t i;
+
+    for (i = 0U; i < SSD_EMU_WIDTH; ++i) { /* background: two rails */
+        frame[i] = (uint8_t)(((i & 3U) == 0U) ? 0x01U : 0x00U);
+        frame[SSD_EMU_WIDTH + i] = 0x80U;
+    }
+    for (i = 0U; i < 8U; ++i) {
+        uint32_t const col = (uint32_t)sprite[i] << y;
+        frame[x + i] |= (uint8_t)col;
+        frame[SSD_EMU_WIDTH + x + i] |= (uint8_t)(col >> 8);
+    }
+    if (n == 0U) { /* the background is new? */
+        *x0 = 0U;
+        *x1 = SSD_EMU_WIDTH;
+    }
+    else { /* the old sprite is at most 1 column away */
+        *x0 = (x != 0U) ? (x - 1U) : 0U;
+        *x1 = (x + 9U < SSD_EMU_WIDTH) ? (x + 9U) : SSD_EMU_WIDTH;
+    }
+}
+/*..........................................................................*/
+/* a few random bytes changed in random places, exercises the spans */
+static void animRandom(uint8_t *frame, uint32_t n,
+                       uint32_t *x0, uint32_t *x1)
+{
+    uint32_t seed = (n + 1U) * 2654435761U;
+    uint32_t k = (n % 7U) + 1U;
+    *x0 = SSD_EMU_WIDTH;
+    *x1 = 0U;
+    for (; k != 0U; --k) {
+        uint32_t i;
+        seed = seed * 1103515245U + 12345U;
+        i = (seed >> 8) % FRAME_SIZE;
+        frame[i] = (uint8_t)(seed >> 24);
+        if (*x0 > i % SSD_EMU_WIDTH) {
+            *x0 = i % SSD_EMU_WIDTH;
+        }
+        if (*x1 < i % SSD_EMU_WIDTH + 1U) {
+            *x1 = i % SSD_EMU_WIDTH + 1U;
+        }
+    }
+}
+
+/*..........................................................................*/
+enum DrawMethod {
+    DRAW_IMAGE,     /* Display96x16x1ImageDraw() of the whole frame */
+    DRAW_COLUMNS,   /* Display96x16x1ImageColumnsDraw() of the changed range */
+    DRAW_UPDATE     /* Display96x16x1ImageUpdate() of the changed columns */
+};
+
+static char const * const l_methodName[] = { "image", "columns", "update" };
+
+/*..........................................................................*/
+/* run the animation for the given number of frames and return the number
+* of the wrong frames shown on the display
+*/
+static uint32_t run(int isRIT, Animation anim, int method, uint32_t nFrames)
+{
+    static uint8_t frame[FRAME_SIZE];
+    static uint8_t shown[FRAME_SIZE];
+    uint32_t bad = 0U;
+    uint32_t n;
+
+    SSDEmu_reset(isRIT);
+    Display96x16x1Init(1); /* clears the display */
+    memset(frame, 0, sizeof(frame));
+    memcpy(shown, frame, sizeof(shown));
+    if (SSDEmu_check(frame) != 0U) {
+        ++bad;
+    }
+    SSDEmu_clearStats(); /* count only the animation */
+    for (n = 0U; n < nFrames; ++n) {
+        uint32_t x0;
+        uint32_t x1;
+        (*anim)(frame, n, &x0, &x1);
+        switch (method) {
+            case DRAW_IMAGE:
+                Display96x16x1ImageDraw(frame, 0, 0,
+                                        SSD_EMU_WIDTH, SSD_EMU_PAGES);
+                break;
+            case DRAW_COLUMNS:
+                if (x1 > x0) {
+                    Display96x16x1ImageColumnsDraw(frame, 0, 0,
+                        SSD_EMU_WIDTH, SSD_EMU_PAGES, x0, x1 - x0);
+                }
+                break;
+            default:
+                Display96x16x1ImageUpdate(frame, shown, 0, 0,
+                                          SSD_EMU_WIDTH, SSD_EMU_PAGES);
+                break;
+        }
+        if (SSDEmu_check(frame) != 0U) {
+            ++bad;
+        }
+    }
+    return bad;
+}
+
+/*..........................................................................*/
+int main(int argc, char *argv[]) {
+    static struct {
+        char const *name;
+        Animation   anim;
+    } const anims[] = {
+        { "wave",   &animWave   },
+        { "sprite", &animSprite },
+        { "random", &animRandom }
+    };
+    uint32_t nFrames = 1000U;
+    int firstPanel = 0;
+    int lastPanel  = 1;
+    int failed = 0;
+    int panel;
+    int i;
+
+    for (i = 1; i < argc; ++i) {
+        if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc)) {
+            nFrames = (uint32_t)strtoul(argv[++i], (char **)0, 10);
+        }
+        else if (strcmp(argv[i], "-o") == 0) { /* OSRAM only */
+            firstPanel = 0;
+            lastPanel  = 0;
+        }
+        else if (strcmp(argv[i], "-r") == 0) { /* RIT only */
+            firstPanel = 1;
+            lastPanel  = 1;
+        }
+        else {
+            fprintf(stderr, "usage: %s [-n frames] [-o | -r]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (nFrames == 0U) {
+        nFrames = 1U;
+    }
+
+    for (panel = firstPanel; panel <= lastPanel; ++panel) {
+        printf("%s panel, %u frames\n",
+               (panel != 0) ? "RIT/SSD1300" : "OSRAM/SSD0303",
+               (unsigned)nFrames);
+        printf("%-8s %-8s %12s %12s %12s %8s %6s\n", "anim", "method",
+               "bytes/frame", "xfers/frame", "us/frame", "saving", "bad");
+        for (i = 0; i < (int)(sizeof(anims)/sizeof(anims[0])); ++i) {
+            double fullTime = 0.0;
+            int method;
+            for (method = DRAW_IMAGE; method <= DRAW_UPDATE; ++method) {
+                uint32_t const bad = run(panel, anims[i].anim, method,
+                                         nFrames);
+                double const t = SSDEmu_busTime() / nFrames;
+                if (method == DRAW_IMAGE) {
+                    fullTime = t;
+                }
+                printf("%-8s %-8s %12.1f %12.2f %12.1f %7.1f%% %6u\n",
+                       anims[i].name, l_methodName[method],
+                       (double)SSDEmu_stats.bytes / nFrames,
+                       (double)SSDEmu_stats.transfers / nFrames,
+                       t, 100.0 * (1.0 - t / fullTime), (unsigned)bad);
+                if ((bad != 0U) || (SSDEmu_stats.errors != 0U)) {
+                    printf("FAILED: %u wrong frames, %u protocol errors\n",
+                           (unsigned)bad, (unsigned)SSDEmu_stats.errors);
+                    failed = 1;
+                }
+            }
+        }
+        printf("\n");
+    }
+    return failed;
+}
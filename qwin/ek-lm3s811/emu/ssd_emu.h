@@ -0,0 +1,131 @@
+/**
+* @file
+* @brief Host-side emulation of the EK-LM3S811 OLED display (SSD0303/SSD1300)
+* @cond
+******************************************************************************
+* Last updated for version 6.9.3
+* Last updated on  2021-03-03
+*
+*                    Q u a n t u m  L e a P s
+*                    ------------------------
+*                    Modern Embedded Software
+*
+* Copyright (C) 2021 Quantum Leaps, LLC. All rights reserved.
+*
+* MIT License:
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* Contact information:
+* <www.state-machine.com>
+* <info@state-machine.com>
+******************************************************************************
+* @endcond
+*/
+#ifndef SSD_EMU_H_
+#define SSD_EMU_H_
+
+#include <stdint.h>
+
+/* NOTE: this header replaces "LM3S811.h" when the TI display driver
+* (display96x16x1.c) is compiled on the host with SSD_EMU defined. It
+* provides the few LM3S811 registers used by the driver, where the I2C
+* master is connected to an emulated display controller. The controller
+* decodes the I2C command stream like the SSD0303 (OSRAM) or the SSD1300
+* (RIT) and keeps its own display RAM, so that the pixels can be verified
+* and the bus traffic can be measured without the hardware.
+*/
+
+typedef struct {
+    uint32_t RCGC1;
+    uint32_t RCGC2;
+    uint32_t DID1;
+} SSDEmu_SysCtl;
+
+typedef struct {
+    uint32_t DIR;
+    uint32_t AFSEL;
+    uint32_t DR2R;
+    uint32_t SLR;
+    uint32_t ODR;
+    uint32_t PUR;
+    uint32_t DEN;
+    uint32_t AMSEL;
+    uint32_t DATA_Bits[256];
+} SSDEmu_Gpio;
+
+typedef struct {
+    uint32_t MSA;
+    uint32_t MCS;
+    uint32_t MDR;
+    uint32_t MTPR;
+    uint32_t MRIS;
+    uint32_t MCR;
+} SSDEmu_I2CMaster;
+
+extern SSDEmu_SysCtl SSDEmu_sysctl;
+extern SSDEmu_Gpio   SSDEmu_gpiob;
+extern SSDEmu_Gpio   SSDEmu_gpiod;
+extern uint32_t      SystemCoreClock;
+
+/* The writes to the MDR and MCS registers can't be intercepted directly,
+* so every access to the I2C master goes through SSDEmu_i2c(), which first
+* delivers the byte written by the previous MCS command to the controller.
+* The driver always polls MRIS after writing MCS, so no byte is missed.
+*/
+SSDEmu_I2CMaster *SSDEmu_i2c(void);
+
+#define SYSCTL       (&SSDEmu_sysctl)
+#define GPIOB        (&SSDEmu_gpiob)
+#define GPIOD        (&SSDEmu_gpiod)
+#define I2C0_MASTER  (SSDEmu_i2c())
+
+/* the busy-wait loop of the driver (3 CPU cycles per iteration) */
+void SSDEmu_delay(uint32_t ulCount);
+
+/* the displayed area of the panel */
+#define SSD_EMU_WIDTH  96U
+#define SSD_EMU_PAGES  2U
+
+/* bus traffic counted since the last SSDEmu_reset() or SSDEmu_clearStats() */
+typedef struct {
+    uint32_t bytes;      /* bytes on the bus, including the slave address */
+    uint32_t transfers;  /* I2C transfers (START...STOP) */
+    uint32_t delayLoops; /* iterations of the inter-byte delay loop */
+    uint32_t errors;     /* protocol errors and writes outside the panel */
+} SSDEmuStats;
+
+extern SSDEmuStats SSDEmu_stats;
+
+/* power-on reset of the emulated panel: RIT/SSD1300 (isRIT != 0)
+* or OSRAM/SSD0303 (isRIT == 0)
+*/
+void SSDEmu_reset(int isRIT);
+
+void SSDEmu_clearStats(void);
+
+/* compare the displayed area with the image organized as for
+* Display96x16x1ImageDraw(), returns the number of differing columns
+*/
+uint32_t SSDEmu_check(uint8_t const *image);
+
+/* the estimated bus time [us] of the traffic in SSDEmu_stats */
+double SSDEmu_busTime(void);
+
+#endif /* SSD_EMU_H_ */
@@ -44,6 +44,9 @@
 static HWND l_hWnd;
 static HDC  l_hDC;
 
+static void GraphicDisplay_buildLut(GraphicDisplay * const me,
+                                    BYTE const color[3]);
+
 /*--------------------------------------------------------------------------*/
 HWND CreateCustDialog(HINSTANCE hInst, int iDlg, HWND hParent,
                       WNDPROC lpfnWndProc, LPCTSTR lpWndClass)
@@ -150,7 +153,7 @@ BOOL OwnerDrawnButton_isDepressed(OwnerDrawnButton const * const me) {
 }
 
 /*--------------------------------------------------------------------------*/
-void GraphicDisplay_init(GraphicDisplay * const me,
+BOOL GraphicDisplay_init(GraphicDisplay * const me,
                          UINT width,  UINT height,
                          UINT itemID, BYTE const bgColor[3])
 {
@@ -170,6 +173,18 @@ void GraphicDisplay_init(GraphicDisplay * const me,
     me->bgColor[1] = bgColor[1];
     me->bgColor[2] = bgColor[2];
 
+    me->lut = (BYTE (*)[8*3])malloc(256U * sizeof(me->lut[0]));
+    if (me->lut == (BYTE (*)[8*3])0) {
+        ReleaseDC(me->hItem, me->dst_hDC);
+        return FALSE;
+    }
+    GraphicDisplay_buildLut(me, bgColor);
+
+    me->dirty.left   = me->src_width; /* nothing dirty yet */
+    me->dirty.top    = me->src_height;
+    me->dirty.right  = 0;
+    me->dirty.bottom = 0;
+
     bi24BitInfo.bmiHeader.biBitCount    = 3U*8U;  /* 3 RGB bytes */
     bi24BitInfo.bmiHeader.biCompression = BI_RGB; /* RGB color */
     bi24BitInfo.bmiHeader.biPlanes      = 1U;
@@ -180,15 +195,24 @@ void GraphicDisplay_init(GraphicDisplay * const me,
     me->src_hDC = CreateCompatibleDC(me->dst_hDC);
     me->hBitmap = CreateDIBSection(me->src_hDC, &bi24BitInfo, DIB_RGB_COLORS,
                                    (void **)&me->bits, 0, 0);
+    if (me->hBitmap == (HBITMAP)0) {
+        DeleteDC(me->src_hDC);
+        ReleaseDC(me->hItem, me->dst_hDC);
+        free(me->lut);
+        me->lut = (BYTE (*)[8*3])0;
+        return FALSE;
+    }
     SelectObject(me->src_hDC, me->hBitmap);
 
     GraphicDisplay_clear(me);
     GraphicDisplay_redraw(me);
+    return TRUE;
 }
 /*..........................................................................*/
 void GraphicDisplay_xtor(GraphicDisplay * const me) {
     DeleteDC(me->src_hDC);
     DeleteObject(me->hBitmap);
+    free(me->lut);
     OutputDebugString("GraphicDisplay_xtor\n");
 }
 /*..........................................................................*/
@@ -204,11 +228,129 @@ void GraphicDisplay_clear(GraphicDisplay * const me) {
         bits[1] = g;
         bits[2] = r;
     }
+    GraphicDisplay_invalidate(me, 0U, 0U,
+                              (UINT)me->src_width, (UINT)me->src_height);
 }
 /*..........................................................................*/
 void GraphicDisplay_redraw(GraphicDisplay * const me) {
+    RECT const *r = &me->dirty;
+
+    if ((r->left >= r->right) || (r->top >= r->bottom)) {
+        return; /* nothing changed since the last redraw */
+    }
+    /* only the dirty rectangle can be stretched exactly for integer scale */
+    if (((me->dst_width % me->src_width) == 0)
+        && ((me->dst_height % me->src_height) == 0))
+    {
+        int const sx = me->dst_width  / me->src_width;
+        int const sy = me->dst_height / me->src_height;
+        StretchBlt(me->dst_hDC, (int)r->left * sx, (int)r->top * sy,
+                   (int)(r->right - r->left) * sx,
+                   (int)(r->bottom - r->top) * sy,
+                   me->src_hDC, (int)r->left, (int)r->top,
+                   (int)(r->right - r->left), (int)(r->bottom - r->top),
+                   SRCCOPY);
+    }
+    else {
+        StretchBlt(me->dst_hDC, 0, 0, me->dst_width, me->dst_height,
+                   me->src_hDC, 0, 0, me->src_width, me->src_height,
+                   SRCCOPY);
+    }
+    me->dirty.left   = me->src_width; /* nothing dirty */
+    me->dirty.top    = me->src_height;
+    me->dirty.right  = 0;
+    me->dirty.bottom = 0;
+}
+/*..........................................................................*/
+void GraphicDisplay_redrawAll(GraphicDisplay * const me) {
+    /* NOTE: the dirty rectangle is left for GraphicDisplay_redraw(),
+    * which runs in the application thread
+    */
     StretchBlt(me->dst_hDC, 0, 0, me->dst_width, me->dst_height,
-               me->src_hDC, 0, 0, me->src_width, me->src_height, SRCCOPY);
+               me->src_hDC, 0, 0, me->src_width, me->src_height,
+               SRCCOPY);
+}
+/*..........................................................................*/
+void GraphicDisplay_invalidate(GraphicDisplay * const me,
+                               UINT x, UINT y, UINT width, UINT height)
+{
+    if ((LONG)x < me->dirty.left) {
+        me->dirty.left = (LONG)x;
+    }
+    if ((LONG)(x + width) > me->dirty.right) {
+        me->dirty.right = (LONG)(x + width);
+    }
+    if ((LONG)y < me->dirty.top) {
+        me->dirty.top = (LONG)y;
+    }
+    if ((LONG)(y + height) > me->dirty.bottom) {
+        me->dirty.bottom = (LONG)(y + height);
+    }
+}
+/*..........................................................................*/
+/* build the lookup table of the 8 pixels for every 1-bpp byte
+* (in the byte order used by the GraphicDisplay_setPixel() macros)
+*/
+static void GraphicDisplay_buildLut(GraphicDisplay * const me,
+                                    BYTE const color[3])
+{
+    UINT b, k;
+
+    for (b = 0U; b < 256U; ++b) {
+        BYTE *pix = me->lut[b];
+        for (k = 0U; k < 8U; ++k, pix += 3) {
+            BYTE const *c = ((b & (1U << k)) != 0U) ? color : me->bgColor;
+            pix[0] = c[0];
+            pix[1] = c[1];
+            pix[2] = c[2];
+        }
+    }
+    me->lutColor[0] = color[0];
+    me->lutColor[1] = color[1];
+    me->lutColor[2] = color[2];
+}
+/*..........................................................................*/
+void GraphicDisplay_blit(GraphicDisplay * const me,
+                         UINT x, UINT page, UINT width, UINT nPages,
+                         BYTE const *bitmap, UINT stride,
+                         BYTE const color[3])
+{
+    UINT const rowBytes = 3U * (UINT)me->src_width;
+    UINT p, i, k;
+
+    if ((x >= (UINT)me->src_width) || (8U*page >= (UINT)me->src_height)) {
+        return; /* nothing to draw */
+    }
+    if (width > (UINT)me->src_width - x) {
+        width = (UINT)me->src_width - x;
+    }
+    if (nPages > ((UINT)me->src_height - 8U*page + 7U) / 8U) {
+        nPages = ((UINT)me->src_height - 8U*page + 7U) / 8U;
+    }
+    if ((me->lutColor[0] != color[0]) || (me->lutColor[1] != color[1])
+        || (me->lutColor[2] != color[2]))
+    {
+        GraphicDisplay_buildLut(me, color);
+    }
+
+    for (p = 0U; p < nPages; ++p) {
+        BYTE const *src = &bitmap[p * stride];
+        UINT const y = 8U * (page + p);
+        UINT const rows = ((UINT)me->src_height - y < 8U)
+                          ? ((UINT)me->src_height - y) : 8U;
+        /* NOTE: the rows of the bitmap are stored bottom-up */
+        BYTE *col = &me->bits[3U*x + rowBytes*((UINT)me->src_height - 1U - y)];
+        for (i = 0U; i < width; ++i, col += 3) {
+            BYTE const *pix = me->lut[src[i]]; /* 8 pixels at a time */
+            for (k = 0U; k < rows; ++k, pix += 3) {
+                BYTE *dst = col - k*rowBytes;
+                dst[0] = pix[0];
+                dst[1] = pix[1];
+                dst[2] = pix[2];
+            }
+        }
+    }
+    GraphicDisplay_invalidate(me, x, 8U*page, width, 8U*nPages);
 }
 
 /* SegmentDisplay ----------------------------------------------------------*/
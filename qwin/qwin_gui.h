@@ -45,8 +45,12 @@
     #error The pre-processor macro QWIN_GUI must be defined
 #endif
 
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>  /* Win32 API */
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>  /* Win32 API */
+#else
+    #include "qwin_posix.h" /* subset of Win32 API for POSIX hosts */
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -98,20 +102,42 @@ typedef struct {
     HBITMAP hBitmap;
     BYTE   *bits;
     BYTE    bgColor[3];
+    RECT    dirty;      /* changed pixels not redrawn yet (src coordinates) */
+    BYTE  (*lut)[8*3];  /* 1-bpp byte -> 8 pixels for GraphicDisplay_blit() */
+    BYTE    lutColor[3]; /* the foreground color of the lut */
 } GraphicDisplay;
 
-void GraphicDisplay_init(GraphicDisplay * const me,
+BOOL GraphicDisplay_init(GraphicDisplay * const me, /* FALSE: no memory */
                 UINT width,  UINT height,
                 UINT itemID, BYTE const bgColor[3]);
 void GraphicDisplay_xtor(GraphicDisplay * const me);
 void GraphicDisplay_clear(GraphicDisplay * const me);
 void GraphicDisplay_redraw(GraphicDisplay * const me);
+/* redraw the whole display regardless of the dirty rectangle (e.g., on
+* WM_PAINT, after the display has been covered by another window)
+*/
+void GraphicDisplay_redrawAll(GraphicDisplay * const me);
+void GraphicDisplay_invalidate(GraphicDisplay * const me,
+                UINT x, UINT y, UINT width, UINT height);
+
+/* draw the 1-bpp bitmap organized in "pages" (as in most monochrome
+* LCD/OLED controllers), where each byte holds 8 vertical pixels of one
+* column with the LSB on top. The bitmap has 'nPages' rows of 'width'
+* bytes, which are 'stride' bytes apart, and it is drawn to the column x
+* and the page row 'page' (pixel row 8*page). The set bits are drawn
+* in the color 'color' and the cleared bits in the background color.
+*/
+void GraphicDisplay_blit(GraphicDisplay * const me,
+                UINT x, UINT page, UINT width, UINT nPages,
+                BYTE const *bitmap, UINT stride, BYTE const color[3]);
+
 #define GraphicDisplay_setPixel(me_, x_, y_, color_) do { \
     BYTE *pixelRGB = &(me_)->bits[3*((x_) \
           + (me_)->src_width * ((me_)->src_height - 1U - (y_)))]; \
     pixelRGB[0] = (color_)[0]; \
     pixelRGB[1] = (color_)[1]; \
     pixelRGB[2] = (color_)[2]; \
+    GraphicDisplay_touch_((me_), (x_), (y_)); \
 } while (0)
 
 #define GraphicDisplay_clearPixel(me_, x_, y_) do { \
@@ -120,6 +146,23 @@ void GraphicDisplay_redraw(GraphicDisplay * const me);
     pixelRGB[0] = (me_)->bgColor[0]; \
     pixelRGB[1] = (me_)->bgColor[1]; \
     pixelRGB[2] = (me_)->bgColor[2]; \
+    GraphicDisplay_touch_((me_), (x_), (y_)); \
+} while (0)
+
+/* extend the dirty rectangle by the pixel (x_, y_) */
+#define GraphicDisplay_touch_(me_, x_, y_) do { \
+    if ((LONG)(x_) < (me_)->dirty.left) { \
+        (me_)->dirty.left = (LONG)(x_); \
+    } \
+    if ((LONG)(x_) >= (me_)->dirty.right) { \
+        (me_)->dirty.right = (LONG)(x_) + 1; \
+    } \
+    if ((LONG)(y_) < (me_)->dirty.top) { \
+        (me_)->dirty.top = (LONG)(y_); \
+    } \
+    if ((LONG)(y_) >= (me_)->dirty.bottom) { \
+        (me_)->dirty.bottom = (LONG)(y_) + 1; \
+    } \
 } while (0)
 
 /* SegmentDisplay "class" for drawing segment displays, LEDs, etc...........*/
@@ -0,0 +1,904 @@
+/**
+* @file
+* @brief QWIN GUI facilities for building realistic embedded front panels
+* (POSIX implementation rendering to an offscreen framebuffer)
+* @cond
+******************************************************************************
+* Last updated for version 6.9.3
+* Last updated on  2021-03-03
+*
+*                    Q u a n t u m  L e a P s
+*                    ------------------------
+*                    Modern Embedded Software
+*
+* Copyright (C) 2021 Quantum Leaps, LLC. All rights reserved.
+*
+* MIT License:
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* Contact information:
+* <www.state-machine.com>
+* <info@state-machine.com>
+******************************************************************************
+* @endcond
+*/
+#include "qwin_gui.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef QWIN_X11
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#endif
+
+#define TEXT_MARGIN 16 /* pixels around the texts redrawn with them */
+
+/* the dialog and its controls */
+struct QWinWnd {
+    int  id;
+    int  kind;     /* enum QWinItemKind */
+    int  x;        /* position relative to the dialog and size in pixels */
+    int  y;
+    int  width;
+    int  height;
+    char text[64];
+};
+
+/* bitmap with the rows stored bottom-up (as in Win32 DIBs), but with
+* the pixels in the R,G,B byte order and without any row padding
+*/
+struct QWinBitmap {
+    int   width;
+    int   height;
+    BYTE *bits;
+};
+
+static struct QWinWnd  l_dlg;       /* the dialog itself */
+static struct QWinWnd *l_items;     /* the dialog controls */
+static UINT            l_nItems;
+static HWND            l_hWnd;
+static WNDPROC         l_wndProc;
+static BYTE           *l_frame;     /* top-down RGB framebuffer */
+static RECT            l_frameDirty; /* changed part of the l_frame */
+static BOOL            l_quit;
+static char const     *l_caption;
+
+#ifdef QWIN_X11
+static Display        *l_display;
+static Window          l_window;
+static GC              l_gc;
+static XImage         *l_image;
+static Atom            l_wmDelete;
+static HWND            l_pressedItem; /* owner-drawn button held down */
+
+static void presentFrame(void);
+static void handleEvent(XEvent const *ev);
+#endif
+
+static void GraphicDisplay_buildLut(GraphicDisplay * const me,
+                                    BYTE const color[3]);
+
+/*--------------------------------------------------------------------------*/
+static void invalidateFrame(int x0, int y0, int x1, int y1) {
+    if (x0 < l_frameDirty.left) {
+        l_frameDirty.left = x0;
+    }
+    if (y0 < l_frameDirty.top) {
+        l_frameDirty.top = y0;
+    }
+    if (x1 > l_frameDirty.right) {
+        l_frameDirty.right = x1;
+    }
+    if (y1 > l_frameDirty.bottom) {
+        l_frameDirty.bottom = y1;
+    }
+}
+/*..........................................................................*/
+static HBITMAP createBitmap(int width, int height) {
+    HBITMAP hBitmap = (HBITMAP)malloc(sizeof(struct QWinBitmap));
+    if (hBitmap != (HBITMAP)0) {
+        hBitmap->width  = width;
+        hBitmap->height = height;
+        hBitmap->bits   = (BYTE *)calloc((size_t)width * (size_t)height, 3U);
+        if (hBitmap->bits == (BYTE *)0) {
+            free(hBitmap);
+            hBitmap = (HBITMAP)0;
+        }
+    }
+    return hBitmap;
+}
+/*..........................................................................*/
+static void drawItemMsg(HWND hItem, UINT action, UINT state) {
+    DRAWITEMSTRUCT dis;
+
+    dis.CtlType       = ODT_BUTTON;
+    dis.CtlID         = (UINT)hItem->id;
+    dis.itemID        = 0U;
+    dis.itemAction    = action;
+    dis.itemState     = state;
+    dis.hwndItem      = hItem;
+    dis.hDC           = hItem;
+    dis.rcItem.left   = 0;
+    dis.rcItem.top    = 0;
+    dis.rcItem.right  = hItem->width;
+    dis.rcItem.bottom = hItem->height;
+    SendMessage(l_hWnd, WM_DRAWITEM, (WPARAM)hItem->id, (LPARAM)&dis);
+}
+
+/*--------------------------------------------------------------------------*/
+HWND CreateCustDialog(HINSTANCE hInst, int iDlg, HWND hParent,
+                      WNDPROC lpfnWndProc, LPCTSTR lpWndClass)
+{
+    BYTE *pix;
+    UINT n;
+
+    (void)iDlg;       /* the dialog is specified by the template hInst */
+    (void)hParent;    /* unused parameter */
+    (void)lpWndClass; /* unused parameter */
+
+    l_dlg.id     = 0;
+    l_dlg.kind   = QWIN_STATIC;
+    l_dlg.x      = 0;
+    l_dlg.y      = 0;
+    l_dlg.width  = hInst->width;
+    l_dlg.height = hInst->height;
+    l_caption    = hInst->caption;
+    l_hWnd       = &l_dlg;
+    l_wndProc    = lpfnWndProc;
+
+    l_frame = (BYTE *)malloc((size_t)l_dlg.width * (size_t)l_dlg.height * 3U);
+    l_items = (struct QWinWnd *)calloc(hInst->nItems, sizeof(struct QWinWnd));
+    if ((l_frame == (BYTE *)0) || (l_items == (struct QWinWnd *)0)) {
+        return (HWND)0;
+    }
+    for (n = (UINT)(l_dlg.width * l_dlg.height), pix = l_frame; n != 0U;
+         --n, pix += 3)
+    {
+        pix[0] = hInst->bgColor[0];
+        pix[1] = hInst->bgColor[1];
+        pix[2] = hInst->bgColor[2];
+    }
+
+    l_frameDirty.left   = l_dlg.width; /* nothing dirty yet */
+    l_frameDirty.top    = l_dlg.height;
+    l_frameDirty.right  = 0;
+    l_frameDirty.bottom = 0;
+    invalidateFrame(0, 0, l_dlg.width, l_dlg.height);
+
+    l_nItems = hInst->nItems;
+    for (n = 0U; n < l_nItems; ++n) {
+        QWinItemTemplate const *it = &hInst->items[n];
+        l_items[n].id     = it->id;
+        l_items[n].kind   = it->kind;
+        l_items[n].x      = it->x;
+        l_items[n].y      = it->y;
+        l_items[n].width  = it->width;
+        l_items[n].height = it->height;
+        if (it->text != (char const *)0) { /* IDs of static texts repeat */
+            strncpy(l_items[n].text, it->text, sizeof(l_items[n].text) - 1U);
+        }
+        if (it->bitmap != (char const *)0) {
+            HBITMAP hBitmap = LoadBitmapFile(it->bitmap);
+            if (hBitmap != (HBITMAP)0) {
+                DrawBitmap(&l_items[n], hBitmap, 0, 0);
+                DeleteObject(hBitmap);
+            }
+        }
+    }
+
+    /* the same sequence of messages as the Win32 CreateDialog() */
+    SendMessage(l_hWnd, WM_CREATE, (WPARAM)0, (LPARAM)0);
+    SendMessage(l_hWnd, WM_INITDIALOG, (WPARAM)0, (LPARAM)0);
+    for (n = 0U; n < l_nItems; ++n) { /* paint the owner-drawn controls */
+        if (l_items[n].kind == QWIN_OWNERDRAW) {
+            drawItemMsg(&l_items[n], ODA_DRAWENTIRE, 0U);
+        }
+    }
+    return l_hWnd;
+}
+
+/*--------------------------------------------------------------------------*/
+HWND GetDlgItem(HWND hDlg, int id) {
+    UINT n;
+    (void)hDlg; /* only one dialog is supported */
+    for (n = 0U; n < l_nItems; ++n) {
+        if (l_items[n].id == id) {
+            return &l_items[n];
+        }
+    }
+    return (HWND)0;
+}
+/*..........................................................................*/
+BOOL SetDlgItemText(HWND hDlg, int id, LPCTSTR text) {
+    HWND hItem = GetDlgItem(hDlg, id);
+    if (hItem == (HWND)0) {
+        return FALSE;
+    }
+    strncpy(hItem->text, text, sizeof(hItem->text) - 1U);
+    hItem->text[sizeof(hItem->text) - 1U] = '\0';
+    /* NOTE: the text is drawn at the bottom of the control, but the glyphs
+    * can stick out of it, so the area around the control is redrawn too
+    */
+    invalidateFrame(hItem->x, (hItem->y > TEXT_MARGIN)
+                               ? (hItem->y - TEXT_MARGIN) : 0,
+                    (hItem->x + hItem->width + TEXT_MARGIN < l_dlg.width)
+                        ? (hItem->x + hItem->width + TEXT_MARGIN)
+                        : l_dlg.width,
+                    (hItem->y + hItem->height + TEXT_MARGIN < l_dlg.height)
+                        ? (hItem->y + hItem->height + TEXT_MARGIN)
+                        : l_dlg.height);
+    return TRUE;
+}
+/*..........................................................................*/
+LRESULT SendMessage(HWND hWnd, UINT iMsg, WPARAM wParam, LPARAM lParam) {
+    return (*l_wndProc)(hWnd, iMsg, wParam, lParam);
+}
+/*..........................................................................*/
+void PostQuitMessage(int exitCode) {
+    (void)exitCode; /* the exit code is returned by the application */
+    l_quit = TRUE;
+}
+/*..........................................................................*/
+BOOL DeleteObject(HBITMAP hBitmap) {
+    if (hBitmap != (HBITMAP)0) {
+        free(hBitmap->bits);
+        free(hBitmap);
+    }
+    return TRUE;
+}
+/*..........................................................................*/
+BOOL ShowWindow(HWND hWnd, int iCmdShow) {
+#ifdef QWIN_X11
+    int scr;
+    Visual *vis;
+    char *data;
+
+    (void)hWnd;     /* only one dialog is supported */
+    (void)iCmdShow; /* unused parameter */
+
+    l_display = XOpenDisplay((char *)0);
+    if (l_display == (Display *)0) {
+        return FALSE;
+    }
+    scr = DefaultScreen(l_display);
+    vis = DefaultVisual(l_display, scr);
+    if (DefaultDepth(l_display, scr) < 24) { /* only TrueColor supported */
+        XCloseDisplay(l_display);
+        l_display = (Display *)0;
+        return FALSE;
+    }
+    data = (char *)malloc((size_t)l_dlg.width * (size_t)l_dlg.height * 4U);
+    if (data == (char *)0) {
+        XCloseDisplay(l_display);
+        l_display = (Display *)0;
+        return FALSE;
+    }
+    l_image = XCreateImage(l_display, vis, (unsigned)DefaultDepth(l_display,
+                           scr), ZPixmap, 0, data,
+                           (unsigned)l_dlg.width, (unsigned)l_dlg.height,
+                           32, 0);
+    l_window = XCreateSimpleWindow(l_display, RootWindow(l_display, scr),
+                           0, 0, (unsigned)l_dlg.width,
+                           (unsigned)l_dlg.height, 0,
+                           BlackPixel(l_display, scr),
+                           BlackPixel(l_display, scr));
+    XStoreName(l_display, l_window, l_caption);
+    XSelectInput(l_display, l_window, ExposureMask | KeyPressMask
+                 | ButtonPressMask | ButtonReleaseMask);
+    l_wmDelete = XInternAtom(l_display, "WM_DELETE_WINDOW", False);
+    XSetWMProtocols(l_display, l_window, &l_wmDelete, 1);
+    l_gc = XCreateGC(l_display, l_window, 0UL, (XGCValues *)0);
+    XSetForeground(l_display, l_gc, BlackPixel(l_display, scr));
+    XMapWindow(l_display, l_window);
+    invalidateFrame(0, 0, l_dlg.width, l_dlg.height);
+    presentFrame();
+    return TRUE;
+#else
+    (void)hWnd;     /* unused parameter */
+    (void)iCmdShow; /* unused parameter */
+    return FALSE;   /* no display support compiled in (headless) */
+#endif
+}
+/*..........................................................................*/
+BOOL DispatchMessages(void) {
+#ifdef QWIN_X11
+    if (l_display != (Display *)0) {
+        while (XPending(l_display) > 0) {
+            XEvent ev;
+            XNextEvent(l_display, &ev);
+            handleEvent(&ev);
+        }
+        presentFrame();
+    }
+#endif
+    return !l_quit;
+}
+/*..........................................................................*/
+BOOL SaveFrame(char const *fileName) {
+    FILE *f = fopen(fileName, "wb");
+    size_t const size = (size_t)l_dlg.width * (size_t)l_dlg.height * 3U;
+    BOOL ok;
+
+    if (f == (FILE *)0) {
+        return FALSE;
+    }
+    fprintf(f, "P6\n%d %d\n255\n", l_dlg.width, l_dlg.height);
+    ok = (fwrite(l_frame, 1U, size, f) == size);
+    return (fclose(f) == 0) && ok;
+}
+/*..........................................................................*/
+HBITMAP LoadBitmapFile(char const *fileName) {
+    BYTE hdr[54];
+    FILE *f = fopen(fileName, "rb");
+    HBITMAP hBitmap = (HBITMAP)0;
+    BYTE *row = (BYTE *)0;
+    long offset, width, height, stride;
+    int bpp, y;
+
+    if (f == (FILE *)0) {
+        return (HBITMAP)0;
+    }
+    if ((fread(hdr, 1U, sizeof(hdr), f) != sizeof(hdr))
+        || (hdr[0] != 'B') || (hdr[1] != 'M'))
+    {
+        fclose(f);
+        return (HBITMAP)0;
+    }
+#define LE32_(p_) ((uint32_t)(p_)[0] | ((uint32_t)(p_)[1] << 8) \
+                   | ((uint32_t)(p_)[2] << 16) | ((uint32_t)(p_)[3] << 24))
+    offset = (long)LE32_(&hdr[10]);
+    width  = (long)(int32_t)LE32_(&hdr[18]);
+    height = (long)(int32_t)LE32_(&hdr[22]); /* negative for top-down */
+    bpp    = hdr[28] | (hdr[29] << 8);
+    if ((width <= 0L) || (height == 0L) || ((bpp != 24) && (bpp != 32))
+        || (LE32_(&hdr[30]) != 0U)) /* not BI_RGB (compressed)? */
+    {
+        fclose(f);
+        return (HBITMAP)0;
+    }
+#undef LE32_
+    stride  = ((width * bpp + 31L) / 32L) * 4L; /* rows padded to 4 bytes */
+    hBitmap = createBitmap((int)width, (int)((height < 0L) ? -height : height));
+    row     = (BYTE *)malloc((size_t)stride);
+    if ((hBitmap == (HBITMAP)0) || (row == (BYTE *)0)
+        || (fseek(f, offset, SEEK_SET) != 0))
+    {
+        DeleteObject(hBitmap);
+        free(row);
+        fclose(f);
+        return (HBITMAP)0;
+    }
+    for (y = 0; y < hBitmap->height; ++y) {
+        /* the file rows are bottom-up, unless the height is negative */
+        int const dy = (height > 0L) ? y : (hBitmap->height - 1 - y);
+        BYTE *dst = &hBitmap->bits[(size_t)dy * (size_t)width * 3U];
+        BYTE const *src = row;
+        long x;
+        if (fread(row, 1U, (size_t)stride, f) != (size_t)stride) {
+            DeleteObject(hBitmap);
+            hBitmap = (HBITMAP)0;
+            break;
+        }
+        for (x = 0L; x < width; ++x, dst += 3, src += bpp / 8) {
+            dst[0] = src[2]; /* B,G,R -> R,G,B */
+            dst[1] = src[1];
+            dst[2] = src[0];
+        }
+    }
+    free(row);
+    fclose(f);
+    return hBitmap;
+}
+
+/*--------------------------------------------------------------------------*/
+void OwnerDrawnButton_init(OwnerDrawnButton * const me,
+                           UINT itemID,
+                           HBITMAP hBitmapUp, HBITMAP hBitmapDwn,
+                           HCURSOR hCursor)
+{
+    me->itemID      = itemID;
+    me->hBitmapUp   = hBitmapUp;
+    me->hBitmapDown = hBitmapDwn;
+    me->hCursor     = hCursor;
+    me->isDepressed = 0;
+}
+/*..........................................................................*/
+void OwnerDrawnButton_xtor(OwnerDrawnButton * const me) {
+    DeleteObject(me->hBitmapUp);
+    DeleteObject(me->hBitmapDown);
+}
+/*..........................................................................*/
+enum OwnerDrawnButtonAction OwnerDrawnButton_draw(
+                               OwnerDrawnButton * const me,
+                               LPDRAWITEMSTRUCT lpdis)
+{
+    enum OwnerDrawnButtonAction ret = BTN_NOACTION;
+
+    if ((lpdis->itemAction & ODA_DRAWENTIRE) != 0U) {
+        DrawBitmap(lpdis->hDC, me->hBitmapUp,
+                   lpdis->rcItem.left, lpdis->rcItem.top);
+        me->isDepressed = 0;
+        ret = BTN_PAINTED;
+    }
+    else if ((lpdis->itemAction & ODA_SELECT) != 0U) {
+        if ((lpdis->itemState & ODS_SELECTED) != 0U) {
+            DrawBitmap(lpdis->hDC, me->hBitmapDown,
+                       lpdis->rcItem.left, lpdis->rcItem.top);
+            me->isDepressed = !0;
+            ret = BTN_DEPRESSED;
+        }
+        else {
+            /* NOTE: the bitmap for button "UP" look will be
+            * drawn in the ODA_DRAWENTIRE action
+            */
+            me->isDepressed = 0;
+            ret = BTN_RELEASED;
+        }
+    }
+    return ret;
+}
+/*..........................................................................*/
+void OwnerDrawnButton_set(OwnerDrawnButton * const me, int isDepressed) {
+    if (me->isDepressed != isDepressed) {
+        HWND hItem = GetDlgItem(l_hWnd, (int)me->itemID);
+        me->isDepressed = isDepressed;
+        if (isDepressed) {
+            DrawBitmap(hItem, me->hBitmapDown, 0, 0);
+        }
+        else {
+            DrawBitmap(hItem, me->hBitmapUp, 0, 0);
+        }
+    }
+}
+/*..........................................................................*/
+BOOL OwnerDrawnButton_isDepressed(OwnerDrawnButton const * const me) {
+    return me->isDepressed;
+}
+
+/*--------------------------------------------------------------------------*/
+BOOL GraphicDisplay_init(GraphicDisplay * const me,
+                         UINT width,  UINT height,
+                         UINT itemID, BYTE const bgColor[3])
+{
+    me->src_width  = (int)width;
+    me->src_height = (int)height;
+
+    me->hItem      = GetDlgItem(l_hWnd, (int)itemID);
+    me->dst_hDC    = me->hItem;
+    me->dst_width  = me->hItem->width;
+    me->dst_height = me->hItem->height;
+    me->src_hDC    = (HDC)0;
+
+    me->bgColor[0] = bgColor[0];
+    me->bgColor[1] = bgColor[1];
+    me->bgColor[2] = bgColor[2];
+
+    me->lut = (BYTE (*)[8*3])malloc(256U * sizeof(me->lut[0]));
+    if (me->lut == (BYTE (*)[8*3])0) {
+        return FALSE;
+    }
+    GraphicDisplay_buildLut(me, bgColor);
+
+    me->dirty.left   = me->src_width; /* nothing dirty yet */
+    me->dirty.top    = me->src_height;
+    me->dirty.right  = 0;
+    me->dirty.bottom = 0;
+
+    me->hBitmap = createBitmap(me->src_width, me->src_height);
+    if (me->hBitmap == (HBITMAP)0) {
+        free(me->lut);
+        me->lut = (BYTE (*)[8*3])0;
+        return FALSE;
+    }
+    me->bits    = me->hBitmap->bits;
+
+    GraphicDisplay_clear(me);
+    GraphicDisplay_redraw(me);
+    return TRUE;
+}
+/*..........................................................................*/
+void GraphicDisplay_xtor(GraphicDisplay * const me) {
+    DeleteObject(me->hBitmap);
+    free(me->lut);
+}
+/*..........................................................................*/
+void GraphicDisplay_clear(GraphicDisplay * const me) {
+    UINT n;
+    BYTE r = me->bgColor[0];
+    BYTE g = me->bgColor[1];
+    BYTE b = me->bgColor[2];
+    BYTE *bits = me->bits;
+
+    for (n = (UINT)(me->src_width * me->src_height); n != 0U;
+         --n, bits += 3)
+    {
+        bits[0] = r;
+        bits[1] = g;
+        bits[2] = b;
+    }
+    GraphicDisplay_invalidate(me, 0U, 0U,
+                              (UINT)me->src_width, (UINT)me->src_height);
+}
+/*..........................................................................*/
+void GraphicDisplay_redrawAll(GraphicDisplay * const me) {
+    GraphicDisplay_invalidate(me, 0U, 0U,
+                              (UINT)me->src_width, (UINT)me->src_height);
+    GraphicDisplay_redraw(me);
+}
+/*..........................................................................*/
+void GraphicDisplay_redraw(GraphicDisplay * const me) {
+    HWND const hItem = me->hItem;
+    RECT const *r = &me->dirty;
+    int x0, x1, y0, y1, x, y;
+
+    if ((r->left >= r->right) || (r->top >= r->bottom)) {
+        return; /* nothing changed since the last redraw */
+    }
+    /* the control pixels, whose nearest source pixels are dirty */
+    x0 = (int)((r->left   * me->dst_width + me->src_width - 1)
+               / me->src_width);
+    x1 = (int)((r->right  * me->dst_width + me->src_width - 1)
+               / me->src_width);
+    y0 = (int)((r->top    * me->dst_height + me->src_height - 1)
+               / me->src_height);
+    y1 = (int)((r->bottom * me->dst_height + me->src_height - 1)
+               / me->src_height);
+
+    /* stretch the bitmap to the control (nearest neighbor), where the
+    * control rows stretched from the same source row are just copied
+    */
+    for (y = y0; y < y1; ++y) {
+        int const sy = (y * me->src_height) / me->dst_height;
+        BYTE *dst = &l_frame[(((size_t)(hItem->y + y) * (size_t)l_dlg.width)
+                              + (size_t)(hItem->x + x0)) * 3U];
+        if ((y > y0) && (sy == ((y - 1) * me->src_height) / me->dst_height)) {
+            memcpy(dst, dst - (size_t)l_dlg.width * 3U,
+                   (size_t)(x1 - x0) * 3U);
+        }
+        else {
+            BYTE const *pix = &me->bits[(((size_t)(me->src_height - 1 - sy)
+                                          * (size_t)me->src_width)
+                                         + (size_t)((x0 * me->src_width)
+                                                    / me->dst_width)) * 3U];
+            int acc = (x0 * me->src_width) % me->dst_width;
+            for (x = x0; x < x1; ++x, dst += 3) {
+                dst[0] = pix[0];
+                dst[1] = pix[1];
+                dst[2] = pix[2];
+                for (acc += me->src_width; acc >= me->dst_width;
+                     acc -= me->dst_width)
+                {
+                    pix += 3; /* next source pixel */
+                }
+            }
+        }
+    }
+    invalidateFrame(hItem->x + x0, hItem->y + y0,
+                    hItem->x + x1, hItem->y + y1);
+
+    me->dirty.left   = me->src_width; /* nothing dirty */
+    me->dirty.top    = me->src_height;
+    me->dirty.right  = 0;
+    me->dirty.bottom = 0;
+}
+/*..........................................................................*/
+void GraphicDisplay_invalidate(GraphicDisplay * const me,
+                               UINT x, UINT y, UINT width, UINT height)
+{
+    if ((LONG)x < me->dirty.left) {
+        me->dirty.left = (LONG)x;
+    }
+    if ((LONG)(x + width) > me->dirty.right) {
+        me->dirty.right = (LONG)(x + width);
+    }
+    if ((LONG)y < me->dirty.top) {
+        me->dirty.top = (LONG)y;
+    }
+    if ((LONG)(y + height) > me->dirty.bottom) {
+        me->dirty.bottom = (LONG)(y + height);
+    }
+}
+/*..........................................................................*/
+/* build the lookup table of the 8 pixels for every 1-bpp byte
+* (in the byte order used by the GraphicDisplay_setPixel() macros)
+*/
+static void GraphicDisplay_buildLut(GraphicDisplay * const me,
+                                    BYTE const color[3])
+{
+    UINT b, k;
+
+    for (b = 0U; b < 256U; ++b) {
+        BYTE *pix = me->lut[b];
+        for (k = 0U; k < 8U; ++k, pix += 3) {
+            BYTE const *c = ((b & (1U << k)) != 0U) ? color : me->bgColor;
+            pix[0] = c[0];
+            pix[1] = c[1];
+            pix[2] = c[2];
+        }
+    }
+    me->lutColor[0] = color[0];
+    me->lutColor[1] = color[1];
+    me->lutColor[2] = color[2];
+}
+/*..........................................................................*/
+void GraphicDisplay_blit(GraphicDisplay * const me,
+                         UINT x, UINT page, UINT width, UINT nPages,
+                         BYTE const *bitmap, UINT stride,
+                         BYTE const color[3])
+{
+    UINT const rowBytes = 3U * (UINT)me->src_width;
+    UINT p, i, k;
+
+    if ((x >= (UINT)me->src_width) || (8U*page >= (UINT)me->src_height)) {
+        return; /* nothing to draw */
+    }
+    if (width > (UINT)me->src_width - x) {
+        width = (UINT)me->src_width - x;
+    }
+    if (nPages > ((UINT)me->src_height - 8U*page + 7U) / 8U) {
+        nPages = ((UINT)me->src_height - 8U*page + 7U) / 8U;
+    }
+    if ((me->lutColor[0] != color[0]) || (me->lutColor[1] != color[1])
+        || (me->lutColor[2] != color[2]))
+    {
+        GraphicDisplay_buildLut(me, color);
+    }
+
+    for (p = 0U; p < nPages; ++p) {
+        BYTE const *src = &bitmap[p * stride];
+        UINT const y = 8U * (page + p);
+        UINT const rows = ((UINT)me->src_height - y < 8U)
+                          ? ((UINT)me->src_height - y) : 8U;
+        /* NOTE: the rows of the bitmap are stored bottom-up */
+        BYTE *col = &me->bits[3U*x + rowBytes*((UINT)me->src_height - 1U - y)];
+        for (i = 0U; i < width; ++i, col += 3) {
+            BYTE const *pix = me->lut[src[i]]; /* 8 pixels at a time */
+            for (k = 0U; k < rows; ++k, pix += 3) {
+                BYTE *dst = col - k*rowBytes;
+                dst[0] = pix[0];
+                dst[1] = pix[1];
+                dst[2] = pix[2];
+            }
+        }
+    }
+    GraphicDisplay_invalidate(me, x, 8U*page, width, 8U*nPages);
+}
+
+/* SegmentDisplay ----------------------------------------------------------*/
+void SegmentDisplay_init(SegmentDisplay * const me,
+                         UINT segmentNum, UINT bitmapNum)
+{
+    me->hSegment   = (HWND *)calloc(segmentNum, sizeof(HWND));
+    me->segmentNum = segmentNum;
+    me->hBitmap    = (HBITMAP *)calloc(bitmapNum, sizeof(HBITMAP));
+    me->bitmapNum  = bitmapNum;
+}
+/*..........................................................................*/
+void SegmentDisplay_xtor(SegmentDisplay * const me) {
+    UINT n;
+
+    free(me->hSegment); /* the segments are owned by the dialog */
+
+    for (n = 0U; n < me->bitmapNum; ++n) {
+        DeleteObject(me->hBitmap[n]);
+    }
+    free(me->hBitmap);
+}
+/*..........................................................................*/
+BOOL SegmentDisplay_initSegment(SegmentDisplay * const me,
+                                UINT segmentNum, UINT segmentID)
+{
+    if (segmentNum < me->segmentNum) {
+        me->hSegment[segmentNum] = GetDlgItem(l_hWnd, (int)segmentID);
+        return me->hSegment[segmentNum] != (HWND)0;
+    }
+    else {
+        return FALSE;
+    }
+}
+/*..........................................................................*/
+BOOL SegmentDisplay_initBitmap(SegmentDisplay * const me,
+                               UINT bitmapNum, HBITMAP hBitmap)
+{
+    if ((bitmapNum < me->bitmapNum) && (hBitmap != (HBITMAP)0)) {
+        me->hBitmap[bitmapNum] = hBitmap;
+        return TRUE;
+    }
+    else {
+        return FALSE;
+    }
+}
+/*..........................................................................*/
+BOOL SegmentDisplay_setSegment(SegmentDisplay * const me,
+                               UINT segmentNum, UINT bitmapNum)
+{
+    if ((segmentNum < me->segmentNum) && (bitmapNum < me->bitmapNum)) {
+        DrawBitmap(me->hSegment[segmentNum], me->hBitmap[bitmapNum], 0, 0);
+        return TRUE;
+    }
+    else {
+        return FALSE;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/* draw the bitmap into the window hdc (clipped to the window) */
+void DrawBitmap(HDC hdc, HBITMAP hBitmap,
+                int xStart, int yStart)
+{
+    int x0, x1, y0, y1, y;
+
+    if ((hdc == (HDC)0) || (hBitmap == (HBITMAP)0)) {
+        return;
+    }
+    x0 = (xStart < 0) ? 0 : xStart;
+    y0 = (yStart < 0) ? 0 : yStart;
+    x1 = xStart + hBitmap->width;
+    y1 = yStart + hBitmap->height;
+    if (x1 > hdc->width) {
+        x1 = hdc->width;
+    }
+    if (y1 > hdc->height) {
+        y1 = hdc->height;
+    }
+    if ((hdc->x + x1) > l_dlg.width) {
+        x1 = l_dlg.width - hdc->x;
+    }
+    if ((hdc->y + y1) > l_dlg.height) {
+        y1 = l_dlg.height - hdc->y;
+    }
+    for (y = y0; y < y1; ++y) {
+        int const sy = hBitmap->height - 1 - (y - yStart); /* bottom-up */
+        if (x1 > x0) {
+            memcpy(&l_frame[(((size_t)(hdc->y + y) * (size_t)l_dlg.width)
+                             + (size_t)(hdc->x + x0)) * 3U],
+                   &hBitmap->bits[(((size_t)sy * (size_t)hBitmap->width)
+                                   + (size_t)(x0 - xStart)) * 3U],
+                   (size_t)(x1 - x0) * 3U);
+        }
+    }
+    if ((x1 > x0) && (y1 > y0)) {
+        invalidateFrame(hdc->x + x0, hdc->y + y0, hdc->x + x1, hdc->y + y1);
+    }
+}
+
+#ifdef QWIN_X11
+/*--------------------------------------------------------------------------*/
+static void presentFrame(void) {
+    RECT const r = l_frameDirty;
+    int x, y;
+    UINT n;
+
+    if ((r.left >= r.right) || (r.top >= r.bottom)) {
+        return; /* nothing changed since the last presentation */
+    }
+    for (y = (int)r.top; y < (int)r.bottom; ++y) {
+        uint32_t *dst = (uint32_t *)&l_image->data[
+                            ((size_t)y * (size_t)l_dlg.width + (size_t)r.left)
+                            * 4U];
+        BYTE const *src = &l_frame[((size_t)y * (size_t)l_dlg.width
+                                    + (size_t)r.left) * 3U];
+        for (x = (int)r.left; x < (int)r.right; ++x, src += 3, ++dst) {
+            *dst = ((uint32_t)src[0] << 16) | ((uint32_t)src[1] << 8)
+                   | (uint32_t)src[2];
+        }
+    }
+    XPutImage(l_display, l_window, l_gc, l_image,
+              (int)r.left, (int)r.top, (int)r.left, (int)r.top,
+              (unsigned)(r.right - r.left), (unsigned)(r.bottom - r.top));
+    for (n = 0U; n < l_nItems; ++n) { /* the texts go over the image */
+        if (l_items[n].text[0] != '\0') {
+            XDrawString(l_display, l_window, l_gc,
+                        l_items[n].x, l_items[n].y + l_items[n].height,
+                        l_items[n].text, (int)strlen(l_items[n].text));
+        }
+    }
+    XFlush(l_display);
+
+    l_frameDirty.left   = l_dlg.width; /* nothing dirty */
+    l_frameDirty.top    = l_dlg.height;
+    l_frameDirty.right  = 0;
+    l_frameDirty.bottom = 0;
+}
+/*..........................................................................*/
+static HWND itemAt(int x, int y) {
+    UINT n;
+    for (n = 0U; n < l_nItems; ++n) {
+        if ((l_items[n].kind == QWIN_OWNERDRAW)
+            && (x >= l_items[n].x) && (x < l_items[n].x + l_items[n].width)
+            && (y >= l_items[n].y) && (y < l_items[n].y + l_items[n].height))
+        {
+            return &l_items[n];
+        }
+    }
+    return (HWND)0;
+}
+/*..........................................................................*/
+static void handleEvent(XEvent const *ev) {
+    switch (ev->type) {
+        case Expose: {
+            invalidateFrame(ev->xexpose.x, ev->xexpose.y,
+                            ev->xexpose.x + ev->xexpose.width,
+                            ev->xexpose.y + ev->xexpose.height);
+            break;
+        }
+        case KeyPress: {
+            KeySym sym = XLookupKeysym((XKeyEvent *)&ev->xkey, 0);
+            if (sym == XK_Escape) {
+                SendMessage(l_hWnd, WM_COMMAND, (WPARAM)IDCANCEL, (LPARAM)0);
+            }
+            else if (sym == XK_Return) {
+                SendMessage(l_hWnd, WM_KEYDOWN, (WPARAM)VK_RETURN, (LPARAM)0);
+            }
+            else if ((sym >= XK_space) && (sym <= XK_asciitilde)) {
+                /* Win32 virtual-key codes of letters are upper case */
+                WPARAM vk = (WPARAM)sym;
+                if ((vk >= 'a') && (vk <= 'z')) {
+                    vk -= 'a' - 'A';
+                }
+                SendMessage(l_hWnd, WM_KEYDOWN, vk, (LPARAM)0);
+            }
+            break;
+        }
+        case ButtonPress: {
+            if (ev->xbutton.button == Button1) {
+                l_pressedItem = itemAt(ev->xbutton.x, ev->xbutton.y);
+                if (l_pressedItem != (HWND)0) {
+                    drawItemMsg(l_pressedItem, ODA_SELECT, ODS_SELECTED);
+                }
+            }
+            else if ((ev->xbutton.button == Button4)    /* wheel forward */
+                     || (ev->xbutton.button == Button5)) /* backward */
+            {
+                int const delta = (ev->xbutton.button == Button4)
+                                  ? WHEEL_DELTA : -WHEEL_DELTA;
+                SendMessage(l_hWnd, WM_MOUSEWHEEL,
+                            (WPARAM)(((unsigned)delta & 0xFFFFU) << 16),
+                            (LPARAM)0);
+            }
+            break;
+        }
+        case ButtonRelease: {
+            if ((ev->xbutton.button == Button1)
+                && (l_pressedItem != (HWND)0))
+            {
+                HWND hItem = l_pressedItem;
+                l_pressedItem = (HWND)0;
+                drawItemMsg(hItem, ODA_SELECT, 0U);
+                SendMessage(l_hWnd, WM_COMMAND, (WPARAM)hItem->id,
+                            (LPARAM)0);
+                drawItemMsg(hItem, ODA_DRAWENTIRE, 0U);
+            }
+            break;
+        }
+        case ClientMessage: {
+            if ((Atom)ev->xclient.data.l[0] == l_wmDelete) {
+                SendMessage(l_hWnd, WM_DESTROY, (WPARAM)0, (LPARAM)0);
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+#endif /* QWIN_X11 */
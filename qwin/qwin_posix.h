@@ -0,0 +1,174 @@
+/**
+* @file
+* @brief Subset of the Win32 API used by QWIN, for the POSIX hosts
+* @cond
+******************************************************************************
+* Last updated for version 6.9.3
+* Last updated on  2021-03-03
+*
+*                    Q u a n t u m  L e a P s
+*                    ------------------------
+*                    Modern Embedded Software
+*
+* Copyright (C) 2021 Quantum Leaps, LLC. All rights reserved.
+*
+* MIT License:
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* Contact information:
+* <www.state-machine.com>
+* <info@state-machine.com>
+******************************************************************************
+* @endcond
+*/
+#ifndef QWIN_POSIX_H_
+#define QWIN_POSIX_H_
+
+#include <stdint.h>
+
+/* NOTE: the POSIX implementation of QWIN (qwin_gui_posix.c) renders the
+* whole dialog into an offscreen RGB framebuffer, which can be shown in an
+* X11 window (when built with QWIN_X11 defined) and saved to image files.
+* The Win32 types and functions below have the same meaning as in Win32,
+* so that the GUI code of the application (the BSP) ports straightforwardly.
+*/
+
+typedef uint8_t   BYTE;
+typedef unsigned  UINT;
+typedef int       BOOL;
+typedef long      LONG;
+typedef char const *LPCTSTR;
+typedef char     *LPSTR;
+typedef intptr_t  LRESULT;
+typedef uintptr_t WPARAM;
+typedef intptr_t  LPARAM;
+
+#ifndef TRUE
+#define TRUE  1
+#define FALSE 0
+#endif
+
+typedef struct QWinWnd    *HWND;    /* the dialog or a dialog control */
+typedef struct QWinWnd    *HDC;     /* drawing goes directly to a window */
+typedef struct QWinBitmap *HBITMAP; /* bottom-up RGB bitmap */
+typedef void const        *HCURSOR; /* cursors are not supported */
+typedef struct QWinDlgTemplate const *HINSTANCE; /* dialog to create */
+
+#define CALLBACK
+#define WINAPI
+typedef LRESULT (*WNDPROC)(HWND hWnd, UINT iMsg,
+                           WPARAM wParam, LPARAM lParam);
+
+/* the dialog layout (replaces the DIALOG resource of Win32) ...............*/
+enum QWinItemKind {
+    QWIN_STATIC,    /* static control, possibly with a bitmap (SS_BITMAP) */
+    QWIN_TEXT,      /* static text (LTEXT/CTEXT) */
+    QWIN_OWNERDRAW  /* owner-drawn button (BS_OWNERDRAW) */
+};
+
+typedef struct {
+    int         id;       /* control ID */
+    int         kind;     /* enum QWinItemKind */
+    int         x;        /* position and size in pixels... */
+    int         y;
+    int         width;
+    int         height;
+    char const *bitmap;   /* .bmp file shown in the control (or NULL) */
+    char const *text;     /* text of the control (or NULL) */
+} QWinItemTemplate;
+
+typedef struct QWinDlgTemplate {
+    char const *caption;  /* window caption */
+    int         width;    /* client area size in pixels... */
+    int         height;
+    BYTE        bgColor[3];
+    QWinItemTemplate const *items;
+    UINT        nItems;
+} QWinDlgTemplate;
+
+/* dialog box units of the "MS Shell Dlg" 8pt font to pixels */
+#define DLG_X(x_)  (((x_) * 3) / 2)
+#define DLG_Y(y_)  (((y_) * 13) / 8)
+
+typedef struct {
+    LONG left;
+    LONG top;
+    LONG right;
+    LONG bottom;
+} RECT;
+
+typedef struct {
+    UINT CtlType;
+    UINT CtlID;
+    UINT itemID;
+    UINT itemAction;
+    UINT itemState;
+    HWND hwndItem;
+    HDC  hDC;
+    RECT rcItem;
+} DRAWITEMSTRUCT, *LPDRAWITEMSTRUCT;
+
+/* window messages and their parameters */
+#define WM_CREATE       0x0001U
+#define WM_DESTROY      0x0002U
+#define WM_KEYDOWN      0x0100U
+#define WM_INITDIALOG   0x0110U
+#define WM_COMMAND      0x0111U
+#define WM_DRAWITEM     0x002BU
+#define WM_MOUSEWHEEL   0x020AU
+
+#define ODA_DRAWENTIRE  0x0001U
+#define ODA_SELECT      0x0002U
+#define ODS_SELECTED    0x0001U
+#define ODT_BUTTON      4U
+
+#define IDC_STATIC      (-1)
+#define IDOK            1
+#define IDCANCEL        2
+#define VK_RETURN       0x0DU
+#define VK_ESCAPE       0x1BU
+#define VK_SPACE        0x20U
+#define WHEEL_DELTA     120
+#define SW_SHOW         5
+
+#define LOWORD(l_)      ((UINT)((uintptr_t)(l_) & 0xFFFFU))
+#define HIWORD(l_)      ((UINT)(((uintptr_t)(l_) >> 16) & 0xFFFFU))
+
+/* Win32 functions provided by qwin_gui_posix.c */
+HWND GetDlgItem(HWND hDlg, int id);
+BOOL SetDlgItemText(HWND hDlg, int id, LPCTSTR text);
+LRESULT SendMessage(HWND hWnd, UINT iMsg, WPARAM wParam, LPARAM lParam);
+BOOL ShowWindow(HWND hWnd, int iCmdShow);
+void PostQuitMessage(int exitCode);
+BOOL DeleteObject(HBITMAP hBitmap);
+
+/* POSIX-specific extensions ...............................................*/
+/* load a bitmap from an uncompressed 24- or 32-bit .bmp file */
+HBITMAP LoadBitmapFile(char const *fileName);
+
+/* show the changes in the window and deliver the pending input events
+* to the dialog procedure. Returns FALSE after PostQuitMessage().
+*/
+BOOL DispatchMessages(void);
+
+/* save the current contents of the dialog as a binary PPM (P6) image */
+BOOL SaveFrame(char const *fileName);
+
+#endif /* QWIN_POSIX_H_ */